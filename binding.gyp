@@ -26,7 +26,17 @@
         'deps/zxing/core/src',
       ],
       'sources': [
+        'src/batch.cc',
+        'src/edges.cc',
+        'src/fingerprint.cc',
         'src/image.cc',
+        'src/imagestore.cc',
+        'src/memory.cc',
+        'src/ocrcache.cc',
+        'src/parallel.cc',
+        'src/pipeline.cc',
+        'src/rotation.cc',
+        'src/tiling.cc',
         'src/tesseract.cc',
         'src/util.cc',
         'src/zxing.cc',
@@ -35,6 +45,11 @@
       'cflags!': ['-fno-exceptions'],
       'cflags_cc!': ['-fno-exceptions'],
       'conditions': [
+        ['OS=="linux"',
+          {
+            'libraries': ['-lrt'],
+          }
+        ],
         ['OS=="mac"',
           {
             'xcode_settings': {
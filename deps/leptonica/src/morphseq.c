@@ -39,6 +39,11 @@
  *      Run a sequence of binary composite dwa morphological operations
  *            PIX     *pixMorphCompSequenceDwa()
  *
+ *      Static helpers for composite dwa sequences
+ *            static l_int32  pixCompBrickDwaBordered()
+ *            static void     pixRunCompBrickDwaPasses()
+ *            static void     swapPix()
+ *
  *      Parser verifier for binary morphological operations
  *            l_int32  morphSequenceVerify()
  *
@@ -52,6 +57,19 @@
 #include <string.h>
 #include "allheaders.h"
 
+    /* Border used by the composite dwa brick operations */
+static const l_int32  DWA_BORDER = 64;
+
+static l_int32 pixCompBrickDwaBordered(PIX **ppixb1, PIX **ppixb2,
+                                       l_int32 type, l_int32 hsize,
+                                       l_int32 vsize);
+static void pixRunCompBrickDwaPasses(PIX **ppixb1, PIX **ppixb2,
+                                     l_int32 operation, l_int32 hsize2,
+                                     l_int32 vsize2, char *selnameh1,
+                                     char *selnameh2, char *selnamev1,
+                                     char *selnamev2);
+static void swapPix(PIX **ppix1, PIX **ppix2);
+
 /*-------------------------------------------------------------------------*
  *         Run a sequence of binary rasterop morphological operations      *
  *-------------------------------------------------------------------------*/
@@ -595,9 +613,9 @@ pixMorphCompSequenceDwa(PIX         *pixs,
 {
 char    *rawop, *op, *fname;
 char     buf[256];
-l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout;
+l_int32  nops, i, j, nred, fact, w, h, x, y, border, pdfout, type;
 l_int32  level[4];
-PIX     *pixt1, *pixt2;
+PIX     *pixt1, *pixt2, *pixb1, *pixb2;
 PIXA    *pixa;
 SARRAY  *sa;
 
@@ -619,7 +637,11 @@ SARRAY  *sa;
         return (PIX *)ERROR_PTR("sequence not valid", procName, NULL);
     }
 
-        /* Parse and operate */
+        /* Parse and operate.  Consecutive brick operations are run on
+         * a bordered image in pixb1, ping-ponging with pixb2, so that
+         * the border is added and removed only once for the whole run
+         * and no image is allocated for each pass.  While pixb1 is
+         * defined, it holds the current result instead of pixt1. */
     pixa = NULL;
     if (pdfout) {
         pixa = pixaCreate(0);
@@ -630,70 +652,116 @@ SARRAY  *sa;
     border = 0;
     pixt1 = pixCopy(NULL, pixs);
     pixt2 = NULL;
+    pixb1 = pixb2 = NULL;
     x = y = 0;
     for (i = 0; i < nops; i++) {
         rawop = sarrayGetString(sa, i, 0);
         op = stringRemoveChars(rawop, " \n\t");
+        type = 0;
         switch (op[0])
         {
         case 'd':
         case 'D':
-            sscanf(&op[1], "%d.%d", &w, &h);
-            pixt2 = pixDilateCompBrickDwa(NULL, pixt1, w, h);
-            pixSwapAndDestroy(&pixt1, &pixt2);
+            type = L_MORPH_DILATE;
             break;
         case 'e':
         case 'E':
-            sscanf(&op[1], "%d.%d", &w, &h);
-            pixt2 = pixErodeCompBrickDwa(NULL, pixt1, w, h);
-            pixSwapAndDestroy(&pixt1, &pixt2);
+            type = L_MORPH_ERODE;
             break;
         case 'o':
         case 'O':
-            sscanf(&op[1], "%d.%d", &w, &h);
-            pixOpenCompBrickDwa(pixt1, pixt1, w, h);
+            type = L_MORPH_OPEN;
             break;
         case 'c':
         case 'C':
-            sscanf(&op[1], "%d.%d", &w, &h);
-            pixCloseCompBrickDwa(pixt1, pixt1, w, h);
-            break;
-        case 'r':
-        case 'R':
-            nred = strlen(op) - 1;
-            for (j = 0; j < nred; j++)
-                level[j] = op[j + 1] - '0';
-            for (j = nred; j < 4; j++)
-                level[j] = 0;
-            pixt2 = pixReduceRankBinaryCascade(pixt1, level[0], level[1],
-                                               level[2], level[3]);
-            pixSwapAndDestroy(&pixt1, &pixt2);
-            break;
-        case 'x':
-        case 'X':
-            sscanf(&op[1], "%d", &fact);
-            pixt2 = pixExpandReplicate(pixt1, fact);
-            pixSwapAndDestroy(&pixt1, &pixt2);
-            break;
-        case 'b':
-        case 'B':
-            sscanf(&op[1], "%d", &border);
-            pixt2 = pixAddBorder(pixt1, border, 0);
-            pixSwapAndDestroy(&pixt1, &pixt2);
+            type = L_MORPH_CLOSE;
             break;
         default:
-            /* All invalid ops are caught in the first pass */
             break;
         }
+        if (type) {
+            sscanf(&op[1], "%d.%d", &w, &h);
+            if (w > 63 || h > 63) {  /* extended ops; use the plain image */
+                if (pixb1) {
+                    pixDestroy(&pixt1);
+                    pixt1 = pixRemoveBorder(pixb1, DWA_BORDER);
+                    pixDestroy(&pixb1);
+                    pixDestroy(&pixb2);
+                }
+                if (type == L_MORPH_DILATE) {
+                    pixt2 = pixDilateCompBrickDwa(NULL, pixt1, w, h);
+                    pixSwapAndDestroy(&pixt1, &pixt2);
+                } else if (type == L_MORPH_ERODE) {
+                    pixt2 = pixErodeCompBrickDwa(NULL, pixt1, w, h);
+                    pixSwapAndDestroy(&pixt1, &pixt2);
+                } else if (type == L_MORPH_OPEN) {
+                    pixOpenCompBrickDwa(pixt1, pixt1, w, h);
+                } else {
+                    pixCloseCompBrickDwa(pixt1, pixt1, w, h);
+                }
+            } else if (w > 1 || h > 1) {
+                if (!pixb1)
+                    pixb1 = pixAddBorder(pixt1, DWA_BORDER, 0);
+                pixCompBrickDwaBordered(&pixb1, &pixb2, type, w, h);
+            }
+        } else {
+            if (pixb1) {
+                pixDestroy(&pixt1);
+                pixt1 = pixRemoveBorder(pixb1, DWA_BORDER);
+                pixDestroy(&pixb1);
+                pixDestroy(&pixb2);
+            }
+            switch (op[0])
+            {
+            case 'r':
+            case 'R':
+                nred = strlen(op) - 1;
+                for (j = 0; j < nred; j++)
+                    level[j] = op[j + 1] - '0';
+                for (j = nred; j < 4; j++)
+                    level[j] = 0;
+                pixt2 = pixReduceRankBinaryCascade(pixt1, level[0], level[1],
+                                                   level[2], level[3]);
+                pixSwapAndDestroy(&pixt1, &pixt2);
+                break;
+            case 'x':
+            case 'X':
+                sscanf(&op[1], "%d", &fact);
+                pixt2 = pixExpandReplicate(pixt1, fact);
+                pixSwapAndDestroy(&pixt1, &pixt2);
+                break;
+            case 'b':
+            case 'B':
+                sscanf(&op[1], "%d", &border);
+                pixt2 = pixAddBorder(pixt1, border, 0);
+                pixSwapAndDestroy(&pixt1, &pixt2);
+                break;
+            default:
+                /* All invalid ops are caught in the first pass */
+                break;
+            }
+        }
         FREE(op);
 
             /* Debug output */
-        if (dispsep > 0) {
-            pixDisplay(pixt1, x, y);
-            x += dispsep;
+        if (dispsep > 0 || pdfout) {
+            if (pixb1) {
+                pixDestroy(&pixt1);
+                pixt1 = pixRemoveBorder(pixb1, DWA_BORDER);
+            }
+            if (dispsep > 0) {
+                pixDisplay(pixt1, x, y);
+                x += dispsep;
+            }
+            if (pdfout)
+                pixaAddPix(pixa, pixt1, L_COPY);
         }
-        if (pdfout)
-            pixaAddPix(pixa, pixt1, L_COPY);
+    }
+    if (pixb1) {
+        pixDestroy(&pixt1);
+        pixt1 = pixRemoveBorder(pixb1, DWA_BORDER);
+        pixDestroy(&pixb1);
+        pixDestroy(&pixb2);
     }
     if (border > 0) {
         pixt2 = pixRemoveBorder(pixt1, border);
@@ -711,6 +779,161 @@ SARRAY  *sa;
 }
 
 
+/*-------------------------------------------------------------------------*
+ *               Static helpers for composite dwa sequences                *
+ *-------------------------------------------------------------------------*/
+/*!
+ *  pixCompBrickDwaBordered()
+ *
+ *      Input:  &pixb1 (<in/out> 1 bpp image with a border of DWA_BORDER
+ *                      pixels; holds the result on return)
+ *              &pixb2 (<in/out> scratch image of the same size;
+ *                      created if null)
+ *              type (L_MORPH_DILATE, L_MORPH_ERODE, L_MORPH_OPEN,
+ *                    L_MORPH_CLOSE)
+ *              hsize (width of brick Sel; <= 63)
+ *              vsize (height of brick Sel; <= 63)
+ *      Return: 0 if OK, 1 on error
+ *
+ *  Notes:
+ *      (1) This runs the same passes as pixDilateCompBrickDwa() and
+ *          its siblings, but on an image that already has the border.
+ *          Resetting the border to the color those functions add
+ *          makes the result identical to removing and adding it again.
+ *      (2) The passes alternate between the two images, so nothing
+ *          is allocated once pixb2 exists.
+ */
+static l_int32
+pixCompBrickDwaBordered(PIX     **ppixb1,
+                        PIX     **ppixb2,
+                        l_int32   type,
+                        l_int32   hsize,
+                        l_int32   vsize)
+{
+char    *selnameh1, *selnameh2, *selnamev1, *selnamev2;
+l_int32  hsize1, hsize2, vsize1, vsize2, bordercolor, initcolor;
+
+    PROCNAME("pixCompBrickDwaBordered");
+
+    if (!ppixb1 || !*ppixb1 || !ppixb2)
+        return ERROR_INT("pixb1 and &pixb2 not both defined", procName, 1);
+    if (!*ppixb2 && (*ppixb2 = pixCreateTemplate(*ppixb1)) == NULL)
+        return ERROR_INT("pixb2 not made", procName, 1);
+
+    hsize1 = hsize2 = vsize1 = vsize2 = 1;
+    selnameh1 = selnameh2 = selnamev1 = selnamev2 = NULL;
+    if (hsize > 1)
+        getCompositeParameters(hsize, &hsize1, &hsize2, &selnameh1,
+                               &selnameh2, NULL, NULL);
+    if (vsize > 1)
+        getCompositeParameters(vsize, &vsize1, &vsize2, NULL, NULL,
+                               &selnamev1, &selnamev2);
+
+        /* For symmetric b.c., erosions start with a set border */
+    bordercolor = getMorphBorderPixelColor(L_MORPH_ERODE, 1);
+    if (type == L_MORPH_ERODE || type == L_MORPH_OPEN)
+        initcolor = bordercolor;
+    else
+        initcolor = 0;
+    pixSetOrClearBorder(*ppixb1, DWA_BORDER, DWA_BORDER, DWA_BORDER,
+                        DWA_BORDER, initcolor ? PIX_SET : PIX_CLR);
+
+    if (type == L_MORPH_DILATE || type == L_MORPH_ERODE) {
+        pixRunCompBrickDwaPasses(ppixb1, ppixb2, type, hsize2, vsize2,
+                                 selnameh1, selnameh2, selnamev1, selnamev2);
+    } else if (type == L_MORPH_CLOSE &&
+               ((vsize == 1 && hsize2 == 1) || (hsize == 1 && vsize2 == 1))) {
+            /* A single linear Sel is closed in one pass */
+        pixFMorphopGen_1(*ppixb2, *ppixb1, L_MORPH_CLOSE,
+                         (vsize == 1) ? selnameh1 : selnamev1);
+        swapPix(ppixb1, ppixb2);
+    } else if (type == L_MORPH_OPEN) {
+        pixRunCompBrickDwaPasses(ppixb1, ppixb2, L_MORPH_ERODE, hsize2, vsize2,
+                                 selnameh1, selnameh2, selnamev1, selnamev2);
+        if (bordercolor == 1)
+            pixSetOrClearBorder(*ppixb1, DWA_BORDER, DWA_BORDER, DWA_BORDER,
+                                DWA_BORDER, PIX_CLR);
+        pixRunCompBrickDwaPasses(ppixb1, ppixb2, L_MORPH_DILATE, hsize2,
+                                 vsize2, selnameh1, selnameh2, selnamev1,
+                                 selnamev2);
+    } else {  /* L_MORPH_CLOSE */
+        pixRunCompBrickDwaPasses(ppixb1, ppixb2, L_MORPH_DILATE, hsize2,
+                                 vsize2, selnameh1, selnameh2, selnamev1,
+                                 selnamev2);
+        if (bordercolor == 1)
+            pixSetOrClearBorder(*ppixb1, DWA_BORDER, DWA_BORDER, DWA_BORDER,
+                                DWA_BORDER, PIX_SET);
+        pixRunCompBrickDwaPasses(ppixb1, ppixb2, L_MORPH_ERODE, hsize2, vsize2,
+                                 selnameh1, selnameh2, selnamev1, selnamev2);
+    }
+
+    if (selnameh1) FREE(selnameh1);
+    if (selnameh2) FREE(selnameh2);
+    if (selnamev1) FREE(selnamev1);
+    if (selnamev2) FREE(selnamev2);
+    return 0;
+}
+
+
+/*!
+ *  pixRunCompBrickDwaPasses()
+ *
+ *      Input:  &pixb1, &pixb2 (bordered source and scratch images;
+ *                              swapped after each pass)
+ *              operation (L_MORPH_DILATE or L_MORPH_ERODE)
+ *              hsize2, vsize2 (comb factors from getCompositeParameters())
+ *              selnameh1, selnameh2, selnamev1, selnamev2 (<optional>;
+ *                   null for a direction that is not used)
+ *      Return: void
+ *
+ *  Notes:
+ *      (1) The horizontal passes are done before the vertical ones;
+ *          each direction is a brick followed by an optional comb.
+ */
+static void
+pixRunCompBrickDwaPasses(PIX     **ppixb1,
+                         PIX     **ppixb2,
+                         l_int32   operation,
+                         l_int32   hsize2,
+                         l_int32   vsize2,
+                         char     *selnameh1,
+                         char     *selnameh2,
+                         char     *selnamev1,
+                         char     *selnamev2)
+{
+    if (selnameh1) {
+        pixFMorphopGen_1(*ppixb2, *ppixb1, operation, selnameh1);
+        swapPix(ppixb1, ppixb2);
+        if (hsize2 > 1) {
+            pixFMorphopGen_2(*ppixb2, *ppixb1, operation, selnameh2);
+            swapPix(ppixb1, ppixb2);
+        }
+    }
+    if (selnamev1) {
+        pixFMorphopGen_1(*ppixb2, *ppixb1, operation, selnamev1);
+        swapPix(ppixb1, ppixb2);
+        if (vsize2 > 1) {
+            pixFMorphopGen_2(*ppixb2, *ppixb1, operation, selnamev2);
+            swapPix(ppixb1, ppixb2);
+        }
+    }
+    return;
+}
+
+
+static void
+swapPix(PIX  **ppix1,
+        PIX  **ppix2)
+{
+PIX  *pixt;
+
+    pixt = *ppix1;
+    *ppix1 = *ppix2;
+    *ppix2 = pixt;
+    return;
+}
+
+
 /*-------------------------------------------------------------------------*
  *            Parser verifier for binary morphological operations          *
  *-------------------------------------------------------------------------*/
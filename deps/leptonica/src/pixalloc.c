@@ -36,6 +36,8 @@
  *          void         *pmsGetAlloc()
  *          l_int32       pmsGetLevelForAlloc()
  *          l_int32       pmsGetLevelForDealloc()
+ *          l_int32       pmsGetInfo()
+ *          l_int32       pmsGetLevelInfo()
  *          void          pmsLogInfo()
  */
 
@@ -122,10 +124,10 @@ struct PixMemoryStore
     l_uint32        *baseptr;      /* ptr to allocated array                */
     l_uint32        *maxptr;       /* ptr just beyond allocated memory      */
     l_uint32       **firstptr;     /* array of ptrs to first chunk in size  */
-    l_int32         *memused;      /* log: total # of pix used (by level)   */
-    l_int32         *meminuse;     /* log: # of pix in use (by level)       */
-    l_int32         *memmax;       /* log: max # of pix in use (by level)   */
-    l_int32         *memempty;     /* log: # of pix alloc'd because         */
+    l_int32         *memused;      /* total # of pix used (by level)        */
+    l_int32         *meminuse;     /* # of pix in use (by level)            */
+    l_int32         *memmax;       /* max # of pix in use (by level)        */
+    l_int32         *memempty;     /* # of pix alloc'd because              */
                                    /*      the store was empty (by level)   */
     char            *logfile;      /* log: set to null if no logging        */
 };
@@ -166,8 +168,9 @@ pmsCreate(size_t       minsize,
           NUMA        *numalloc,
           const char  *logfile)
 {
-l_int32           nlevels, i, j, nbytes;
+l_int32           nlevels, i, j;
 l_int32          *alloca;
+size_t            nbytes;
 l_float32         nchunks;
 l_uint32         *baseptr, *data;
 l_uint32        **firstptr;
@@ -235,13 +238,14 @@ L_PTRAA          *paa;
         }
     }
 
-    if (logfile) {
-        pms->memused = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
-        pms->meminuse = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
-        pms->memmax = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
-        pms->memempty = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
+        /* The usage counters are always kept; they are cheap and
+         * are needed by pmsGetLevelInfo() */
+    pms->memused = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
+    pms->meminuse = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
+    pms->memmax = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
+    pms->memempty = (l_int32 *)CALLOC(nlevels, sizeof(l_int32));
+    if (logfile)
         pms->logfile = stringNew(logfile);
-    }
 
     return 0;
 }
@@ -271,11 +275,11 @@ L_PIX_MEM_STORE  *pms;
     if (pms->logfile) {
         pmsLogInfo();
         FREE(pms->logfile);
-        FREE(pms->memused);
-        FREE(pms->meminuse);
-        FREE(pms->memmax);
-        FREE(pms->memempty);
     }
+    FREE(pms->memused);
+    FREE(pms->meminuse);
+    FREE(pms->memmax);
+    FREE(pms->memempty);
 
     FREE(pms->sizes);
     FREE(pms->allocarray);
@@ -321,7 +325,7 @@ L_PTRA           *pa;
     else {  /* get from store */
         pa = ptraaGetPtra(pms->paa, level, L_HANDLE_ONLY);
         data = ptraRemoveLast(pa);
-        if (data && pms->logfile) {
+        if (data) {
             pms->memused[level]++;
             pms->meminuse[level]++;
             if (pms->meminuse[level] > pms->memmax[level])
@@ -329,8 +333,7 @@ L_PTRA           *pa;
         }
         if (!data) {  /* none left at this level */
             data = pmsGetAlloc(nbytes);
-            if (pms->logfile)
-                pms->memempty[level]++;
+            pms->memempty[level]++;
         }
     }
 
@@ -368,8 +371,7 @@ L_PTRA           *pa;
     else {  /* return the data to the store */
         pa = ptraaGetPtra(pms->paa, level, L_HANDLE_ONLY);
         ptraAdd(pa, data);
-        if (pms->logfile)
-            pms->meminuse[level]--;
+        pms->meminuse[level]--;
     }
 
     return;
@@ -491,6 +493,84 @@ L_PIX_MEM_STORE  *pms;
 }
 
 
+/*!
+ *  pmsGetInfo()
+ *
+ *      Input:  &nlevels (<optional return> number of chunk sizes)
+ *              &minsize (<optional return> smallest request that is
+ *                        served from the store)
+ *              &nbytes (<optional return> size of the memory store)
+ *              &ninuse (<optional return> number of chunks that are
+ *                       currently lent out, over all levels)
+ *      Return: 0 if OK, 1 if the store is not defined
+ */
+l_int32
+pmsGetInfo(l_int32  *pnlevels,
+           size_t   *pminsize,
+           size_t   *pnbytes,
+           l_int32  *pninuse)
+{
+l_int32           i, ninuse;
+L_PIX_MEM_STORE  *pms;
+
+    if (pnlevels) *pnlevels = 0;
+    if (pminsize) *pminsize = 0;
+    if (pnbytes) *pnbytes = 0;
+    if (pninuse) *pninuse = 0;
+    if ((pms = CustomPMS) == NULL)
+        return 1;
+
+    for (i = 0, ninuse = 0; i < pms->nlevels; i++)
+        ninuse += pms->meminuse[i];
+    if (pnlevels) *pnlevels = pms->nlevels;
+    if (pminsize) *pminsize = pms->minsize;
+    if (pnbytes) *pnbytes = pms->nbytes;
+    if (pninuse) *pninuse = ninuse;
+    return 0;
+}
+
+
+/*!
+ *  pmsGetLevelInfo()
+ *
+ *      Input:  level
+ *              &size (<optional return> chunk size at this level)
+ *              &nalloc (<optional return> number of chunks in the store)
+ *              &nused (<optional return> total number of chunks lent out)
+ *              &ninuse (<optional return> number of chunks lent out now)
+ *              &nmax (<optional return> max number lent out at once)
+ *              &nempty (<optional return> number of requests that were
+ *                       allocated dynamically because the level was empty)
+ *      Return: 0 if OK, 1 on error
+ */
+l_int32
+pmsGetLevelInfo(l_int32   level,
+                size_t   *psize,
+                l_int32  *pnalloc,
+                l_int32  *pnused,
+                l_int32  *pninuse,
+                l_int32  *pnmax,
+                l_int32  *pnempty)
+{
+L_PIX_MEM_STORE  *pms;
+
+    PROCNAME("pmsGetLevelInfo");
+
+    if ((pms = CustomPMS) == NULL)
+        return ERROR_INT("pms not defined", procName, 1);
+    if (level < 0 || level >= pms->nlevels)
+        return ERROR_INT("invalid level", procName, 1);
+
+    if (psize) *psize = pms->sizes[level];
+    if (pnalloc) *pnalloc = pms->allocarray[level];
+    if (pnused) *pnused = pms->memused[level];
+    if (pninuse) *pninuse = pms->meminuse[level];
+    if (pnmax) *pnmax = pms->memmax[level];
+    if (pnempty) *pnempty = pms->memempty[level];
+    return 0;
+}
+
+
 /*!
  *  pmsLogInfo()
  *
@@ -111,6 +111,17 @@
 
 extern l_float32  AlphaMaskBorderVals[2];
 
+    /* Shared scale-to-gray lookup tables; see scalelow.c */
+extern const l_uint32  SumTabSG2[256];
+extern const l_uint8   ValTabSG2[5];
+extern const l_uint32  SumTabSG3[64];
+extern const l_uint8   ValTabSG3[10];
+extern const l_uint32  SumTabSG4[256];
+extern const l_uint8   ValTabSG4[17];
+extern const l_uint8   ValTabSG6[37];
+extern const l_uint8   ValTabSG8[65];
+extern const l_int32   PixelSumTabSG[256];
+
 
 /*------------------------------------------------------------------*
  *                    Top level scaling dispatcher                  *
@@ -1703,10 +1714,8 @@ PIX       *pixt, *pixd;
 PIX *
 pixScaleToGray2(PIX  *pixs)
 {
-l_uint8   *valtab;
 l_int32    ws, hs, wd, hd;
 l_int32    wpld, wpls;
-l_uint32  *sumtab;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -1732,15 +1741,7 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((sumtab = makeSumTabSG2()) == NULL)
-        return (PIX *)ERROR_PTR("sumtab not made", procName, NULL);
-    if ((valtab = makeValTabSG2()) == NULL)
-        return (PIX *)ERROR_PTR("valtab not made", procName, NULL);
-
-    scaleToGray2Low(datad, wd, hd, wpld, datas, wpls, sumtab, valtab);
-
-    FREE(sumtab);
-    FREE(valtab);
+    scaleToGray2Low(datad, wd, hd, wpld, datas, wpls, SumTabSG2, ValTabSG2);
     return pixd;
 }
 
@@ -1761,10 +1762,8 @@ PIX       *pixd;
 PIX *
 pixScaleToGray3(PIX  *pixs)
 {
-l_uint8   *valtab;
 l_int32    ws, hs, wd, hd;
 l_int32    wpld, wpls;
-l_uint32  *sumtab;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -1790,15 +1789,7 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((sumtab = makeSumTabSG3()) == NULL)
-        return (PIX *)ERROR_PTR("sumtab not made", procName, NULL);
-    if ((valtab = makeValTabSG3()) == NULL)
-        return (PIX *)ERROR_PTR("valtab not made", procName, NULL);
-
-    scaleToGray3Low(datad, wd, hd, wpld, datas, wpls, sumtab, valtab);
-
-    FREE(sumtab);
-    FREE(valtab);
+    scaleToGray3Low(datad, wd, hd, wpld, datas, wpls, SumTabSG3, ValTabSG3);
     return pixd;
 }
 
@@ -1816,10 +1807,8 @@ PIX       *pixd;
 PIX *
 pixScaleToGray4(PIX  *pixs)
 {
-l_uint8   *valtab;
 l_int32    ws, hs, wd, hd;
 l_int32    wpld, wpls;
-l_uint32  *sumtab;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -1845,15 +1834,7 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((sumtab = makeSumTabSG4()) == NULL)
-        return (PIX *)ERROR_PTR("sumtab not made", procName, NULL);
-    if ((valtab = makeValTabSG4()) == NULL)
-        return (PIX *)ERROR_PTR("valtab not made", procName, NULL);
-
-    scaleToGray4Low(datad, wd, hd, wpld, datas, wpls, sumtab, valtab);
-
-    FREE(sumtab);
-    FREE(valtab);
+    scaleToGray4Low(datad, wd, hd, wpld, datas, wpls, SumTabSG4, ValTabSG4);
     return pixd;
 }
 
@@ -1872,9 +1853,7 @@ PIX       *pixd;
 PIX *
 pixScaleToGray6(PIX  *pixs)
 {
-l_uint8   *valtab;
 l_int32    ws, hs, wd, hd, wpld, wpls;
-l_int32   *tab8;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -1900,15 +1879,8 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((tab8 = makePixelSumTab8()) == NULL)
-        return (PIX *)ERROR_PTR("tab8 not made", procName, NULL);
-    if ((valtab = makeValTabSG6()) == NULL)
-        return (PIX *)ERROR_PTR("valtab not made", procName, NULL);
-
-    scaleToGray6Low(datad, wd, hd, wpld, datas, wpls, tab8, valtab);
-
-    FREE(tab8);
-    FREE(valtab);
+    scaleToGray6Low(datad, wd, hd, wpld, datas, wpls,
+                    PixelSumTabSG, ValTabSG6);
     return pixd;
 }
 
@@ -1923,10 +1895,8 @@ PIX       *pixd;
 PIX *
 pixScaleToGray8(PIX  *pixs)
 {
-l_uint8   *valtab;
 l_int32    ws, hs, wd, hd;
 l_int32    wpld, wpls;
-l_int32   *tab8;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -1952,15 +1922,8 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((tab8 = makePixelSumTab8()) == NULL)
-        return (PIX *)ERROR_PTR("tab8 not made", procName, NULL);
-    if ((valtab = makeValTabSG8()) == NULL)
-        return (PIX *)ERROR_PTR("valtab not made", procName, NULL);
-
-    scaleToGray8Low(datad, wd, hd, wpld, datas, wpls, tab8, valtab);
-
-    FREE(tab8);
-    FREE(valtab);
+    scaleToGray8Low(datad, wd, hd, wpld, datas, wpls,
+                    PixelSumTabSG, ValTabSG8);
     return pixd;
 }
 
@@ -1977,7 +1940,6 @@ pixScaleToGray16(PIX  *pixs)
 {
 l_int32    ws, hs, wd, hd;
 l_int32    wpld, wpls;
-l_int32   *tab8;
 l_uint32  *datas, *datad;
 PIX       *pixd;
 
@@ -2003,12 +1965,7 @@ PIX       *pixd;
     wpls = pixGetWpl(pixs);
     wpld = pixGetWpl(pixd);
 
-    if ((tab8 = makePixelSumTab8()) == NULL)
-        return (PIX *)ERROR_PTR("tab8 not made", procName, NULL);
-
-    scaleToGray16Low(datad, wd, hd, wpld, datas, wpls, tab8);
-
-    FREE(tab8);
+    scaleToGray16Low(datad, wd, hd, wpld, datas, wpls, PixelSumTabSG);
     return pixd;
 }
 
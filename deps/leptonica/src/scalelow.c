@@ -30,9 +30,11 @@
  *
  *         Color (interpolated) scaling: general case
  *                  void       scaleColorLILow()
+ *                  l_int32    scaleColorLIRowsLow()
  *
  *         Grayscale (interpolated) scaling: general case
  *                  void       scaleGrayLILow()
+ *                  l_int32    scaleGrayLIRowsLow()
  *
  *         Color (interpolated) scaling: 2x upscaling
  *                  void       scaleColor2xLILow()
@@ -55,12 +57,19 @@
  *
  *         Color and grayscale downsampling with (antialias) area mapping
  *                  l_int32    scaleColorAreaMapLow()
+ *                  l_int32    scaleColorAreaMapRowsLow()
  *                  l_int32    scaleGrayAreaMapLow()
+ *                  l_int32    scaleGrayAreaMapRowsLow()
  *                  l_int32    scaleAreaMapLow2()
  *
  *         Binary scaling by closest pixel sampling
  *                  l_int32    scaleBinaryLow()
  *
+ *         Scale-to-gray lookup tables
+ *                  const l_uint32  SumTabSG2[], SumTabSG3[], SumTabSG4[]
+ *                  const l_uint8   ValTabSG2[], ..., ValTabSG8[]
+ *                  const l_int32   PixelSumTabSG[]
+ *
  *         Scale-to-gray 2x
  *                  void       scaleToGray2Low()
  *                  l_uint32  *makeSumTabSG2()
@@ -124,16 +133,47 @@ scaleColorLILow(l_uint32  *datad,
                l_int32    ws,
                l_int32    hs,
                l_int32    wpls)
+{
+    scaleColorLIRowsLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 0, hd);
+    return;
+}
+
+
+/*!
+ *  scaleColorLIRowsLow()
+ *
+ *  Notes:
+ *      (1) This computes dest rows [ystart, yend) of scaleColorLILow(),
+ *          so that horizontal strips of the dest can be scaled
+ *          separately; e.g., on different threads.  The result does
+ *          not depend on how the rows are split.
+ *      (2) The src x coordinates of the dest columns are computed once
+ *          for the strip, rather than again for every dest row.
+ */
+l_int32
+scaleColorLIRowsLow(l_uint32  *datad,
+                    l_int32    wd,
+                    l_int32    hd,
+                    l_int32    wpld,
+                    l_uint32  *datas,
+                    l_int32    ws,
+                    l_int32    hs,
+                    l_int32    wpls,
+                    l_int32    ystart,
+                    l_int32    yend)
 {
 l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
+l_int32    ypm;  /* location in src image, to 1/16 of a pixel */
 l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
 l_int32    v00r, v01r, v10r, v11r, v00g, v01g, v10g, v11g;
 l_int32    v00b, v01b, v10b, v11b, area00, area01, area10, area11;
 l_uint32   pixels1, pixels2, pixels3, pixels4, pixel;
 l_uint32  *lines, *lined;
+l_int32   *xpmtab;
 l_float32  scx, scy;
 
+    PROCNAME("scaleColorLIRowsLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -144,17 +184,22 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* Locations of the dest columns in the src, to 1/16 of a pixel */
+    if ((xpmtab = (l_int32 *)CALLOC(wd, sizeof(l_int32))) == NULL)
+        return ERROR_INT("xpmtab not made", procName, 1);
+    for (j = 0; j < wd; j++)
+        xpmtab[j] = (l_int32)(scx * (l_float32)j);
+
         /* Iterate over the destination pixels */
-    for (i = 0; i < hd; i++) {
+    for (i = ystart; i < yend; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
         lined = datad + i * wpld;
         lines = datas + yp * wpls;
         for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
+            xp = xpmtab[j] >> 4;
+            xf = xpmtab[j] & 0x0f;
 
                 /* Do bilinear interpolation.  This is a simple
                  * generalization of the calculation in scaleGrayLILow().
@@ -207,7 +252,8 @@ l_float32  scx, scy;
         }
     }
 
-    return;
+    FREE(xpmtab);
+    return 0;
 }
 
 
@@ -232,15 +278,46 @@ scaleGrayLILow(l_uint32  *datad,
                l_int32    ws,
                l_int32    hs,
                l_int32    wpls)
+{
+    scaleGrayLIRowsLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 0, hd);
+    return;
+}
+
+
+/*!
+ *  scaleGrayLIRowsLow()
+ *
+ *  Notes:
+ *      (1) This computes dest rows [ystart, yend) of scaleGrayLILow(),
+ *          so that horizontal strips of the dest can be scaled
+ *          separately; e.g., on different threads.  The result does
+ *          not depend on how the rows are split.
+ *      (2) The src x coordinates of the dest columns are computed once
+ *          for the strip, rather than again for every dest row.
+ */
+l_int32
+scaleGrayLIRowsLow(l_uint32  *datad,
+                   l_int32    wd,
+                   l_int32    hd,
+                   l_int32    wpld,
+                   l_uint32  *datas,
+                   l_int32    ws,
+                   l_int32    hs,
+                   l_int32    wpls,
+                   l_int32    ystart,
+                   l_int32    yend)
 {
 l_int32    i, j, wm2, hm2;
-l_int32    xpm, ypm;  /* location in src image, to 1/16 of a pixel */
+l_int32    ypm;  /* location in src image, to 1/16 of a pixel */
 l_int32    xp, yp, xf, yf;  /* src pixel and pixel fraction coordinates */
 l_int32    v00, v01, v10, v11, v00_val, v01_val, v10_val, v11_val;
 l_uint8    val;
 l_uint32  *lines, *lined;
+l_int32   *xpmtab;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayLIRowsLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -251,17 +328,22 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* Locations of the dest columns in the src, to 1/16 of a pixel */
+    if ((xpmtab = (l_int32 *)CALLOC(wd, sizeof(l_int32))) == NULL)
+        return ERROR_INT("xpmtab not made", procName, 1);
+    for (j = 0; j < wd; j++)
+        xpmtab[j] = (l_int32)(scx * (l_float32)j);
+
         /* Iterate over the destination pixels */
-    for (i = 0; i < hd; i++) {
+    for (i = ystart; i < yend; i++) {
         ypm = (l_int32)(scy * (l_float32)i);
         yp = ypm >> 4;
         yf = ypm & 0x0f;
         lined = datad + i * wpld;
         lines = datas + yp * wpls;
         for (j = 0; j < wd; j++) {
-            xpm = (l_int32)(scx * (l_float32)j);
-            xp = xpm >> 4;
-            xf = xpm & 0x0f;
+            xp = xpmtab[j] >> 4;
+            xf = xpmtab[j] & 0x0f;
 
                 /* Do bilinear interpolation.  Without this, we could
                  * simply subsample:
@@ -299,7 +381,8 @@ l_float32  scx, scy;
         }
     }
 
-    return;
+    FREE(xpmtab);
+    return 0;
 }
 
 
@@ -1286,6 +1369,34 @@ scaleColorAreaMapLow(l_uint32  *datad,
                     l_int32    ws,
                     l_int32    hs,
                     l_int32    wpls)
+{
+    scaleColorAreaMapRowsLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 0, hd);
+    return;
+}
+
+
+/*!
+ *  scaleColorAreaMapRowsLow()
+ *
+ *  Notes:
+ *      (1) This computes dest rows [ystart, yend) of scaleColorAreaMapLow(),
+ *          so that horizontal strips of the dest can be scaled
+ *          separately; e.g., on different threads.  The result does
+ *          not depend on how the rows are split.
+ *      (2) The src x coordinates of the dest columns are computed once
+ *          for the strip, rather than again for every dest row.
+ */
+l_int32
+scaleColorAreaMapRowsLow(l_uint32  *datad,
+                         l_int32    wd,
+                         l_int32    hd,
+                         l_int32    wpld,
+                         l_uint32  *datas,
+                         l_int32    ws,
+                         l_int32    hs,
+                         l_int32    wpls,
+                         l_int32    ystart,
+                         l_int32    yend)
 {
 l_int32    i, j, k, m, wm2, hm2;
 l_int32    area00, area10, area01, area11, areal, arear, areat, areab;
@@ -1303,8 +1414,11 @@ l_int32    vmidr, vmidg, vmidb;  /* contrib from side parts */
 l_int32    rval, gval, bval;
 l_uint32   pixel00, pixel10, pixel01, pixel11, pixel;
 l_uint32  *lines, *lined;
+l_int32   *xutab, *xltab;
 l_float32  scx, scy;
 
+    PROCNAME("scaleColorAreaMapRowsLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1315,8 +1429,17 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* UL and LR corners of the dest columns in the src */
+    if ((xutab = (l_int32 *)CALLOC(2 * wd, sizeof(l_int32))) == NULL)
+        return ERROR_INT("xutab not made", procName, 1);
+    xltab = xutab + wd;
+    for (j = 0; j < wd; j++) {
+        xutab[j] = (l_int32)(scx * j);
+        xltab[j] = (l_int32)(scx * (j + 1.0));
+    }
+
         /* Iterate over the destination pixels */
-    for (i = 0; i < hd; i++) {
+    for (i = ystart; i < yend; i++) {
         yu = (l_int32)(scy * i);
         yl = (l_int32)(scy * (i + 1.0));
         yup = yu >> 4;
@@ -1327,8 +1450,8 @@ l_float32  scx, scy;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
         for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
+            xu = xutab[j];
+            xl = xltab[j];
             xup = xu >> 4;
             xuf = xu & 0x0f;
             xlp = xl >> 4;
@@ -1420,7 +1543,8 @@ l_float32  scx, scy;
         }
     }
 
-    return;
+    FREE(xutab);
+    return 0;
 }
 
 
@@ -1444,6 +1568,34 @@ scaleGrayAreaMapLow(l_uint32  *datad,
                     l_int32    ws,
                     l_int32    hs,
                     l_int32    wpls)
+{
+    scaleGrayAreaMapRowsLow(datad, wd, hd, wpld, datas, ws, hs, wpls, 0, hd);
+    return;
+}
+
+
+/*!
+ *  scaleGrayAreaMapRowsLow()
+ *
+ *  Notes:
+ *      (1) This computes dest rows [ystart, yend) of scaleGrayAreaMapLow(),
+ *          so that horizontal strips of the dest can be scaled
+ *          separately; e.g., on different threads.  The result does
+ *          not depend on how the rows are split.
+ *      (2) The src x coordinates of the dest columns are computed once
+ *          for the strip, rather than again for every dest row.
+ */
+l_int32
+scaleGrayAreaMapRowsLow(l_uint32  *datad,
+                        l_int32    wd,
+                        l_int32    hd,
+                        l_int32    wpld,
+                        l_uint32  *datas,
+                        l_int32    ws,
+                        l_int32    hs,
+                        l_int32    wpls,
+                        l_int32    ystart,
+                        l_int32    yend)
 {
 l_int32    i, j, k, m, wm2, hm2;
 l_int32    xu, yu;  /* UL corner in src image, to 1/16 of a pixel */
@@ -1459,8 +1611,11 @@ l_int32    vin;  /* contrib from all full interior src pixels */
 l_int32    vmid;  /* contrib from side parts that are full in 1 direction */
 l_int32    val;
 l_uint32  *lines, *lined;
+l_int32   *xutab, *xltab;
 l_float32  scx, scy;
 
+    PROCNAME("scaleGrayAreaMapRowsLow");
+
         /* (scx, scy) are scaling factors that are applied to the
          * dest coords to get the corresponding src coords.
          * We need them because we iterate over dest pixels
@@ -1471,8 +1626,17 @@ l_float32  scx, scy;
     wm2 = ws - 2;
     hm2 = hs - 2;
 
+        /* UL and LR corners of the dest columns in the src */
+    if ((xutab = (l_int32 *)CALLOC(2 * wd, sizeof(l_int32))) == NULL)
+        return ERROR_INT("xutab not made", procName, 1);
+    xltab = xutab + wd;
+    for (j = 0; j < wd; j++) {
+        xutab[j] = (l_int32)(scx * j);
+        xltab[j] = (l_int32)(scx * (j + 1.0));
+    }
+
         /* Iterate over the destination pixels */
-    for (i = 0; i < hd; i++) {
+    for (i = ystart; i < yend; i++) {
         yu = (l_int32)(scy * i);
         yl = (l_int32)(scy * (i + 1.0));
         yup = yu >> 4;
@@ -1483,8 +1647,8 @@ l_float32  scx, scy;
         lined = datad + i * wpld;
         lines = datas + yup * wpls;
         for (j = 0; j < wd; j++) {
-            xu = (l_int32)(scx * j);
-            xl = (l_int32)(scx * (j + 1.0));
+            xu = xutab[j];
+            xl = xltab[j];
             xup = xu >> 4;
             xuf = xu & 0x0f;
             xlp = xl >> 4;
@@ -1529,7 +1693,8 @@ l_float32  scx, scy;
         }
     }
 
-    return;
+    FREE(xutab);
+    return 0;
 }
 
 
@@ -1539,8 +1704,14 @@ l_float32  scx, scy;
 /*!
  *  scaleAreaMapLow2()
  *
- *  Note: This function is called with either 8 bpp gray or 32 bpp RGB.
- *        The result is a 2x reduced dest.
+ *  Notes:
+ *      (1) This function is called with either 8 bpp gray or 32 bpp RGB.
+ *          The result is a 2x reduced dest.
+ *      (2) The sums are accumulated a word at a time: the bytes of
+ *          each src word are split into two 16-bit lanes, so that four
+ *          8 bpp dest pixels (or one RGB dest pixel) are computed with
+ *          a few masks and adds.  The result is identical to averaging
+ *          each 2x2 block separately.
  */
 void
 scaleAreaMapLow2(l_uint32  *datad,
@@ -1551,16 +1722,32 @@ scaleAreaMapLow2(l_uint32  *datad,
                  l_int32    d,
                  l_int32    wpls)
 {
-l_int32    i, j, val, rval, gval, bval;
+l_int32    i, j, k, nwords, val;
 l_uint32  *lines, *lined;
-l_uint32   pixel;
+l_uint32   word, suma, sumb, sumrb, sumga;
 
     if (d == 8) {
+        nwords = wd / 4;  /* full dest words */
         for (i = 0; i < hd; i++) {
             lines = datas + 2 * i * wpls;
             lined = datad + i * wpld;
-            for (j = 0; j < wd; j++) {
-                    /* Average each dest pixel using 4 src pixels */
+            for (k = 0; k < nwords; k++) {
+                    /* Each 16-bit lane holds the sum of a 2x2 block */
+                word = lines[2 * k];
+                suma = ((word >> 8) & 0x00ff00ff) + (word & 0x00ff00ff);
+                word = lines[wpls + 2 * k];
+                suma += ((word >> 8) & 0x00ff00ff) + (word & 0x00ff00ff);
+                word = lines[2 * k + 1];
+                sumb = ((word >> 8) & 0x00ff00ff) + (word & 0x00ff00ff);
+                word = lines[wpls + 2 * k + 1];
+                sumb += ((word >> 8) & 0x00ff00ff) + (word & 0x00ff00ff);
+                suma = (suma >> 2) & 0x00ff00ff;
+                sumb = (sumb >> 2) & 0x00ff00ff;
+                lined[k] = ((suma & 0x00ff0000) << 8) | ((suma & 0xff) << 16) |
+                           ((sumb & 0x00ff0000) >> 8) | (sumb & 0xff);
+            }
+            for (j = 4 * nwords; j < wd; j++) {
+                    /* Average each remaining dest pixel using 4 src pixels */
                 val = GET_DATA_BYTE(lines, 2 * j);
                 val += GET_DATA_BYTE(lines, 2 * j + 1);
                 val += GET_DATA_BYTE(lines + wpls, 2 * j);
@@ -1575,25 +1762,22 @@ l_uint32   pixel;
             lines = datas + 2 * i * wpls;
             lined = datad + i * wpld;
             for (j = 0; j < wd; j++) {
-                    /* Average each of the color components from 4 src pixels */
-                pixel = *(lines + 2 * j);
-                rval = (pixel >> L_RED_SHIFT) & 0xff;
-                gval = (pixel >> L_GREEN_SHIFT) & 0xff;
-                bval = (pixel >> L_BLUE_SHIFT) & 0xff;
-                pixel = *(lines + 2 * j + 1);
-                rval += (pixel >> L_RED_SHIFT) & 0xff;
-                gval += (pixel >> L_GREEN_SHIFT) & 0xff;
-                bval += (pixel >> L_BLUE_SHIFT) & 0xff;
-                pixel = *(lines + wpls + 2 * j);
-                rval += (pixel >> L_RED_SHIFT) & 0xff;
-                gval += (pixel >> L_GREEN_SHIFT) & 0xff;
-                bval += (pixel >> L_BLUE_SHIFT) & 0xff;
-                pixel = *(lines + wpls + 2 * j + 1);
-                rval += (pixel >> L_RED_SHIFT) & 0xff;
-                gval += (pixel >> L_GREEN_SHIFT) & 0xff;
-                bval += (pixel >> L_BLUE_SHIFT) & 0xff;
-                composeRGBPixel(rval >> 2, gval >> 2, bval >> 2, &pixel);
-                *(lined + j) = pixel;
+                    /* Red and blue go in one word, green (and the
+                     * discarded alpha) in the other */
+                word = lines[2 * j];
+                sumrb = (word >> 8) & 0x00ff00ff;
+                sumga = word & 0x00ff00ff;
+                word = lines[2 * j + 1];
+                sumrb += (word >> 8) & 0x00ff00ff;
+                sumga += word & 0x00ff00ff;
+                word = lines[wpls + 2 * j];
+                sumrb += (word >> 8) & 0x00ff00ff;
+                sumga += word & 0x00ff00ff;
+                word = lines[wpls + 2 * j + 1];
+                sumrb += (word >> 8) & 0x00ff00ff;
+                sumga += word & 0x00ff00ff;
+                lined[j] = (((sumrb >> 2) & 0x00ff00ff) << 8) |
+                           ((sumga >> 2) & 0x00ff0000);
             }
         }
     }
@@ -1684,6 +1868,159 @@ l_float32  wratio, hratio;
 }
 
 
+/*------------------------------------------------------------------*
+ *                  Scale-to-gray lookup tables                     *
+ *------------------------------------------------------------------*/
+/*
+ *  These are the tables that makeSumTabSG*(), makeValTabSG*() and
+ *  makePixelSumTab8() generate.  They are constant-initialized so that
+ *  pixScaleToGray*() can share them between calls (and threads)
+ *  instead of building and freeing them on every call.
+ */
+LEPT_DLL const l_uint32  SumTabSG2[256] = {
+    0x00000000, 0x00000001, 0x00000001, 0x00000002, 0x00000100, 0x00000101,
+    0x00000101, 0x00000102, 0x00000100, 0x00000101, 0x00000101, 0x00000102,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00010000, 0x00010001,
+    0x00010001, 0x00010002, 0x00010100, 0x00010101, 0x00010101, 0x00010102,
+    0x00010100, 0x00010101, 0x00010101, 0x00010102, 0x00010200, 0x00010201,
+    0x00010201, 0x00010202, 0x00010000, 0x00010001, 0x00010001, 0x00010002,
+    0x00010100, 0x00010101, 0x00010101, 0x00010102, 0x00010100, 0x00010101,
+    0x00010101, 0x00010102, 0x00010200, 0x00010201, 0x00010201, 0x00010202,
+    0x00020000, 0x00020001, 0x00020001, 0x00020002, 0x00020100, 0x00020101,
+    0x00020101, 0x00020102, 0x00020100, 0x00020101, 0x00020101, 0x00020102,
+    0x00020200, 0x00020201, 0x00020201, 0x00020202, 0x01000000, 0x01000001,
+    0x01000001, 0x01000002, 0x01000100, 0x01000101, 0x01000101, 0x01000102,
+    0x01000100, 0x01000101, 0x01000101, 0x01000102, 0x01000200, 0x01000201,
+    0x01000201, 0x01000202, 0x01010000, 0x01010001, 0x01010001, 0x01010002,
+    0x01010100, 0x01010101, 0x01010101, 0x01010102, 0x01010100, 0x01010101,
+    0x01010101, 0x01010102, 0x01010200, 0x01010201, 0x01010201, 0x01010202,
+    0x01010000, 0x01010001, 0x01010001, 0x01010002, 0x01010100, 0x01010101,
+    0x01010101, 0x01010102, 0x01010100, 0x01010101, 0x01010101, 0x01010102,
+    0x01010200, 0x01010201, 0x01010201, 0x01010202, 0x01020000, 0x01020001,
+    0x01020001, 0x01020002, 0x01020100, 0x01020101, 0x01020101, 0x01020102,
+    0x01020100, 0x01020101, 0x01020101, 0x01020102, 0x01020200, 0x01020201,
+    0x01020201, 0x01020202, 0x01000000, 0x01000001, 0x01000001, 0x01000002,
+    0x01000100, 0x01000101, 0x01000101, 0x01000102, 0x01000100, 0x01000101,
+    0x01000101, 0x01000102, 0x01000200, 0x01000201, 0x01000201, 0x01000202,
+    0x01010000, 0x01010001, 0x01010001, 0x01010002, 0x01010100, 0x01010101,
+    0x01010101, 0x01010102, 0x01010100, 0x01010101, 0x01010101, 0x01010102,
+    0x01010200, 0x01010201, 0x01010201, 0x01010202, 0x01010000, 0x01010001,
+    0x01010001, 0x01010002, 0x01010100, 0x01010101, 0x01010101, 0x01010102,
+    0x01010100, 0x01010101, 0x01010101, 0x01010102, 0x01010200, 0x01010201,
+    0x01010201, 0x01010202, 0x01020000, 0x01020001, 0x01020001, 0x01020002,
+    0x01020100, 0x01020101, 0x01020101, 0x01020102, 0x01020100, 0x01020101,
+    0x01020101, 0x01020102, 0x01020200, 0x01020201, 0x01020201, 0x01020202,
+    0x02000000, 0x02000001, 0x02000001, 0x02000002, 0x02000100, 0x02000101,
+    0x02000101, 0x02000102, 0x02000100, 0x02000101, 0x02000101, 0x02000102,
+    0x02000200, 0x02000201, 0x02000201, 0x02000202, 0x02010000, 0x02010001,
+    0x02010001, 0x02010002, 0x02010100, 0x02010101, 0x02010101, 0x02010102,
+    0x02010100, 0x02010101, 0x02010101, 0x02010102, 0x02010200, 0x02010201,
+    0x02010201, 0x02010202, 0x02010000, 0x02010001, 0x02010001, 0x02010002,
+    0x02010100, 0x02010101, 0x02010101, 0x02010102, 0x02010100, 0x02010101,
+    0x02010101, 0x02010102, 0x02010200, 0x02010201, 0x02010201, 0x02010202,
+    0x02020000, 0x02020001, 0x02020001, 0x02020002, 0x02020100, 0x02020101,
+    0x02020101, 0x02020102, 0x02020100, 0x02020101, 0x02020101, 0x02020102,
+    0x02020200, 0x02020201, 0x02020201, 0x02020202};
+
+LEPT_DLL const l_uint8  ValTabSG2[5] = {
+    255, 192, 128,  64,   0};
+
+LEPT_DLL const l_uint32  SumTabSG3[64] = {
+    0x00000000, 0x00000001, 0x00000001, 0x00000002, 0x00000001, 0x00000002,
+    0x00000002, 0x00000003, 0x00000100, 0x00000101, 0x00000101, 0x00000102,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000100, 0x00000101,
+    0x00000101, 0x00000102, 0x00000101, 0x00000102, 0x00000102, 0x00000103,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000100, 0x00000101, 0x00000101, 0x00000102,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000200, 0x00000201,
+    0x00000201, 0x00000202, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000300, 0x00000301, 0x00000301, 0x00000302,
+    0x00000301, 0x00000302, 0x00000302, 0x00000303};
+
+LEPT_DLL const l_uint8  ValTabSG3[10] = {
+    255, 227, 199, 170, 142, 114,  85,  57,  29,   0};
+
+LEPT_DLL const l_uint32  SumTabSG4[256] = {
+    0x00000000, 0x00000001, 0x00000001, 0x00000002, 0x00000001, 0x00000002,
+    0x00000002, 0x00000003, 0x00000001, 0x00000002, 0x00000002, 0x00000003,
+    0x00000002, 0x00000003, 0x00000003, 0x00000004, 0x00000100, 0x00000101,
+    0x00000101, 0x00000102, 0x00000101, 0x00000102, 0x00000102, 0x00000103,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000102, 0x00000103,
+    0x00000103, 0x00000104, 0x00000100, 0x00000101, 0x00000101, 0x00000102,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000101, 0x00000102,
+    0x00000102, 0x00000103, 0x00000102, 0x00000103, 0x00000103, 0x00000104,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000202, 0x00000203, 0x00000203, 0x00000204, 0x00000100, 0x00000101,
+    0x00000101, 0x00000102, 0x00000101, 0x00000102, 0x00000102, 0x00000103,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000102, 0x00000103,
+    0x00000103, 0x00000104, 0x00000200, 0x00000201, 0x00000201, 0x00000202,
+    0x00000201, 0x00000202, 0x00000202, 0x00000203, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000202, 0x00000203, 0x00000203, 0x00000204,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000202, 0x00000203, 0x00000203, 0x00000204, 0x00000300, 0x00000301,
+    0x00000301, 0x00000302, 0x00000301, 0x00000302, 0x00000302, 0x00000303,
+    0x00000301, 0x00000302, 0x00000302, 0x00000303, 0x00000302, 0x00000303,
+    0x00000303, 0x00000304, 0x00000100, 0x00000101, 0x00000101, 0x00000102,
+    0x00000101, 0x00000102, 0x00000102, 0x00000103, 0x00000101, 0x00000102,
+    0x00000102, 0x00000103, 0x00000102, 0x00000103, 0x00000103, 0x00000104,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000202, 0x00000203, 0x00000203, 0x00000204, 0x00000200, 0x00000201,
+    0x00000201, 0x00000202, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000201, 0x00000202, 0x00000202, 0x00000203, 0x00000202, 0x00000203,
+    0x00000203, 0x00000204, 0x00000300, 0x00000301, 0x00000301, 0x00000302,
+    0x00000301, 0x00000302, 0x00000302, 0x00000303, 0x00000301, 0x00000302,
+    0x00000302, 0x00000303, 0x00000302, 0x00000303, 0x00000303, 0x00000304,
+    0x00000200, 0x00000201, 0x00000201, 0x00000202, 0x00000201, 0x00000202,
+    0x00000202, 0x00000203, 0x00000201, 0x00000202, 0x00000202, 0x00000203,
+    0x00000202, 0x00000203, 0x00000203, 0x00000204, 0x00000300, 0x00000301,
+    0x00000301, 0x00000302, 0x00000301, 0x00000302, 0x00000302, 0x00000303,
+    0x00000301, 0x00000302, 0x00000302, 0x00000303, 0x00000302, 0x00000303,
+    0x00000303, 0x00000304, 0x00000300, 0x00000301, 0x00000301, 0x00000302,
+    0x00000301, 0x00000302, 0x00000302, 0x00000303, 0x00000301, 0x00000302,
+    0x00000302, 0x00000303, 0x00000302, 0x00000303, 0x00000303, 0x00000304,
+    0x00000400, 0x00000401, 0x00000401, 0x00000402, 0x00000401, 0x00000402,
+    0x00000402, 0x00000403, 0x00000401, 0x00000402, 0x00000402, 0x00000403,
+    0x00000402, 0x00000403, 0x00000403, 0x00000404};
+
+LEPT_DLL const l_uint8  ValTabSG4[17] = {
+    255, 240, 224, 208, 192, 176, 160, 144, 128, 112,  96,  80,  64,  48,  32,  16,
+      0};
+
+LEPT_DLL const l_uint8  ValTabSG6[37] = {
+    255, 248, 241, 234, 227, 220, 213, 206, 199, 192, 185, 178, 170, 163, 156, 149,
+    142, 135, 128, 121, 114, 107, 100,  93,  85,  78,  71,  64,  57,  50,  43,  36,
+     29,  22,  15,   8,   0};
+
+LEPT_DLL const l_uint8  ValTabSG8[65] = {
+    255, 252, 248, 244, 240, 236, 232, 228, 224, 220, 216, 212, 208, 204, 200, 196,
+    192, 188, 184, 180, 176, 172, 168, 164, 160, 156, 152, 148, 144, 140, 136, 132,
+    128, 124, 120, 116, 112, 108, 104, 100,  96,  92,  88,  84,  80,  76,  72,  68,
+     64,  60,  56,  52,  48,  44,  40,  36,  32,  28,  24,  20,  16,  12,   8,   4,
+      0};
+
+LEPT_DLL const l_int32  PixelSumTabSG[256] = {
+      0,   1,   1,   2,   1,   2,   2,   3,   1,   2,   2,   3,   2,   3,   3,   4,
+      1,   2,   2,   3,   2,   3,   3,   4,   2,   3,   3,   4,   3,   4,   4,   5,
+      1,   2,   2,   3,   2,   3,   3,   4,   2,   3,   3,   4,   3,   4,   4,   5,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      1,   2,   2,   3,   2,   3,   3,   4,   2,   3,   3,   4,   3,   4,   4,   5,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      3,   4,   4,   5,   4,   5,   5,   6,   4,   5,   5,   6,   5,   6,   6,   7,
+      1,   2,   2,   3,   2,   3,   3,   4,   2,   3,   3,   4,   3,   4,   4,   5,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      3,   4,   4,   5,   4,   5,   5,   6,   4,   5,   5,   6,   5,   6,   6,   7,
+      2,   3,   3,   4,   3,   4,   4,   5,   3,   4,   4,   5,   4,   5,   5,   6,
+      3,   4,   4,   5,   4,   5,   5,   6,   4,   5,   5,   6,   5,   6,   6,   7,
+      3,   4,   4,   5,   4,   5,   5,   6,   4,   5,   5,   6,   5,   6,   6,   7,
+      4,   5,   5,   6,   5,   6,   6,   7,   5,   6,   6,   7,   6,   7,   7,   8};
+
+
 /*------------------------------------------------------------------*
  *                         Scale-to-gray 2x                         *
  *------------------------------------------------------------------*/
@@ -1695,42 +2032,57 @@ l_float32  wratio, hratio;
  *              valtab  (made from makeValTabSG2())
  *      Return: 0 if OK; 1 on error.
  *
- *  The output is processed in sets of 4 output bytes on a row,
- *  corresponding to 4 2x2 bit-blocks in the input image.
- *  Two lookup tables are used.  The first, sumtab, gets the
- *  sum of ON pixels in 4 sets of two adjacent bits,
- *  storing the result in 4 adjacent bytes.  After sums from
- *  two rows have been added, the second table, valtab,
+ *  The output is processed in sets of 16 output bytes on a row,
+ *  corresponding to the 16 2x2 bit-blocks in one src word on each
+ *  of two lines.  Two lookup tables are used.  The first, sumtab,
+ *  gets the sum of ON pixels in 4 sets of two adjacent bits of a
+ *  src byte, storing the result in 4 adjacent bytes.  After sums
+ *  from two rows have been added, the second table, valtab,
  *  converts from the sum of ON pixels in the 2x2 block to
  *  an 8 bpp grayscale value between 0 (for 4 bits ON)
- *  and 255 (for 0 bits ON).
+ *  and 255 (for 0 bits ON).  Each src byte thus gives one full
+ *  dest word.  The remaining dest pixels are done a src byte
+ *  at a time.
  */
 void
-scaleToGray2Low(l_uint32  *datad,
-                l_int32    wd,
-                l_int32    hd,
-                l_int32    wpld,
-                l_uint32  *datas,
-                l_int32    wpls,
-                l_uint32  *sumtab,
-                l_uint8   *valtab)
+scaleToGray2Low(l_uint32        *datad,
+                l_int32          wd,
+                l_int32          hd,
+                l_int32          wpld,
+                l_uint32        *datas,
+                l_int32          wpls,
+                const l_uint32  *sumtab,
+                const l_uint8   *valtab)
 {
-l_int32    i, j, l, k, m, wd4, extra;
-l_uint32   sbyte1, sbyte2, sum;
+l_int32    i, j, l, k, m, n, nwords, wd4, extra;
+l_uint32   sword1, sword2, sbyte1, sbyte2, sum;
 l_uint32  *lines, *lined;
 
         /* i indexes the dest lines
          * l indexes the source lines
          * j indexes the dest bytes
-         * k indexes the source bytes
-         * We take two bytes from the source (in 2 lines of 8 pixels
-         * each) and convert them into four 8 bpp bytes of the dest. */
+         * k indexes the source bytes (and n the source words)
+         * We take two words from the source (in 2 lines of 32 pixels
+         * each) and convert them into sixteen 8 bpp bytes of the dest. */
+    nwords = wd / 16;
     wd4 = wd & 0xfffffffc;
     extra = wd - wd4;
     for (i = 0, l = 0; i < hd; i++, l += 2) {
         lines = datas + l * wpls;
         lined = datad + i * wpld;
-        for (j = 0, k = 0; j < wd4; j += 4, k++) {
+        for (n = 0; n < nwords; n++) {
+            sword1 = lines[n];
+            sword2 = lines[wpls + n];
+            for (m = 0; m < 4; m++) {
+                sum = sumtab[(sword1 >> (24 - 8 * m)) & 0xff] +
+                      sumtab[(sword2 >> (24 - 8 * m)) & 0xff];
+                lined[4 * n + m] = (valtab[sum >> 24] << 24) |
+                                   (valtab[(sum >> 16) & 0xff] << 16) |
+                                   (valtab[(sum >> 8) & 0xff] << 8) |
+                                   valtab[sum & 0xff];
+            }
+        }
+        for (j = 16 * nwords, k = 4 * nwords; j < wd4; j += 4, k++) {
             sbyte1 = GET_DATA_BYTE(lines, k);
             sbyte2 = GET_DATA_BYTE(lines + wpls, k);
             sum = sumtab[sbyte1] + sumtab[sbyte2];
@@ -1763,25 +2115,19 @@ l_uint32  *lines, *lined;
  *  image, for a 2x scale-to-gray op.  The sums from two
  *  adjacent scanlines are then added and transformed to
  *  output four 8 bpp pixel values, using makeValTabSG2().
+ *
+ *  This is a newly allocated copy of the constant SumTabSG2.
  */
 l_uint32  *
 makeSumTabSG2(void)
 {
-l_int32    i;
-l_int32    sum[] = {0, 1, 1, 2};
 l_uint32  *tab;
 
     PROCNAME("makeSumTabSG2");
 
     if ((tab = (l_uint32 *)CALLOC(256, sizeof(l_uint32))) == NULL)
         return (l_uint32 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-        /* Pack the four sums separately in four bytes */
-    for (i = 0; i < 256; i++) {
-        tab[i] = (sum[i & 0x3] | sum[(i >> 2) & 0x3] << 8 |
-                  sum[(i >> 4) & 0x3] << 16 | sum[(i >> 6) & 0x3] << 24);
-    }
-
+    memcpy(tab, SumTabSG2, 256 * sizeof(l_uint32));
     return tab;
 }
 
@@ -1795,21 +2141,19 @@ l_uint32  *tab;
  *         val = 255 - (255 * sum)/4
  *
  *  where sum is in set {0,1,2,3,4}
+ *
+ *  This is a newly allocated copy of the constant ValTabSG2.
  */
 l_uint8 *
 makeValTabSG2(void)
 {
-l_int32   i;
-l_uint8  *tab;
+l_uint8   *tab;
 
     PROCNAME("makeValTabSG2");
 
     if ((tab = (l_uint8 *)CALLOC(5, sizeof(l_uint8))) == NULL)
         return (l_uint8 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-    for (i = 0; i < 5; i++)
-        tab[i] = 255 - (i * 255) / 4;
-
+    memcpy(tab, ValTabSG2, 5 * sizeof(l_uint8));
     return tab;
 }
 
@@ -1846,14 +2190,14 @@ l_uint8  *tab;
  *        (h - h % 3) and the input width to (w - w % 24).
  */
 void
-scaleToGray3Low(l_uint32  *datad,
-                l_int32    wd,
-                l_int32    hd,
-                l_int32    wpld,
-                l_uint32  *datas,
-                l_int32    wpls,
-                l_uint32  *sumtab,
-                l_uint8   *valtab)
+scaleToGray3Low(l_uint32        *datad,
+                l_int32          wd,
+                l_int32          hd,
+                l_int32          wpld,
+                l_uint32        *datas,
+                l_int32          wpls,
+                const l_uint32  *sumtab,
+                const l_uint8   *valtab)
 {
 l_int32    i, j, l, k;
 l_uint32   threebytes1, threebytes2, threebytes3, sum;
@@ -1920,24 +2264,19 @@ l_uint32  *lines, *lined;
  *  be used three times (on adjacent scanlines), and the sums would
  *  be added and then transformed to output 8 bpp pixel values,
  *  using makeValTabSG3().
+ *
+ *  This is a newly allocated copy of the constant SumTabSG3.
  */
 l_uint32  *
 makeSumTabSG3(void)
 {
-l_int32    i;
-l_int32    sum[] = {0, 1, 1, 2, 1, 2, 2, 3};
 l_uint32  *tab;
 
     PROCNAME("makeSumTabSG3");
 
     if ((tab = (l_uint32 *)CALLOC(64, sizeof(l_uint32))) == NULL)
         return (l_uint32 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-        /* Pack the two sums separately in two bytes */
-    for (i = 0; i < 64; i++) {
-        tab[i] = (sum[i & 0x07]) | (sum[(i >> 3) & 0x07] << 8);
-    }
-
+    memcpy(tab, SumTabSG3, 64 * sizeof(l_uint32));
     return tab;
 }
 
@@ -1949,21 +2288,19 @@ l_uint32  *tab;
  *  in a 3x3 square, according to
  *      val = 255 - (255 * sum)/9
  *  where sum is in set {0, ... ,9}
+ *
+ *  This is a newly allocated copy of the constant ValTabSG3.
  */
 l_uint8 *
 makeValTabSG3(void)
 {
-l_int32   i;
-l_uint8  *tab;
+l_uint8   *tab;
 
     PROCNAME("makeValTabSG3");
 
     if ((tab = (l_uint8 *)CALLOC(10, sizeof(l_uint8))) == NULL)
         return (l_uint8 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-    for (i = 0; i < 10; i++)
-        tab[i] = 0xff - (i * 255) / 9;
-
+    memcpy(tab, ValTabSG3, 10 * sizeof(l_uint8));
     return tab;
 }
 
@@ -1979,40 +2316,62 @@ l_uint8  *tab;
  *              valtab  (made from makeValTabSG4())
  *      Return: 0 if OK; 1 on error.
  *
- *  The output is processed in sets of 2 output bytes on a row,
- *  corresponding to 2 4x4 bit-blocks in the input image.
- *  Two lookup tables are used.  The first, sumtab, gets the
- *  sum of ON pixels in two sets of four adjacent bits,
+ *  The output is processed in sets of 8 output bytes on a row,
+ *  corresponding to the 8 4x4 bit-blocks in one src word on each
+ *  of four lines.  Two lookup tables are used.  The first, sumtab,
+ *  gets the sum of ON pixels in two sets of four adjacent bits,
  *  storing the result in 2 adjacent bytes.  After sums from
  *  four rows have been added, the second table, valtab,
  *  converts from the sum of ON pixels in the 4x4 block to
  *  an 8 bpp grayscale value between 0 (for 16 bits ON)
- *  and 255 (for 0 bits ON).
+ *  and 255 (for 0 bits ON).  Each src word thus gives two full
+ *  dest words.  The remaining dest pixels are done a src byte
+ *  at a time.
  */
 void
-scaleToGray4Low(l_uint32  *datad,
-                l_int32    wd,
-                l_int32    hd,
-                l_int32    wpld,
-                l_uint32  *datas,
-                l_int32    wpls,
-                l_uint32  *sumtab,
-                l_uint8   *valtab)
+scaleToGray4Low(l_uint32        *datad,
+                l_int32          wd,
+                l_int32          hd,
+                l_int32          wpld,
+                l_uint32        *datas,
+                l_int32          wpls,
+                const l_uint32  *sumtab,
+                const l_uint8   *valtab)
 {
-l_int32    i, j, l, k;
-l_uint32   sbyte1, sbyte2, sbyte3, sbyte4, sum;
+l_int32    i, j, l, k, m, n, nwords, shift;
+l_uint32   sword1, sword2, sword3, sword4, sbyte1, sbyte2, sbyte3, sbyte4;
+l_uint32   sum, dword;
 l_uint32  *lines, *lined;
 
         /* i indexes the dest lines
          * l indexes the source lines
          * j indexes the dest bytes
-         * k indexes the source bytes
-         * We take four bytes from the source (in 4 lines of 8 pixels
-         * each) and convert it into two 8 bpp bytes of the dest. */
+         * k indexes the source bytes (and n the source words)
+         * We take four words from the source (in 4 lines of 32 pixels
+         * each) and convert them into eight 8 bpp bytes of the dest. */
+    nwords = wd / 8;
     for (i = 0, l = 0; i < hd; i++, l += 4) {
         lines = datas + l * wpls;
         lined = datad + i * wpld;
-        for (j = 0, k = 0; j < wd; j += 2, k++) {
+        for (n = 0; n < nwords; n++) {
+            sword1 = lines[n];
+            sword2 = lines[wpls + n];
+            sword3 = lines[2 * wpls + n];
+            sword4 = lines[3 * wpls + n];
+            dword = 0;
+            for (m = 0; m < 4; m++) {
+                shift = 24 - 8 * m;
+                sum = sumtab[(sword1 >> shift) & 0xff] +
+                      sumtab[(sword2 >> shift) & 0xff] +
+                      sumtab[(sword3 >> shift) & 0xff] +
+                      sumtab[(sword4 >> shift) & 0xff];
+                dword = (dword << 16) | (valtab[(sum >> 8) & 0xff] << 8) |
+                        valtab[sum & 0xff];
+                if (m & 1)
+                    lined[2 * n + m / 2] = dword;
+            }
+        }
+        for (j = 8 * nwords, k = 4 * nwords; j < wd; j += 2, k++) {
             sbyte1 = GET_DATA_BYTE(lines, k);
             sbyte2 = GET_DATA_BYTE(lines + wpls, k);
             sbyte3 = GET_DATA_BYTE(lines + 2 * wpls, k);
@@ -2036,24 +2395,19 @@ l_uint32  *lines, *lined;
  *  image, for a 4x scale-to-gray op.  The sums from four
  *  adjacent scanlines are then added and transformed to
  *  output 8 bpp pixel values, using makeValTabSG4().
+ *
+ *  This is a newly allocated copy of the constant SumTabSG4.
  */
 l_uint32  *
 makeSumTabSG4(void)
 {
-l_int32    i;
-l_int32    sum[] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
 l_uint32  *tab;
 
     PROCNAME("makeSumTabSG4");
 
     if ((tab = (l_uint32 *)CALLOC(256, sizeof(l_uint32))) == NULL)
         return (l_uint32 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-        /* Pack the two sums separately in two bytes */
-    for (i = 0; i < 256; i++) {
-        tab[i] = (sum[i & 0xf]) | (sum[(i >> 4) & 0xf] << 8);
-    }
-
+    memcpy(tab, SumTabSG4, 256 * sizeof(l_uint32));
     return tab;
 }
 
@@ -2067,21 +2421,19 @@ l_uint32  *tab;
  *         val = 255 - (255 * sum)/16
  *
  *  where sum is in set {0, ... ,16}
+ *
+ *  This is a newly allocated copy of the constant ValTabSG4.
  */
 l_uint8 *
 makeValTabSG4(void)
 {
-l_int32   i;
-l_uint8  *tab;
+l_uint8   *tab;
 
     PROCNAME("makeValTabSG4");
 
     if ((tab = (l_uint8 *)CALLOC(17, sizeof(l_uint8))) == NULL)
         return (l_uint8 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-    for (i = 0; i < 17; i++)
-        tab[i] = 0xff - (i * 255) / 16;
-
+    memcpy(tab, ValTabSG4, 17 * sizeof(l_uint8));
     return tab;
 }
 
@@ -2118,14 +2470,14 @@ l_uint8  *tab;
  *
  */
 void
-scaleToGray6Low(l_uint32  *datad,
-                l_int32    wd,
-                l_int32    hd,
-                l_int32    wpld,
-                l_uint32  *datas,
-                l_int32    wpls,
-                l_int32   *tab8,
-                l_uint8   *valtab)
+scaleToGray6Low(l_uint32       *datad,
+                l_int32         wd,
+                l_int32         hd,
+                l_int32         wpld,
+                l_uint32       *datas,
+                l_int32         wpls,
+                const l_int32  *tab8,
+                const l_uint8  *valtab)
 {
 l_int32    i, j, l, k;
 l_uint32   threebytes1, threebytes2, threebytes3;
@@ -2211,21 +2563,19 @@ l_uint32  *lines, *lined;
  *  in a 6x6 square, according to
  *      val = 255 - (255 * sum)/36
  *  where sum is in set {0, ... ,36}
+ *
+ *  This is a newly allocated copy of the constant ValTabSG6.
  */
 l_uint8 *
 makeValTabSG6(void)
 {
-l_int32   i;
-l_uint8  *tab;
+l_uint8   *tab;
 
     PROCNAME("makeValTabSG6");
 
     if ((tab = (l_uint8 *)CALLOC(37, sizeof(l_uint8))) == NULL)
         return (l_uint8 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-    for (i = 0; i < 37; i++)
-        tab[i] = 0xff - (i * 255) / 36;
-
+    memcpy(tab, ValTabSG6, 37 * sizeof(l_uint8));
     return tab;
 }
 
@@ -2241,37 +2591,56 @@ l_uint8  *tab;
  *              valtab  (made from makeValTabSG8())
  *      Return: 0 if OK; 1 on error.
  *
- *  The output is processed one dest byte at a time,
- *  corresponding to 8 rows of src bytes in the input image.
+ *  The output is processed one dest word at a time,
+ *  corresponding to 8 rows of src words in the input image.
  *  Two lookup tables are used.  The first, tab8, gets the
  *  sum of ON pixels in a byte.  After sums from 8 rows have
  *  been added, the second table, valtab, converts from this
  *  value (which is between 0 and 64) to an 8 bpp grayscale
  *  value between 0 (for all 64 bits ON) and 255 (for 0 bits ON).
+ *  The remaining dest pixels are done one dest byte at a time.
  */
 void
-scaleToGray8Low(l_uint32  *datad,
-                l_int32    wd,
-                l_int32    hd,
-                l_int32    wpld,
-                l_uint32  *datas,
-                l_int32    wpls,
-                l_int32   *tab8,
-                l_uint8   *valtab)
+scaleToGray8Low(l_uint32       *datad,
+                l_int32         wd,
+                l_int32         hd,
+                l_int32         wpld,
+                l_uint32       *datas,
+                l_int32         wpls,
+                const l_int32  *tab8,
+                const l_uint8  *valtab)
 {
-l_int32    i, j, k;
+l_int32    i, j, k, m, n, nwords, shift;
 l_int32    sbyte0, sbyte1, sbyte2, sbyte3, sbyte4, sbyte5, sbyte6, sbyte7, sum;
+l_uint32   dword;
 l_uint32  *lines, *lined;
 
         /* i indexes the dest lines
          * k indexes the source lines
-         * j indexes the src and dest bytes
-         * We take 8 bytes from the source (in 8 lines of 8 pixels
-         * each) and convert it into one 8 bpp byte of the dest. */
+         * j indexes the src and dest bytes (and n the words)
+         * We take 8 words from the source (in 8 lines of 32 pixels
+         * each) and convert it into four 8 bpp bytes of the dest. */
+    nwords = wd / 4;
     for (i = 0, k = 0; i < hd; i++, k += 8) {
         lines = datas + k * wpls;
         lined = datad + i * wpld;
-        for (j = 0; j < wd; j++) {
+        for (n = 0; n < nwords; n++) {
+            dword = 0;
+            for (m = 0; m < 4; m++) {
+                shift = 24 - 8 * m;
+                sum = tab8[(lines[n] >> shift) & 0xff] +
+                      tab8[(lines[wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[2 * wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[3 * wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[4 * wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[5 * wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[6 * wpls + n] >> shift) & 0xff] +
+                      tab8[(lines[7 * wpls + n] >> shift) & 0xff];
+                dword = (dword << 8) | valtab[sum];
+            }
+            lined[n] = dword;
+        }
+        for (j = 4 * nwords; j < wd; j++) {
             sbyte0 = GET_DATA_BYTE(lines, j);
             sbyte1 = GET_DATA_BYTE(lines + wpls, j);
             sbyte2 = GET_DATA_BYTE(lines + 2 * wpls, j);
@@ -2299,21 +2668,19 @@ l_uint32  *lines, *lined;
  *  in an 8x8 square, according to
  *      val = 255 - (255 * sum)/64
  *  where sum is in set {0, ... ,64}
+ *
+ *  This is a newly allocated copy of the constant ValTabSG8.
  */
 l_uint8 *
 makeValTabSG8(void)
 {
-l_int32   i;
-l_uint8  *tab;
+l_uint8   *tab;
 
     PROCNAME("makeValTabSG8");
 
     if ((tab = (l_uint8 *)CALLOC(65, sizeof(l_uint8))) == NULL)
         return (l_uint8 *)ERROR_PTR("calloc fail for tab", procName, NULL);
-
-    for (i = 0; i < 65; i++)
-        tab[i] = 0xff - (i * 255) / 64;
-
+    memcpy(tab, ValTabSG8, 65 * sizeof(l_uint8));
     return tab;
 }
 
@@ -2337,13 +2704,13 @@ l_uint8  *tab;
  *  and 255 (for 0 bits ON).
  */
 void
-scaleToGray16Low(l_uint32  *datad,
-                  l_int32    wd,
-                 l_int32    hd,
-                 l_int32    wpld,
-                 l_uint32  *datas,
-                 l_int32    wpls,
-                 l_int32   *tab8)
+scaleToGray16Low(l_uint32       *datad,
+                 l_int32         wd,
+                 l_int32         hd,
+                 l_int32         wpld,
+                 l_uint32       *datas,
+                 l_int32         wpls,
+                 const l_int32  *tab8)
 {
 l_int32    i, j, k, m;
 l_int32    sum;
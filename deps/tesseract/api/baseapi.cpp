@@ -421,6 +421,21 @@ void TessBaseAPI::ClearAdaptiveClassifier() {
   tesseract_->ResetDocumentDictionary();
 }
 
+/** Writes the adapted templates of the primary language to fp. */
+bool TessBaseAPI::SaveAdaptiveClassifier(FILE* fp) {
+  if (tesseract_ == NULL)
+    return false;
+  tesseract_->SaveAdaptedTemplates(fp);
+  return ferror(fp) == 0;
+}
+
+/** Loads adapted templates for the primary language from fp. */
+bool TessBaseAPI::LoadAdaptiveClassifier(FILE* fp) {
+  if (tesseract_ == NULL)
+    return false;
+  return tesseract_->LoadAdaptedTemplates(fp);
+}
+
 /**
  * Provide an image for Tesseract to recognize. Format is as
  * TesseractRect above. Does not copy the image buffer, or take
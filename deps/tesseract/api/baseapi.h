@@ -293,6 +293,20 @@ class TESS_API TessBaseAPI {
    */
   void ClearAdaptiveClassifier();
 
+  /**
+   * Writes what the adaptive classifier has learned to fp, so that another
+   * engine of the same language can start from it with
+   * LoadAdaptiveClassifier. Returns false if not initialized.
+   */
+  bool SaveAdaptiveClassifier(FILE* fp);
+
+  /**
+   * Replaces what the adaptive classifier has learned with the data written
+   * by SaveAdaptiveClassifier to fp. Returns false, and keeps the current
+   * data, if fp does not hold adaptive data for the language of this engine.
+   */
+  bool LoadAdaptiveClassifier(FILE* fp);
+
   /**
    * @defgroup AdvancedAPI Advanced API
    * The following methods break TesseractRect into pieces, so you can
@@ -59,6 +59,53 @@ const char* const kBackUpConfigFile = "tempconfigdata.config";
 // Multiple of x-height to make a repeated word have spaces in it.
 const double kRepcharGapThreshold = 0.5;
 
+// Set by the first run of a page that stops, and checked by the others
+// before each word.
+class Pass1Stop {
+ public:
+  Pass1Stop() : stop_(false) {}
+
+  bool get() {
+    mutex_.Lock();
+    bool stop = stop_;
+    mutex_.Unlock();
+    return stop;
+  }
+
+  void set() {
+    mutex_.Lock();
+    stop_ = true;
+    mutex_.Unlock();
+  }
+
+ private:
+  tesseract::CCUtilMutex mutex_;
+  bool stop_;
+};
+
+// A contiguous run of the words of a page, classified in pass 1 by one
+// engine on one thread.
+struct Pass1Chunk {
+  tesseract::Tesseract* tesseract;
+  PAGE_RES_IT it;      // At the first word of the run.
+  int word_count;
+  ETEXT_DESC* monitor;
+  bool poll_cancel;    // Only the calling thread runs the cancel function.
+  Pass1Stop* stop;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI classify_pass1_chunk(LPVOID arg) {
+#else
+static void* classify_pass1_chunk(void* arg) {
+#endif
+  Pass1Chunk* chunk = static_cast<Pass1Chunk*>(arg);
+  chunk->tesseract->classify_pass1_words(&chunk->it, chunk->word_count,
+                                         chunk->monitor, chunk->poll_cancel,
+                                         chunk->stop);
+  return 0;
+}
+
 
 /**
  * recog_pseudo_word
@@ -237,6 +284,18 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
     stats_.good_char_count = 0;
     stats_.doc_good_char_quality = 0;
 
+    // Only the plain single language classification without a target word is
+    // split over threads, the rest keeps to the reading order.
+    bool parallel_pass1 = tessedit_pass1_threads > 1 &&
+        target_word_box == NULL && sub_langs_.empty() &&
+        tessedit_ocr_engine_mode != OEM_CUBE_ONLY;
+    if (parallel_pass1) {
+      set_global_loc_code(LOC_PASS1);
+      if (!classify_page_pass1_parallel(page_res, tessedit_pass1_threads,
+                                        monitor))
+        return false;
+    }
+
     most_recently_used_ = this;
     while (page_res_it.word() != NULL) {
       set_global_loc_code(LOC_PASS1);
@@ -255,10 +314,17 @@ bool Tesseract::recog_all_words(PAGE_RES* page_res,
         page_res_it.forward();
         continue;
       }
-      classify_word_and_language(&Tesseract::classify_word_pass1,
-                                 page_res_it.block()->block,
-                                 page_res_it.row()->row,
-                                 page_res_it.word());
+      if (parallel_pass1) {
+        // Already classified, so just learn from it as the serial pass would.
+        WERD_RES* word = page_res_it.word();
+        if (!word->tess_failed && !word->word->flag(W_REP_CHAR))
+          learn_word_pass1(word, word->best_choice->blob_choices());
+      } else {
+        classify_word_and_language(&Tesseract::classify_word_pass1,
+                                   page_res_it.block()->block,
+                                   page_res_it.row()->row,
+                                   page_res_it.word());
+      }
       if (page_res_it.word()->word->flag(W_REP_CHAR)) {
         fix_rep_char(&page_res_it);
         page_res_it.forward();
@@ -851,6 +917,113 @@ void Tesseract::classify_word_and_language(WordRecognizer recognizer,
   }
 }
 
+// Classifies word_count words from it on with pass 1 of this engine,
+// leaving the learning to the caller. Stops early once stop is set or the
+// deadline of monitor has passed, and then sets stop for the other runs.
+void Tesseract::classify_pass1_words(PAGE_RES_IT* it, int word_count,
+                                     ETEXT_DESC* monitor, bool poll_cancel,
+                                     Pass1Stop* stop) {
+  most_recently_used_ = this;
+  defer_pass1_learning_ = true;
+  for (int w = 0; w < word_count && it->word() != NULL; ++w) {
+    if (stop->get())
+      break;
+    if (monitor != NULL) {
+      if (poll_cancel)
+        monitor->ocr_alive = TRUE;
+      if (monitor->deadline_exceeded() ||
+          (poll_cancel && monitor->cancel != NULL &&
+           (*monitor->cancel)(monitor->cancel_this, stats_.dict_words))) {
+        stop->set();
+        break;
+      }
+    }
+    classify_word_and_language(&Tesseract::classify_word_pass1,
+                               it->block()->block, it->row()->row,
+                               it->word());
+    it->forward();
+  }
+  defer_pass1_learning_ = false;
+}
+
+// The words are split into runs of consecutive words, so the first run can be
+// classified by this while the helpers take the others. All runs see only
+// the adapted templates of this as they were at the start of the page, which
+// makes the result independent of the timing of the threads.
+// Returns false if the deadline or the cancel function of monitor stopped it.
+bool Tesseract::classify_page_pass1_parallel(PAGE_RES* page_res,
+                                             int thread_count,
+                                             ETEXT_DESC* monitor) {
+  PAGE_RES_IT page_res_it(page_res);
+  int word_count = 0;
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward())
+    ++word_count;
+  if (thread_count > word_count)
+    thread_count = word_count;
+  if (thread_count <= 0)
+    return true;
+  SetupPass1Helpers(thread_count - 1);
+  if (thread_count > pass1_helpers_.size() + 1)
+    thread_count = pass1_helpers_.size() + 1;
+
+  Pass1Stop stop;
+  GenericVector<Pass1Chunk> chunks;
+  page_res_it.restart_page();
+  for (int c = 0; c < thread_count; ++c) {
+    Pass1Chunk chunk;
+    chunk.tesseract = c == 0 ? this : pass1_helpers_[c - 1];
+    chunk.it = page_res_it;
+    chunk.word_count = word_count * (c + 1) / thread_count -
+        word_count * c / thread_count;
+    chunk.monitor = monitor;
+    chunk.poll_cancel = c == 0;
+    chunk.stop = &stop;
+    chunks.push_back(chunk);
+    for (int w = 0; w < chunk.word_count; ++w)
+      page_res_it.forward();
+  }
+#ifdef _WIN32
+  GenericVector<HANDLE> threads;
+  for (int c = 1; c < chunks.size(); ++c) {
+    HANDLE thread = CreateThread(NULL, 0, classify_pass1_chunk, &chunks[c],
+                                 0, NULL);
+    if (thread != NULL)
+      threads.push_back(thread);
+    else
+      classify_pass1_chunk(&chunks[c]);
+  }
+  classify_pass1_chunk(&chunks[0]);
+  for (int t = 0; t < threads.size(); ++t) {
+    WaitForSingleObject(threads[t], INFINITE);
+    CloseHandle(threads[t]);
+  }
+#else
+  GenericVector<pthread_t> threads;
+  for (int c = 1; c < chunks.size(); ++c) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, classify_pass1_chunk, &chunks[c]) == 0)
+      threads.push_back(thread);
+    else
+      classify_pass1_chunk(&chunks[c]);
+  }
+  classify_pass1_chunk(&chunks[0]);
+  for (int t = 0; t < threads.size(); ++t)
+    pthread_join(threads[t], NULL);
+#endif
+
+  // The results belong to this from now on, as pass 2 and the output expect.
+  for (page_res_it.restart_page(); page_res_it.word() != NULL;
+       page_res_it.forward()) {
+    WERD_RES* word = page_res_it.word();
+    if (word->tesseract != NULL) {
+      word->tesseract = this;
+      word->uch_set = &unicharset;
+    }
+  }
+  return !stop.get();
+}
+
 /**
  * classify_word_pass1
  *
@@ -865,10 +1038,6 @@ void Tesseract::classify_word_pass1(BLOCK* block, ROW *row, WERD_RES *word) {
   }
 
   BLOB_CHOICE_LIST_CLIST *blob_choices = new BLOB_CHOICE_LIST_CLIST();
-  BOOL8 adapt_ok;
-  const char *rejmap;
-  inT16 index;
-  STRING mapstr = "";
 
   check_debug_pt(word, 0);
   if (word->SetupForTessRecognition(unicharset, this, BestPix(),
@@ -904,46 +1073,8 @@ void Tesseract::classify_word_pass1(BLOCK* block, ROW *row, WERD_RES *word) {
                                  // Also sets word->done flag
       make_reject_map(word, blob_choices, row, 1);
 
-      adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
-
-      if (adapt_ok || tessedit_tess_adapt_to_rejmap) {
-        if (!tessedit_tess_adapt_to_rejmap) {
-          rejmap = NULL;
-        } else {
-          ASSERT_HOST(word->reject_map.length() ==
-                      word->best_choice->length());
-
-          for (index = 0; index < word->reject_map.length(); index++) {
-            if (adapt_ok || word->reject_map[index].accepted())
-              mapstr += '1';
-            else
-              mapstr += '0';
-          }
-          rejmap = mapstr.string();
-        }
-        // Send word to adaptive classifier for training.
-        word->BestChoiceToCorrectText();
-        set_word_fonts(word, blob_choices);
-        LearnWord(NULL, rejmap, word);
-        // Mark misadaptions if running blamer.
-        if (word->blamer_bundle != NULL &&
-            word->blamer_bundle->incorrect_result_reason != IRR_NO_TRUTH &&
-            !ChoiceIsCorrect(*word->uch_set, word->best_choice,
-                             word->blamer_bundle->truth_text)) {
-          word->blamer_bundle->misadaption_debug ="misadapt to word (";
-          word->blamer_bundle->misadaption_debug +=
-              word->best_choice->permuter_name();
-          word->blamer_bundle->misadaption_debug += "): ";
-          word->blamer_bundle->FillDebugString(
-              "", word->best_choice, &(word->blamer_bundle->misadaption_debug));
-          if (wordrec_debug_blamer) {
-            tprintf("%s\n", word->blamer_bundle->misadaption_debug.string());
-          }
-        }
-      }
-
-      if (tessedit_enable_doc_dict)
-        tess_add_doc_word(word->best_choice);
+      if (!defer_pass1_learning_)
+        learn_word_pass1(word, blob_choices);
     }
   }
 
@@ -951,6 +1082,62 @@ void Tesseract::classify_word_pass1(BLOCK* block, ROW *row, WERD_RES *word) {
   word->best_choice->set_blob_choices(blob_choices);
 }
 
+/**
+ * learn_word_pass1
+ *
+ * Adapt to a word classified by pass 1 if it is good enough, and add it to
+ * the document dictionary.
+ */
+
+void Tesseract::learn_word_pass1(WERD_RES *word,
+                                 BLOB_CHOICE_LIST_CLIST *blob_choices) {
+  BOOL8 adapt_ok;
+  const char *rejmap;
+  inT16 index;
+  STRING mapstr = "";
+
+  adapt_ok = word_adaptable(word, tessedit_tess_adaption_mode);
+
+  if (adapt_ok || tessedit_tess_adapt_to_rejmap) {
+    if (!tessedit_tess_adapt_to_rejmap) {
+      rejmap = NULL;
+    } else {
+      ASSERT_HOST(word->reject_map.length() ==
+                  word->best_choice->length());
+
+      for (index = 0; index < word->reject_map.length(); index++) {
+        if (adapt_ok || word->reject_map[index].accepted())
+          mapstr += '1';
+        else
+          mapstr += '0';
+      }
+      rejmap = mapstr.string();
+    }
+    // Send word to adaptive classifier for training.
+    word->BestChoiceToCorrectText();
+    set_word_fonts(word, blob_choices);
+    LearnWord(NULL, rejmap, word);
+    // Mark misadaptions if running blamer.
+    if (word->blamer_bundle != NULL &&
+        word->blamer_bundle->incorrect_result_reason != IRR_NO_TRUTH &&
+        !ChoiceIsCorrect(*word->uch_set, word->best_choice,
+                         word->blamer_bundle->truth_text)) {
+      word->blamer_bundle->misadaption_debug ="misadapt to word (";
+      word->blamer_bundle->misadaption_debug +=
+          word->best_choice->permuter_name();
+      word->blamer_bundle->misadaption_debug += "): ";
+      word->blamer_bundle->FillDebugString(
+          "", word->best_choice, &(word->blamer_bundle->misadaption_debug));
+      if (wordrec_debug_blamer) {
+        tprintf("%s\n", word->blamer_bundle->misadaption_debug.string());
+      }
+    }
+  }
+
+  if (tessedit_enable_doc_dict)
+    tess_add_doc_word(word->best_choice);
+}
+
 // Helper to report the result of the xheight fix.
 void Tesseract::ReportXhtFixResult(bool accept_new_word, float new_x_ht,
                                    WERD_RES* word, WERD_RES* new_word) {
@@ -31,6 +31,16 @@ static float convert_prob_to_tess_certainty(float prob) {
   return (prob - 1.0) * 20.0;
 }
 
+/**********************************************************************
+ * convert_conf_to_tess_certainty
+ *
+ * Normalize a word confidence in the range [0.0, 100.0], as reported by
+ * the result iterators, to a tesseract certainty in the range [-20.0, 0.0]
+ **********************************************************************/
+static float convert_conf_to_tess_certainty(float conf) {
+  return (conf - 100.0) / 5.0;
+}
+
 /**********************************************************************
  * char_box_to_tbox
  *
@@ -241,14 +251,22 @@ bool Tesseract::init_cube_objects(bool load_combiner,
 void Tesseract::run_cube_combiner(PAGE_RES *page_res) {
   if (page_res == NULL || tess_cube_combiner_ == NULL)
     return;
+  // Tesseract certainty above which cube is skipped, given by the cube
+  // params or as a word confidence by cube_combiner_run_conf.
+  float combiner_run_thresh;
+  if (cube_combiner_run_conf >= 0.0) {
+    combiner_run_thresh = convert_conf_to_tess_certainty(
+        cube_combiner_run_conf);
+  } else {
+    combiner_run_thresh = static_cast<int>(convert_prob_to_tess_certainty(
+        cube_cntxt_->Params()->CombinerRunThresh()));
+  }
   PAGE_RES_IT page_res_it(page_res);
   // Iterate through the word results and call cube on each word.
   for (page_res_it.restart_page(); page_res_it.word () != NULL;
        page_res_it.forward()) {
     WERD_RES* word = page_res_it.word();
     // Skip cube entirely if tesseract's certainty is greater than threshold.
-    int combiner_run_thresh = convert_prob_to_tess_certainty(
-        cube_cntxt_->Params()->CombinerRunThresh());
     if (word->best_choice->certainty() >= combiner_run_thresh) {
       continue;
     }
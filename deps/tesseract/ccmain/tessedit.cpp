@@ -50,6 +50,9 @@
 #include "globals.h"
 #include "tesseractclass.h"
 #include "params.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 #include          "notdll.h"     //phils nn stuff
 
@@ -204,11 +207,19 @@ bool Tesseract::init_tesseract_lang_data(
 
   // Load Cube objects if necessary.
   if (tessedit_ocr_engine_mode == OEM_CUBE_ONLY) {
-    ASSERT_HOST(init_cube_objects(false, &tessdata_manager));
+    if (!init_cube_objects(false, &tessdata_manager)) {
+      tprintf("Error: Failed to load Cube for language %s\n", lang.string());
+      tessdata_manager.End();
+      return false;
+    }
     if (tessdata_manager_debug_level)
       tprintf("Loaded Cube w/out combiner\n");
   } else if (tessedit_ocr_engine_mode == OEM_TESSERACT_CUBE_COMBINED) {
-    ASSERT_HOST(init_cube_objects(true, &tessdata_manager));
+    if (!init_cube_objects(true, &tessdata_manager)) {
+      tprintf("Error: Failed to load Cube for language %s\n", lang.string());
+      tessdata_manager.End();
+      return false;
+    }
     if (tessdata_manager_debug_level)
       tprintf("Loaded Cube with combiner\n");
   }
@@ -263,6 +274,35 @@ void Tesseract::ParseLanguageString(const char* lang_str,
   }
 }
 
+// Engines are set up one at a time, as loading the language data reads
+// and writes global state. Every engine goes through init_tesseract() or
+// init_tesseract_lm(): those of TessBaseAPI::Init(), the OSD and equation
+// detection engines and the parallel pass 1 helpers.
+#ifdef _WIN32
+static HANDLE init_mutex = CreateMutex(NULL, FALSE, NULL);
+#else
+static pthread_mutex_t init_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// Holds init_mutex for as long as it lives.
+class InitLock {
+ public:
+  InitLock() {
+#ifdef _WIN32
+    WaitForSingleObject(init_mutex, INFINITE);
+#else
+    pthread_mutex_lock(&init_mutex);
+#endif
+  }
+  ~InitLock() {
+#ifdef _WIN32
+    ReleaseMutex(init_mutex);
+#else
+    pthread_mutex_unlock(&init_mutex);
+#endif
+  }
+};
+
 // Initialize for potentially a set of languages defined by the language
 // string and recursively any additional languages required by any language
 // traineddata file (via tessedit_load_sublangs in its config) that is loaded.
@@ -273,6 +313,7 @@ int Tesseract::init_tesseract(
     const GenericVector<STRING> *vars_vec,
     const GenericVector<STRING> *vars_values,
     bool set_only_non_debug_params) {
+  InitLock lock;
   GenericVector<STRING> langs_to_load;
   GenericVector<STRING> langs_not_to_load;
   ParseLanguageString(language, &langs_to_load, &langs_not_to_load);
@@ -420,6 +461,7 @@ void Tesseract::SetupUniversalFontIds() {
 int Tesseract::init_tesseract_lm(const char *arg0,
                    const char *textbase,
                    const char *language) {
+  InitLock lock;
   if (!init_tesseract_lang_data(arg0, textbase, language, OEM_TESSERACT_ONLY,
                                 NULL, 0, NULL, NULL, false))
     return -1;
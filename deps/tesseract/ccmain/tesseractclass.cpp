@@ -163,6 +163,14 @@ Tesseract::Tesseract()
     INT_MEMBER(paragraph_debug_level, 0, "Print paragraph debug info.",
                this->params()),
     INT_MEMBER(cube_debug_level, 0, "Print cube debug info.", this->params()),
+    double_MEMBER(cube_combiner_run_conf, -1.0,
+                  "Run the cube combiner only on words with a lower confidence"
+                  " (0-100); negative to use the cube params threshold",
+                  this->params()),
+    INT_MEMBER(tessedit_pass1_threads, 1,
+               "Number of threads classifying the words of a page in pass 1;"
+               " above 1 loads a helper engine per extra thread",
+               this->params()),
     STRING_MEMBER(outlines_odd, "%| ", "Non standard number of outlines",
                   this->params()),
     STRING_MEMBER(outlines_2, "ij!?%\":;",
@@ -389,6 +397,7 @@ Tesseract::Tesseract()
     deskew_(1.0f, 0.0f),
     reskew_(1.0f, 0.0f),
     most_recently_used_(this),
+    defer_pass1_learning_(false),
     font_table_size_(0),
     cube_cntxt_(NULL),
     tess_cube_combiner_(NULL),
@@ -399,6 +408,7 @@ Tesseract::~Tesseract() {
   Clear();
   end_tesseract();
   sub_langs_.delete_data_pointers();
+  pass1_helpers_.delete_data_pointers();
   // Delete cube objects.
   if (cube_cntxt_ != NULL) {
     delete cube_cntxt_;
@@ -422,6 +432,8 @@ void Tesseract::Clear() {
   ResetFeaturesHaveBeenExtracted();
   for (int i = 0; i < sub_langs_.size(); ++i)
     sub_langs_[i]->Clear();
+  for (int i = 0; i < pass1_helpers_.size(); ++i)
+    pass1_helpers_[i]->Clear();
 }
 
 void Tesseract::SetEquationDetect(EquationDetect* detector) {
@@ -456,6 +468,81 @@ void Tesseract::SetBlackAndWhitelist() {
   }
 }
 
+// Helpers are loaded with the init parameters of this, but without cube as
+// they only ever run the pass 1 of the Tesseract classifier. The other
+// parameters are copied by index, which works as all the engines register
+// the same parameters in the same order.
+void Tesseract::SetupPass1Helpers(int helper_count) {
+  ParamsVectors* params = this->params();
+  while (pass1_helpers_.size() < helper_count) {
+    GenericVector<STRING> vars_vec;
+    GenericVector<STRING> vars_values;
+    for (int i = 0; i < params->int_params.size(); ++i) {
+      if (params->int_params[i]->is_init())
+        vars_vec.push_back(params->int_params[i]->name_str());
+    }
+    for (int i = 0; i < params->bool_params.size(); ++i) {
+      if (params->bool_params[i]->is_init())
+        vars_vec.push_back(params->bool_params[i]->name_str());
+    }
+    for (int i = 0; i < params->string_params.size(); ++i) {
+      if (params->string_params[i]->is_init())
+        vars_vec.push_back(params->string_params[i]->name_str());
+    }
+    for (int i = 0; i < params->double_params.size(); ++i) {
+      if (params->double_params[i]->is_init())
+        vars_vec.push_back(params->double_params[i]->name_str());
+    }
+    for (int i = 0; i < vars_vec.size(); ++i) {
+      STRING value;
+      ParamUtils::GetParamAsString(vars_vec[i].string(), params, &value);
+      vars_values.push_back(value);
+    }
+    Tesseract* helper = new Tesseract;
+    if (helper->init_tesseract(datadir.string(), NULL, lang.string(),
+                               OEM_TESSERACT_ONLY, NULL, 0,
+                               &vars_vec, &vars_values, false) < 0) {
+      delete helper;
+      break;
+    }
+    pass1_helpers_.push_back(helper);
+  }
+  // Helpers left over from pages with more words are not used by this one.
+  for (int h = 0; h < helper_count && h < pass1_helpers_.size(); ++h) {
+    Tesseract* helper = pass1_helpers_[h];
+    ParamsVectors* helper_params = helper->params();
+    ASSERT_HOST(helper_params->int_params.size() == params->int_params.size());
+    for (int i = 0; i < params->int_params.size(); ++i) {
+      if (!params->int_params[i]->is_init())
+        helper_params->int_params[i]->set_value(*params->int_params[i]);
+    }
+    for (int i = 0; i < params->bool_params.size(); ++i) {
+      if (!params->bool_params[i]->is_init())
+        helper_params->bool_params[i]->set_value(*params->bool_params[i]);
+    }
+    for (int i = 0; i < params->string_params.size(); ++i) {
+      if (!params->string_params[i]->is_init())
+        helper_params->string_params[i]->set_value(*params->string_params[i]);
+    }
+    for (int i = 0; i < params->double_params.size(); ++i) {
+      if (!params->double_params[i]->is_init())
+        helper_params->double_params[i]->set_value(*params->double_params[i]);
+    }
+    helper->SetBlackAndWhitelist();
+    pixDestroy(&helper->pix_binary_);
+    if (pix_binary_ != NULL)
+      helper->pix_binary_ = pixClone(pix_binary_);
+    pixDestroy(&helper->cube_binary_);
+    if (cube_binary_ != NULL)
+      helper->cube_binary_ = pixClone(cube_binary_);
+    pixDestroy(&helper->pix_grey_);
+    if (pix_grey_ != NULL)
+      helper->pix_grey_ = pixClone(pix_grey_);
+    helper->source_resolution_ = source_resolution_;
+    helper->CopyAdaptedTemplatesFrom(*this);
+  }
+}
+
 // Perform steps to prepare underlying binary image/other data structures for
 // page segmentation.
 void Tesseract::PrepareForPageseg() {
@@ -33,6 +33,7 @@
 
 class PAGE_RES;
 class PAGE_RES_IT;
+class Pass1Stop;
 class BLOCK_LIST;
 class CharSamp;
 class TO_BLOCK_LIST;
@@ -222,6 +223,11 @@ class Tesseract : public Wordrec {
 
   void SetBlackAndWhitelist();
 
+  // Makes sure there are helper_count pass-1 helper engines, and gives the
+  // first helper_count of them the current parameters, images and adapted
+  // templates of this.
+  void SetupPass1Helpers(int helper_count);
+
   // Perform steps to prepare underlying binary image/other data structures for
   // page segmentation. Uses the strategy specified in the global variable
   // pageseg_devanagari_split_strategy for perform splitting while preparing for
@@ -268,6 +274,20 @@ class Tesseract : public Wordrec {
   void classify_word_and_language(WordRecognizer recognizer,
                                   BLOCK* block, ROW *row, WERD_RES *word);
   void classify_word_pass1(BLOCK* block, ROW *row, WERD_RES *word);
+  // Sends a word accepted by pass 1 to the adaptive classifier and the
+  // document dictionary.
+  void learn_word_pass1(WERD_RES *word, BLOB_CHOICE_LIST_CLIST *blob_choices);
+  // Classifies word_count words from it on with pass 1, without learning,
+  // until stop is set or monitor asks to stop.
+  void classify_pass1_words(PAGE_RES_IT* it, int word_count,
+                            ETEXT_DESC* monitor, bool poll_cancel,
+                            Pass1Stop* stop);
+  // Classifies all the words of the page with pass 1 on thread_count threads,
+  // this and thread_count - 1 helper engines each taking a contiguous run of
+  // words. Every run checks the deadline of monitor, and the run of this
+  // also its cancel function. Returns false if they stopped the pass.
+  bool classify_page_pass1_parallel(PAGE_RES* page_res, int thread_count,
+                                    ETEXT_DESC* monitor);
   void recog_pseudo_word(PAGE_RES* page_res,  // blocks to check
                          TBOX &selection_box);
 
@@ -749,6 +769,12 @@ class Tesseract : public Wordrec {
   double_VAR_H(test_pt_y, 99999.99, "ycoord");
   INT_VAR_H(paragraph_debug_level, 0, "Print paragraph debug info.");
   INT_VAR_H(cube_debug_level, 1, "Print cube debug info.");
+  double_VAR_H(cube_combiner_run_conf, -1.0,
+               "Run the cube combiner only on words with a lower confidence"
+               " (0-100); negative to use the cube params threshold");
+  INT_VAR_H(tessedit_pass1_threads, 1,
+            "Number of threads classifying the words of a page in pass 1;"
+            " above 1 loads a helper engine per extra thread");
   STRING_VAR_H(outlines_odd, "%| ", "Non standard number of outlines");
   STRING_VAR_H(outlines_2, "ij!?%\":;", "Non standard number of outlines");
   BOOL_VAR_H(docqual_excuse_outline_errs, false,
@@ -947,6 +973,11 @@ class Tesseract : public Wordrec {
   // Most recently used Tesseract out of this and sub_langs_. The default
   // language for the next word.
   Tesseract* most_recently_used_;
+  // Engines of the same language that classify words of a page in parallel
+  // with this during pass 1. Created on demand by SetupPass1Helpers.
+  GenericVector<Tesseract*> pass1_helpers_;
+  // If true, classify_word_pass1 leaves the learning to the caller.
+  bool defer_pass1_learning_;
   // The size of the font table, ie max possible font id + 1.
   int font_table_size_;
   // Cube objects.
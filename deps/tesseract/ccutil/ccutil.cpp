@@ -32,6 +32,14 @@ CCUtilMutex::CCUtilMutex() {
 #endif
 }
 
+CCUtilMutex::~CCUtilMutex() {
+#ifdef _WIN32
+  CloseHandle(mutex_);
+#else
+  pthread_mutex_destroy(&mutex_);
+#endif
+}
+
 void CCUtilMutex::Lock() {
 #ifdef _WIN32
   WaitForSingleObject(mutex_, INFINITE);
@@ -38,6 +38,7 @@ namespace tesseract {
 class CCUtilMutex {
  public:
   CCUtilMutex();
+  ~CCUtilMutex();
 
   void Lock();
 
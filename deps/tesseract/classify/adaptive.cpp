@@ -29,6 +29,11 @@
 #include <assert.h>
 #endif
 #include <stdio.h>
+#include <string.h>
+
+/* Start of adapted templates in the format written by
+   WriteAdaptedTemplates ("adt1"); older versions wrote none. */
+#define ADAPTED_TEMPLATES_FORMAT 0x61647431
 
 /*----------------------------------------------------------------------------
               Public Code
@@ -306,49 +311,79 @@ void Classify::PrintAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates) {
  * a ptr to the adapted class.
  *
  * @param File  open file to read adapted class from
- * @return Ptr to new adapted class.
+ * @return Ptr to new adapted class, or NULL if File ends
+ * before the class does or holds an invalid class.
  *
  * @note Globals: none
  * @note Exceptions: none
  * @note History: Tue Mar 19 14:11:01 1991, DSJ, Created.
  */
 ADAPT_CLASS ReadAdaptedClass(FILE *File) {
-  int NumTempProtos;
-  int NumConfigs;
+  int NumTempProtos = 0;
+  int NumConfigs = 0;
   int i;
   ADAPT_CLASS Class;
   TEMP_PROTO TempProto;
 
   /* first read high level adapted class structure */
   Class = (ADAPT_CLASS) Emalloc (sizeof (ADAPT_CLASS_STRUCT));
-  fread ((char *) Class, sizeof (ADAPT_CLASS_STRUCT), 1, File);
+  if (fread ((char *) Class, sizeof (ADAPT_CLASS_STRUCT), 1, File) != 1) {
+    Efree(Class);
+    return NULL;
+  }
+  /* the pointers of the writer mean nothing here */
+  for (i = 0; i < MAX_NUM_CONFIGS; i++)
+    TempConfigFor (Class, i) = NULL;
+  Class->TempProtos = NIL_LIST;
 
   /* then read in the definitions of the permanent protos and configs */
   Class->PermProtos = NewBitVector (MAX_NUM_PROTOS);
   Class->PermConfigs = NewBitVector (MAX_NUM_CONFIGS);
-  fread ((char *) Class->PermProtos, sizeof (uinT32),
-    WordsInVectorOfSize (MAX_NUM_PROTOS), File);
-  fread ((char *) Class->PermConfigs, sizeof (uinT32),
-    WordsInVectorOfSize (MAX_NUM_CONFIGS), File);
+  if (fread ((char *) Class->PermProtos, sizeof (uinT32),
+             WordsInVectorOfSize (MAX_NUM_PROTOS), File) !=
+      WordsInVectorOfSize (MAX_NUM_PROTOS) ||
+      fread ((char *) Class->PermConfigs, sizeof (uinT32),
+             WordsInVectorOfSize (MAX_NUM_CONFIGS), File) !=
+      WordsInVectorOfSize (MAX_NUM_CONFIGS)) {
+    free_adapted_class(Class);
+    return NULL;
+  }
 
   /* then read in the list of temporary protos */
-  fread ((char *) &NumTempProtos, sizeof (int), 1, File);
-  Class->TempProtos = NIL_LIST;
+  if (fread ((char *) &NumTempProtos, sizeof (int), 1, File) != 1 ||
+      NumTempProtos < 0 || NumTempProtos > MAX_NUM_PROTOS) {
+    free_adapted_class(Class);
+    return NULL;
+  }
   for (i = 0; i < NumTempProtos; i++) {
     TempProto =
       (TEMP_PROTO) alloc_struct (sizeof (TEMP_PROTO_STRUCT),
       "TEMP_PROTO_STRUCT");
-    fread ((char *) TempProto, sizeof (TEMP_PROTO_STRUCT), 1, File);
+    if (fread ((char *) TempProto, sizeof (TEMP_PROTO_STRUCT), 1,
+               File) != 1 || TempProto->ProtoId >= MAX_NUM_PROTOS) {
+      FreeTempProto(TempProto);
+      free_adapted_class(Class);
+      return NULL;
+    }
     Class->TempProtos = push_last (Class->TempProtos, TempProto);
   }
 
   /* then read in the adapted configs */
-  fread ((char *) &NumConfigs, sizeof (int), 1, File);
-  for (i = 0; i < NumConfigs; i++)
+  if (fread ((char *) &NumConfigs, sizeof (int), 1, File) != 1 ||
+      NumConfigs < 0 || NumConfigs > MAX_NUM_CONFIGS) {
+    free_adapted_class(Class);
+    return NULL;
+  }
+  for (i = 0; i < NumConfigs; i++) {
     if (test_bit (Class->PermConfigs, i))
       Class->Config[i].Perm = ReadPermConfig (File);
     else
       Class->Config[i].Temp = ReadTempConfig (File);
+    if (TempConfigFor (Class, i) == NULL) {
+      free_adapted_class(Class);
+      return NULL;
+    }
+  }
 
   return (Class);
 
@@ -362,7 +397,9 @@ namespace tesseract {
  * a ptr to the templates.
  *
  * @param File  open text file to read adapted templates from
- * @return Ptr to adapted templates read from File.
+ * @return Ptr to adapted templates read from File, or NULL if
+ * File holds templates of another format, ends before the
+ * templates do or holds invalid templates.
  *
  * @note Globals: none
  * @note Exceptions: none
@@ -370,18 +407,56 @@ namespace tesseract {
  */
 ADAPT_TEMPLATES Classify::ReadAdaptedTemplates(FILE *File) {
   int i;
+  inT32 Format;
   ADAPT_TEMPLATES Templates;
 
+  if (fread (&Format, sizeof (Format), 1, File) != 1 ||
+      Format != ADAPTED_TEMPLATES_FORMAT) {
+    tprintf ("Error: Adapted templates have an unknown format\n");
+    return NULL;
+  }
+
   /* first read the high level adaptive template struct */
   Templates = (ADAPT_TEMPLATES) Emalloc (sizeof (ADAPT_TEMPLATES_STRUCT));
-  fread ((char *) Templates, sizeof (ADAPT_TEMPLATES_STRUCT), 1, File);
+  if (fread ((char *) Templates, sizeof (ADAPT_TEMPLATES_STRUCT), 1,
+             File) != 1) {
+    Efree(Templates);
+    return NULL;
+  }
 
   /* then read in the basic integer templates */
-  Templates->Templates = ReadIntTemplates (File);
+  Templates->Templates = ReadAdaptedIntTemplates (File);
+  if (Templates->Templates == NULL) {
+    Efree(Templates);
+    return NULL;
+  }
 
   /* then read in the adaptive info for each class */
   for (i = 0; i < (Templates->Templates)->NumClasses; i++) {
     Templates->Class[i] = ReadAdaptedClass (File);
+    if (Templates->Class[i] == NULL) {
+      while (--i >= 0)
+        free_adapted_class (Templates->Class[i]);
+      free_int_templates (Templates->Templates);
+      Efree(Templates);
+      return NULL;
+    }
+  }
+
+  /* ambiguities must name classes of these templates */
+  for (i = 0; i < (Templates->Templates)->NumClasses; i++) {
+    ADAPT_CLASS Class = Templates->Class[i];
+    for (int c = 0; c < MAX_NUM_CONFIGS; c++) {
+      if (!ConfigIsPermanent (Class, c) || PermConfigFor (Class, c) == NULL)
+        continue;
+      for (UNICHAR_ID *Ambig = PermConfigFor (Class, c)->Ambigs;
+           *Ambig > 0; Ambig++) {
+        if (*Ambig >= (Templates->Templates)->NumClasses) {
+          free_adapted_templates(Templates);
+          return NULL;
+        }
+      }
+    }
   }
   return (Templates);
 
@@ -395,21 +470,31 @@ ADAPT_TEMPLATES Classify::ReadAdaptedTemplates(FILE *File) {
  * and return a ptr to it.
  *
  * @param File  open file to read permanent config from
- * @return Ptr to new permanent configuration description.
+ * @return Ptr to new permanent configuration description, or
+ * NULL if File ends before it does or holds an invalid one.
  *
  * @note Globals: none
  * @note Exceptions: none
  * @note History: Tue Mar 19 14:25:26 1991, DSJ, Created.
  */
 PERM_CONFIG ReadPermConfig(FILE *File) {
+  uinT8 NumAmbigs;
+  if (fread ((char *) &NumAmbigs, sizeof(uinT8), 1, File) != 1)
+    return NULL;
   PERM_CONFIG Config = (PERM_CONFIG) alloc_struct(sizeof(PERM_CONFIG_STRUCT),
                                                   "PERM_CONFIG_STRUCT");
-  uinT8 NumAmbigs;
-  fread ((char *) &NumAmbigs, sizeof(uinT8), 1, File);
   Config->Ambigs = (UNICHAR_ID *)Emalloc(sizeof(UNICHAR_ID) * (NumAmbigs + 1));
-  fread(Config->Ambigs, sizeof(UNICHAR_ID), NumAmbigs, File);
+  bool Ok = fread(Config->Ambigs, sizeof(UNICHAR_ID), NumAmbigs,
+                  File) == NumAmbigs &&
+            fread(&(Config->FontinfoId), sizeof(int), 1, File) == 1;
+  /* WritePermConfig stops at the first ambiguity that is no class */
+  for (int i = 0; Ok && i < NumAmbigs; i++)
+    Ok = Config->Ambigs[i] > 0 && Config->Ambigs[i] < MAX_NUM_CLASSES;
   Config->Ambigs[NumAmbigs] = -1;
-  fread(&(Config->FontinfoId), sizeof(int), 1, File);
+  if (!Ok) {
+    FreePermConfig(Config);
+    return NULL;
+  }
 
   return (Config);
 
@@ -422,7 +507,8 @@ PERM_CONFIG ReadPermConfig(FILE *File) {
  * and return a ptr to it.
  *
  * @param File  open file to read temporary config from
- * @return Ptr to new temporary configuration description.
+ * @return Ptr to new temporary configuration description, or
+ * NULL if File ends before it does or holds an invalid one.
  *
  * @note Globals: none
  * @note Exceptions: none
@@ -434,11 +520,20 @@ TEMP_CONFIG ReadTempConfig(FILE *File) {
   Config =
     (TEMP_CONFIG) alloc_struct (sizeof (TEMP_CONFIG_STRUCT),
     "TEMP_CONFIG_STRUCT");
-  fread ((char *) Config, sizeof (TEMP_CONFIG_STRUCT), 1, File);
+  if (fread ((char *) Config, sizeof (TEMP_CONFIG_STRUCT), 1, File) != 1 ||
+      Config->ProtoVectorSize > WordsInVectorOfSize (MAX_NUM_PROTOS)) {
+    free_struct (Config, sizeof (TEMP_CONFIG_STRUCT), "TEMP_CONFIG_STRUCT");
+    return NULL;
+  }
+  /* contexts are not written, see WriteTempConfig */
+  Config->ContextsSeen = NIL_LIST;
 
   Config->Protos = NewBitVector (Config->ProtoVectorSize * BITSINLONG);
-  fread ((char *) Config->Protos, sizeof (uinT32),
-    Config->ProtoVectorSize, File);
+  if (fread ((char *) Config->Protos, sizeof (uinT32),
+             Config->ProtoVectorSize, File) != Config->ProtoVectorSize) {
+    FreeTempConfig(Config);
+    return NULL;
+  }
 
   return (Config);
 
@@ -506,12 +601,15 @@ namespace tesseract {
  */
 void Classify::WriteAdaptedTemplates(FILE *File, ADAPT_TEMPLATES Templates) {
   int i;
+  inT32 Format = ADAPTED_TEMPLATES_FORMAT;
+
+  fwrite (&Format, sizeof (Format), 1, File);
 
   /* first write the high level adaptive template struct */
   fwrite ((char *) Templates, sizeof (ADAPT_TEMPLATES_STRUCT), 1, File);
 
   /* then write out the basic integer templates */
-  WriteIntTemplates (File, Templates->Templates, unicharset);
+  WriteAdaptedIntTemplates (File, Templates->Templates);
 
   /* then write out the adaptive info for each class */
   for (i = 0; i < (Templates->Templates)->NumClasses; i++) {
@@ -568,3 +666,103 @@ void WriteTempConfig(FILE *File, TEMP_CONFIG Config) {
     Config->ProtoVectorSize, File);
 
 }                                /* WriteTempConfig */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine makes a deep copy of an adapted class. Only
+ * the first NumConfigs configs are copied, as by
+ * WriteAdaptedClass and ReadAdaptedClass.
+ *
+ * @param Class   adapted class to copy
+ * @param NumConfigs  number of configs in Class
+ * @return Ptr to the copy of Class.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+static ADAPT_CLASS CopyAdaptedClass(ADAPT_CLASS Class, int NumConfigs) {
+  ADAPT_CLASS Copy;
+  LIST TempProtos;
+  TEMP_PROTO TempProto;
+  int i;
+
+  Copy = (ADAPT_CLASS) Emalloc (sizeof (ADAPT_CLASS_STRUCT));
+  memcpy (Copy, Class, sizeof (ADAPT_CLASS_STRUCT));
+  for (i = 0; i < MAX_NUM_CONFIGS; i++)
+    TempConfigFor (Copy, i) = NULL;
+
+  Copy->PermProtos = NewBitVector (MAX_NUM_PROTOS);
+  Copy->PermConfigs = NewBitVector (MAX_NUM_CONFIGS);
+  copy_all_bits (Class->PermProtos, Copy->PermProtos,
+    WordsInVectorOfSize (MAX_NUM_PROTOS));
+  copy_all_bits (Class->PermConfigs, Copy->PermConfigs,
+    WordsInVectorOfSize (MAX_NUM_CONFIGS));
+
+  Copy->TempProtos = NIL_LIST;
+  TempProtos = Class->TempProtos;
+  iterate (TempProtos) {
+    TempProto = NewTempProto ();
+    memcpy (TempProto, first_node (TempProtos), sizeof (TEMP_PROTO_STRUCT));
+    Copy->TempProtos = push_last (Copy->TempProtos, TempProto);
+  }
+
+  for (i = 0; i < NumConfigs; i++) {
+    if (test_bit (Class->PermConfigs, i)) {
+      PERM_CONFIG Config = Class->Config[i].Perm;
+      PERM_CONFIG ConfigCopy =
+        (PERM_CONFIG) alloc_struct (sizeof (PERM_CONFIG_STRUCT),
+        "PERM_CONFIG_STRUCT");
+      int NumAmbigs = 0;
+      while (Config->Ambigs[NumAmbigs] > 0) ++NumAmbigs;
+      ConfigCopy->Ambigs =
+        (UNICHAR_ID *) Emalloc (sizeof (UNICHAR_ID) * (NumAmbigs + 1));
+      memcpy (ConfigCopy->Ambigs, Config->Ambigs,
+        sizeof (UNICHAR_ID) * NumAmbigs);
+      ConfigCopy->Ambigs[NumAmbigs] = -1;
+      ConfigCopy->FontinfoId = Config->FontinfoId;
+      Copy->Config[i].Perm = ConfigCopy;
+    } else {
+      TEMP_CONFIG Config = Class->Config[i].Temp;
+      TEMP_CONFIG ConfigCopy =
+        (TEMP_CONFIG) alloc_struct (sizeof (TEMP_CONFIG_STRUCT),
+        "TEMP_CONFIG_STRUCT");
+      memcpy (ConfigCopy, Config, sizeof (TEMP_CONFIG_STRUCT));
+      ConfigCopy->ContextsSeen = NIL_LIST;
+      ConfigCopy->Protos = NewBitVector (Config->ProtoVectorSize * BITSINLONG);
+      copy_all_bits (Config->Protos, ConfigCopy->Protos,
+        Config->ProtoVectorSize);
+      Copy->Config[i].Temp = ConfigCopy;
+    }
+  }
+  return (Copy);
+
+}                                /* CopyAdaptedClass */
+
+
+/*---------------------------------------------------------------------------*/
+/**
+ * This routine makes a deep copy of Templates in memory,
+ * with the same result as writing them with
+ * WriteAdaptedTemplates and reading them back.
+ *
+ * @param Templates set of adapted templates to copy
+ * @return Ptr to the copy of Templates.
+ *
+ * @note Globals: none
+ * @note Exceptions: none
+ */
+ADAPT_TEMPLATES CopyAdaptedTemplates(ADAPT_TEMPLATES Templates) {
+  ADAPT_TEMPLATES Copy;
+  int i;
+
+  Copy = (ADAPT_TEMPLATES) Emalloc (sizeof (ADAPT_TEMPLATES_STRUCT));
+  memcpy (Copy, Templates, sizeof (ADAPT_TEMPLATES_STRUCT));
+  Copy->Templates = CopyAdaptedIntTemplates (Templates->Templates);
+  for (i = 0; i < (Templates->Templates)->NumClasses; i++) {
+    Copy->Class[i] = CopyAdaptedClass (Templates->Class[i],
+      Templates->Templates->Class[i]->NumConfigs);
+  }
+  return (Copy);
+
+}                                /* CopyAdaptedTemplates */
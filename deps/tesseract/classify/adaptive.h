@@ -138,4 +138,6 @@ void WritePermConfig(FILE *File, PERM_CONFIG Config);
 
 void WriteTempConfig(FILE *File, TEMP_CONFIG Config);
 
+ADAPT_TEMPLATES CopyAdaptedTemplates(ADAPT_TEMPLATES Templates);
+
 #endif
@@ -66,6 +66,8 @@
 #endif
 
 #define ADAPT_TEMPLATE_SUFFIX ".a"
+// Start of the templates written by SaveAdaptedTemplates ("tadp").
+#define ADAPTED_TEMPLATES_MAGIC 0x74616470
 
 #define MAX_MATCHES         10
 #define UNLIKELY_NUM_FEAT 200
@@ -98,6 +100,9 @@ struct ADAPT_RESULTS {
 
   /// Initializes data members to the default values. Sets the initial
   /// rating of each class to be the worst possible rating (1.0).
+  /// The match and CPResults arrays are only read up to the counts the
+  /// matchers fill in, so callers allocate with plain new (no value
+  /// initialization) to avoid zeroing ~440KB for every classified blob.
   inline void Initialize() {
      BlobLength = MAX_INT32;
      NumMatches = 0;
@@ -180,7 +185,7 @@ void Classify::AdaptiveClassifier(TBLOB *Blob,
                                   BLOB_CHOICE_LIST *Choices,
                                   CLASS_PRUNER_RESULTS CPResults) {
   assert(Choices != NULL);
-  ADAPT_RESULTS *Results = new ADAPT_RESULTS();
+  ADAPT_RESULTS *Results = new ADAPT_RESULTS;
   Results->Initialize();
 
   if (AdaptedTemplates == NULL)
@@ -620,10 +625,16 @@ void Classify::InitAdaptiveClassifier(bool load_pre_trained_templates) {
       AdaptedTemplates = ReadAdaptedTemplates(File);
       cprintf("\n");
       fclose(File);
-      PrintAdaptedTemplates(stdout, AdaptedTemplates);
+      if (AdaptedTemplates == NULL) {
+        tprintf("Error: Failed to read pre-adapted templates from %s\n",
+                Filename.string());
+        AdaptedTemplates = NewAdaptedTemplates(true);
+      } else {
+        PrintAdaptedTemplates(stdout, AdaptedTemplates);
 
-      for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
-        BaselineCutoffs[i] = CharNormCutoffs[i];
+        for (int i = 0; i < AdaptedTemplates->Templates->NumClasses; i++) {
+          BaselineCutoffs[i] = CharNormCutoffs[i];
+        }
       }
     }
   } else {
@@ -643,6 +654,53 @@ void Classify::ResetAdaptiveClassifierInternal() {
   NumAdaptationsFailed = 0;
 }
 
+// The templates are copied in memory, with the same result as a round trip
+// through WriteAdaptedTemplates and ReadAdaptedTemplates.
+void Classify::CopyAdaptedTemplatesFrom(const Classify& src) {
+  if (AdaptedTemplates != NULL)
+    free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = NULL;
+  NumAdaptationsFailed = src.NumAdaptationsFailed;
+  if (src.AdaptedTemplates != NULL)
+    AdaptedTemplates = CopyAdaptedTemplates(src.AdaptedTemplates);
+  memcpy(BaselineCutoffs, src.BaselineCutoffs,
+         sizeof(BaselineCutoffs[0]) * MAX_NUM_CLASSES);
+}
+
+// The adapted templates are prefixed with a magic number and the size of
+// the unicharset, so that LoadAdaptedTemplates can refuse templates that
+// belong to another language.
+void Classify::SaveAdaptedTemplates(FILE *File) {
+  if (AdaptedTemplates == NULL)
+    AdaptedTemplates = NewAdaptedTemplates(true);
+  inT32 header[2] = { ADAPTED_TEMPLATES_MAGIC, unicharset.size() };
+  fwrite(header, sizeof(header[0]), 2, File);
+  WriteAdaptedTemplates(File, AdaptedTemplates);
+}
+
+bool Classify::LoadAdaptedTemplates(FILE *File) {
+  inT32 header[2];
+  if (fread(header, sizeof(header[0]), 2, File) != 2 ||
+      header[0] != ADAPTED_TEMPLATES_MAGIC || header[1] != unicharset.size())
+    return false;
+  ADAPT_TEMPLATES Templates = ReadAdaptedTemplates(File);
+  if (Templates == NULL)
+    return false;
+  if (Templates->Templates->NumClasses != unicharset.size()) {
+    free_adapted_templates(Templates);
+    return false;
+  }
+  if (AdaptedTemplates != NULL)
+    free_adapted_templates(AdaptedTemplates);
+  AdaptedTemplates = Templates;
+  NumAdaptationsFailed = 0;
+  for (int i = 0; i < MAX_NUM_CLASSES; i++) {
+    BaselineCutoffs[i] = i < Templates->Templates->NumClasses ?
+        CharNormCutoffs[i] : 0;
+  }
+  return true;
+}
+
 
 /*---------------------------------------------------------------------------*/
 /**
@@ -1084,7 +1142,7 @@ void Classify::AdaptToPunc(TBLOB *Blob,
                            CLASS_ID ClassId,
                            int FontinfoId,
                            FLOAT32 Threshold) {
-  ADAPT_RESULTS *Results = new ADAPT_RESULTS();
+  ADAPT_RESULTS *Results = new ADAPT_RESULTS;
   int i;
 
   Results->Initialize();
@@ -1532,7 +1590,7 @@ int Classify::CharNormTrainingSample(bool pruner_only,
                                      const TrainingSample& sample,
                                      GenericVector<ShapeRating>* results) {
   results->clear();
-  ADAPT_RESULTS* adapt_results = new ADAPT_RESULTS();
+  ADAPT_RESULTS* adapt_results = new ADAPT_RESULTS;
   adapt_results->Initialize();
   // Compute the bounding box of the features.
   int num_features = sample.num_features();
@@ -1898,7 +1956,7 @@ void Classify::GetAdaptThresholds(TWERD * Word,
 UNICHAR_ID *Classify::GetAmbiguities(TBLOB *Blob,
                                      const DENORM& denorm,
                                      CLASS_ID CorrectClass) {
-  ADAPT_RESULTS *Results = new ADAPT_RESULTS();
+  ADAPT_RESULTS *Results = new ADAPT_RESULTS;
   UNICHAR_ID *Ambiguities;
   int i;
 
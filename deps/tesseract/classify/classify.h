@@ -289,6 +289,15 @@ class Classify : public CCStruct {
                           CLASS_PRUNER_RESULTS cp_results);
   void ClassifyAsNoise(ADAPT_RESULTS *Results);
   void ResetAdaptiveClassifierInternal();
+  // Replaces the adapted templates with a copy of those of src, which must
+  // use the same unicharset, so that this matches what src has learned.
+  void CopyAdaptedTemplatesFrom(const Classify& src);
+  // Writes the adapted templates to File for LoadAdaptedTemplates.
+  void SaveAdaptedTemplates(FILE *File);
+  // Replaces the adapted templates with those written by
+  // SaveAdaptedTemplates to File. Returns false and keeps the current
+  // templates if File does not hold templates for this unicharset.
+  bool LoadAdaptedTemplates(FILE *File);
 
   int GetBaselineFeatures(TBLOB *Blob,
                           const DENORM& denorm,
@@ -35,6 +35,9 @@
 #include "classify.h"
 #include "shapetable.h"
 #include <math.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /*----------------------------------------------------------------------------
                     Global Data Definitions and Declarations
@@ -142,6 +145,9 @@ class ClassPruner {
   void ComputeScores(const INT_TEMPLATES_STRUCT* int_templates,
                      int num_features, const INT_FEATURE_STRUCT* features) {
     num_features_ = num_features;
+#ifdef __SSE2__
+    ComputeScoresSSE2(int_templates, num_features, features);
+#else
     int num_pruners = int_templates->NumClassPruners;
     for (int f = 0; f < num_features; ++f) {
       const INT_FEATURE_STRUCT* feature = &features[f];
@@ -203,8 +209,63 @@ class ClassPruner {
         }
       }
     }
+#endif
+  }
+
+#ifdef __SSE2__
+  // Same as ComputeScores, 16 classes per vector addition. The 2-bit
+  // weights of a pruner are split by their position in each byte into two
+  // vectors of 16 byte counters, which are added to class_count_ before
+  // they could overflow.
+  void ComputeScoresSSE2(const INT_TEMPLATES_STRUCT* int_templates,
+                         int num_features,
+                         const INT_FEATURE_STRUCT* features) {
+    // Each feature adds at most CLASS_PRUNER_CLASS_MASK to a counter.
+    const int kMaxFeaturesPerFlush = 255 / CLASS_PRUNER_CLASS_MASK;
+    const __m128i mask = _mm_set1_epi8(CLASS_PRUNER_CLASS_MASK);
+    int num_pruners = int_templates->NumClassPruners;
+    __m128i counts[2 * MAX_NUM_CLASS_PRUNERS];
+    memset(counts, 0, num_pruners * 2 * sizeof(counts[0]));
+    for (int f = 0; f < num_features; ++f) {
+      const INT_FEATURE_STRUCT* feature = &features[f];
+      int x = feature->X * NUM_CP_BUCKETS >> 8;
+      int y = feature->Y * NUM_CP_BUCKETS >> 8;
+      int theta = feature->Theta * NUM_CP_BUCKETS >> 8;
+      for (int pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
+        __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(
+            int_templates->ClassPruners[pruner_set]->p[x][y][theta]));
+        // Weights 0 and 1 of each byte in one vector, 2 and 3 in the other.
+        __m128i low = _mm_unpacklo_epi64(
+            words, _mm_srli_epi16(words, NUM_BITS_PER_CLASS));
+        __m128i high = _mm_srli_epi16(low, 2 * NUM_BITS_PER_CLASS);
+        counts[2 * pruner_set] = _mm_add_epi8(counts[2 * pruner_set],
+                                              _mm_and_si128(low, mask));
+        counts[2 * pruner_set + 1] = _mm_add_epi8(counts[2 * pruner_set + 1],
+                                                  _mm_and_si128(high, mask));
+      }
+      if ((f + 1) % kMaxFeaturesPerFlush == 0 || f + 1 == num_features)
+        FlushPackedCounts(num_pruners, reinterpret_cast<uinT8*>(counts));
+    }
   }
 
+  // Adds the byte counters of ComputeScoresSSE2 to class_count_ and clears
+  // them. Byte b of the first vector of a pruner holds weight b / 8 of byte
+  // b % 8 of its words, the second vector weights 2 and 3.
+  void FlushPackedCounts(int num_pruners, uinT8* packed_counts) {
+    const int kClassesPerByte = 8 / NUM_BITS_PER_CLASS;
+    for (int pruner_set = 0; pruner_set < num_pruners; ++pruner_set) {
+      uinT8* counts = packed_counts + pruner_set * CLASSES_PER_CP;
+      int* class_count = class_count_ + pruner_set * CLASSES_PER_CP;
+      for (int b = 0; b < CLASSES_PER_CP; ++b) {
+        int byte = b % 8;
+        int weight = b / 8 % 2 + b / 16 * 2;
+        class_count[byte * kClassesPerByte + weight] += counts[b];
+      }
+      memset(counts, 0, CLASSES_PER_CP);
+    }
+  }
+#endif
+
   // Adjusts the scores according to the number of expected features. Used
   // in lieu of a constant bias, this penalizes classes that expect more
   // features than there are present. Thus an actual c will score higher for c
@@ -803,6 +864,71 @@ void IMDebugConfigurationSum(int FeatureNum,
 
 
 
+#ifdef __SSE2__
+// A proto evidence row of MAX_PROTO_INDEX (24) bytes is handled as a low
+// vector of 16 and a high one of 8 bytes. Sets the masks of the first
+// length bytes.
+static inline void ProtoRowMasks(int length, __m128i* low, __m128i* high) {
+  const __m128i index_low = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7,
+                                          8, 9, 10, 11, 12, 13, 14, 15);
+  const __m128i index_high = _mm_setr_epi8(16, 17, 18, 19, 20, 21, 22, 23,
+                                           24, 25, 26, 27, 28, 29, 30, 31);
+  __m128i limit = _mm_set1_epi8(length);
+  *low = _mm_cmpgt_epi8(limit, index_low);
+  *high = _mm_cmpgt_epi8(limit, index_high);
+}
+
+// Same as the insertion loop of UpdateTablesForFeature: inserts evidence
+// into the row, which is sorted in descending order, after the entries
+// that are not smaller and drops the last of the length entries.
+static inline void InsertProtoEvidence(uinT8* row, int length,
+                                       uinT8 evidence) {
+  __m128i mask_low, mask_high;
+  ProtoRowMasks(length, &mask_low, &mask_high);
+  __m128i low = _mm_loadu_si128(reinterpret_cast<__m128i*>(row));
+  __m128i high = _mm_loadl_epi64(reinterpret_cast<__m128i*>(row + 16));
+  __m128i value = _mm_set1_epi8(evidence);
+  // Entries smaller than evidence move one place up.
+  __m128i smaller_low = _mm_andnot_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(low, value), low), mask_low);
+  __m128i smaller_high = _mm_andnot_si128(
+      _mm_cmpeq_epi8(_mm_max_epu8(high, value), high), mask_high);
+  __m128i moved_low = _mm_slli_si128(low, 1);
+  __m128i moved_high = _mm_or_si128(_mm_slli_si128(high, 1),
+                                    _mm_srli_si128(low, 15));
+  __m128i after_low = _mm_and_si128(_mm_slli_si128(smaller_low, 1),
+                                    mask_low);
+  __m128i after_high = _mm_and_si128(
+      _mm_or_si128(_mm_slli_si128(smaller_high, 1),
+                   _mm_srli_si128(smaller_low, 15)), mask_high);
+  // The first smaller entry is replaced by evidence, the ones after it by
+  // their predecessors.
+  low = _mm_or_si128(
+      _mm_or_si128(_mm_andnot_si128(smaller_low, low),
+                   _mm_and_si128(after_low, moved_low)),
+      _mm_and_si128(_mm_andnot_si128(after_low, smaller_low), value));
+  high = _mm_or_si128(
+      _mm_or_si128(_mm_andnot_si128(smaller_high, high),
+                   _mm_and_si128(after_high, moved_high)),
+      _mm_and_si128(_mm_andnot_si128(after_high, smaller_high), value));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(row), low);
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(row + 16), high);
+}
+
+// Sum of the first length entries of a proto evidence row.
+static inline int SumProtoEvidence(const uinT8* row, int length) {
+  __m128i mask_low, mask_high;
+  ProtoRowMasks(length, &mask_low, &mask_high);
+  __m128i low = _mm_and_si128(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(row)), mask_low);
+  __m128i high = _mm_and_si128(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + 16)), mask_high);
+  __m128i sums = _mm_add_epi64(_mm_sad_epu8(low, _mm_setzero_si128()),
+                               _mm_sad_epu8(high, _mm_setzero_si128()));
+  return _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+}
+#endif
+
 /*---------------------------------------------------------------------------*/
 int IntegerMatcher::UpdateTablesForFeature(
     INT_CLASS ClassTemplate,
@@ -931,6 +1057,12 @@ int IntegerMatcher::UpdateTablesForFeature(
 
           UINT8Pointer =
             &(tables->proto_evidence_[ActualProtoNum + proto_offset][0]);
+#ifdef __SSE2__
+          InsertProtoEvidence(
+              UINT8Pointer,
+              ClassTemplate->ProtoLengths[ActualProtoNum + proto_offset],
+              Evidence);
+#else
           for (ProtoIndex =
             ClassTemplate->ProtoLengths[ActualProtoNum + proto_offset];
           ProtoIndex > 0; ProtoIndex--, UINT8Pointer++) {
@@ -942,6 +1074,7 @@ int IntegerMatcher::UpdateTablesForFeature(
             else if (Evidence == 0)
               break;
           }
+#endif
         }
       }
     }
@@ -1201,9 +1334,14 @@ void ScratchEvidence::UpdateSumOfProtoEvidences(
     for (ProtoNum = 0;
          ((ProtoNum < PROTOS_PER_PROTO_SET) && (ActualProtoNum < NumProtos));
          ProtoNum++, ActualProtoNum++) {
+#ifdef __SSE2__
+      int temp = SumProtoEvidence(proto_evidence_[ActualProtoNum],
+                                  ClassTemplate->ProtoLengths[ActualProtoNum]);
+#else
       int temp = 0;
       for (int i = 0; i < ClassTemplate->ProtoLengths[ActualProtoNum]; i++)
         temp += proto_evidence_[ActualProtoNum] [i];
+#endif
 
       ConfigWord = ProtoSet->Protos[ProtoNum].Configs[0];
       ConfigWord &= *ConfigMask;
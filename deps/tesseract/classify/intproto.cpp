@@ -725,6 +725,7 @@ INT_CLASS NewIntClass(int MaxNumProtos, int MaxNumConfigs) {
     Class->ProtoLengths = NULL;
   }
   memset(Class->ConfigLengths, 0, sizeof(Class->ConfigLengths));
+  Class->font_set_id = -1;
 
   return (Class);
 
@@ -782,6 +783,142 @@ void free_int_templates(INT_TEMPLATES templates) {
 }
 
 
+/*---------------------------------------------------------------------------*/
+void WriteAdaptedIntTemplates(FILE *File, INT_TEMPLATES Templates) {
+/*
+ ** Parameters:
+ **   File    open file to write templates to
+ **   Templates adapted integer templates to save into File
+ ** Globals: none
+ ** Operation: This routine writes the integer part of adapted templates
+ **   to File in the native byte order. Unlike WriteIntTemplates it
+ **   writes no font information, which adapted classes do not have.
+ ** Return: none
+ ** Exceptions: none
+ */
+  int i;
+  INT_CLASS Class;
+
+  fwrite(&Templates->NumClasses, sizeof(Templates->NumClasses), 1, File);
+  for (i = 0; i < Templates->NumClasses; i++) {
+    Class = Templates->Class[i];
+    fwrite(&Class->NumProtos, sizeof(Class->NumProtos), 1, File);
+    fwrite(&Class->NumProtoSets, sizeof(Class->NumProtoSets), 1, File);
+    fwrite(&Class->NumConfigs, sizeof(Class->NumConfigs), 1, File);
+    fwrite(Class->ConfigLengths, sizeof(Class->ConfigLengths[0]),
+           Class->NumConfigs, File);
+    if (MaxNumIntProtosIn(Class) > 0)
+      fwrite(Class->ProtoLengths, sizeof(uinT8), MaxNumIntProtosIn(Class),
+             File);
+    for (int j = 0; j < Class->NumProtoSets; j++)
+      fwrite(Class->ProtoSets[j], sizeof(PROTO_SET_STRUCT), 1, File);
+  }
+  for (i = 0; i < Templates->NumClassPruners; i++)
+    fwrite(Templates->ClassPruners[i], sizeof(CLASS_PRUNER_STRUCT), 1, File);
+}                                /* WriteAdaptedIntTemplates */
+
+
+/*---------------------------------------------------------------------------*/
+INT_TEMPLATES ReadAdaptedIntTemplates(FILE *File) {
+/*
+ ** Parameters:
+ **   File    open file to read templates from
+ ** Globals: none
+ ** Operation: This routine reads integer templates written by
+ **   WriteAdaptedIntTemplates from File.
+ ** Return: Templates read from File, or NULL if File is truncated or
+ **   does not hold valid templates.
+ ** Exceptions: none
+ */
+  int i;
+  int NumClasses;
+  uinT16 NumProtos;
+  uinT8 NumProtoSets;
+  uinT8 NumConfigs;
+  INT_CLASS Class;
+  INT_TEMPLATES Templates;
+
+  if (fread(&NumClasses, sizeof(NumClasses), 1, File) != 1 ||
+      NumClasses < 0 || NumClasses > MAX_NUM_CLASSES)
+    return NULL;
+  Templates = NewIntTemplates();
+  for (i = 0; i < NumClasses; i++) {
+    if (fread(&NumProtos, sizeof(NumProtos), 1, File) != 1 ||
+        fread(&NumProtoSets, sizeof(NumProtoSets), 1, File) != 1 ||
+        fread(&NumConfigs, sizeof(NumConfigs), 1, File) != 1 ||
+        NumProtoSets > MAX_NUM_PROTO_SETS || NumConfigs > MAX_NUM_CONFIGS ||
+        NumProtos > NumProtoSets * PROTOS_PER_PROTO_SET) {
+      free_int_templates(Templates);
+      return NULL;
+    }
+    Class = NewIntClass(NumProtoSets * PROTOS_PER_PROTO_SET, NumConfigs);
+    Class->NumProtos = NumProtos;
+    Class->NumConfigs = NumConfigs;
+    AddIntClass(Templates, i, Class);
+    bool ok = fread(Class->ConfigLengths, sizeof(Class->ConfigLengths[0]),
+                    NumConfigs, File) == NumConfigs;
+    if (ok && MaxNumIntProtosIn(Class) > 0)
+      ok = fread(Class->ProtoLengths, sizeof(uinT8), MaxNumIntProtosIn(Class),
+                 File) == MaxNumIntProtosIn(Class);
+    for (int j = 0; ok && j < NumProtoSets; j++)
+      ok = fread(Class->ProtoSets[j], sizeof(PROTO_SET_STRUCT), 1, File) == 1;
+    if (!ok) {
+      free_int_templates(Templates);
+      return NULL;
+    }
+  }
+  for (i = 0; i < Templates->NumClassPruners; i++) {
+    if (fread(Templates->ClassPruners[i], sizeof(CLASS_PRUNER_STRUCT), 1,
+              File) != 1) {
+      free_int_templates(Templates);
+      return NULL;
+    }
+  }
+  return Templates;
+}                                /* ReadAdaptedIntTemplates */
+
+
+/*---------------------------------------------------------------------------*/
+INT_TEMPLATES CopyAdaptedIntTemplates(INT_TEMPLATES Templates) {
+/*
+ ** Parameters:
+ **   Templates adapted integer templates to copy
+ ** Globals: none
+ ** Operation: This routine makes a deep copy of the integer part of
+ **   adapted templates, with the same result as writing them with
+ **   WriteAdaptedIntTemplates and reading them back.
+ ** Return: The copy of Templates.
+ ** Exceptions: none
+ */
+  int i;
+  INT_CLASS Class;
+  INT_CLASS Copy;
+  INT_TEMPLATES T;
+
+  T = NewIntTemplates();
+  for (i = 0; i < Templates->NumClasses; i++) {
+    Class = Templates->Class[i];
+    Copy = NewIntClass(Class->NumProtoSets * PROTOS_PER_PROTO_SET,
+                       Class->NumConfigs);
+    Copy->NumProtos = Class->NumProtos;
+    Copy->NumConfigs = Class->NumConfigs;
+    AddIntClass(T, i, Copy);
+    memcpy(Copy->ConfigLengths, Class->ConfigLengths,
+           Class->NumConfigs * sizeof(Class->ConfigLengths[0]));
+    if (MaxNumIntProtosIn(Class) > 0)
+      memcpy(Copy->ProtoLengths, Class->ProtoLengths,
+             MaxNumIntProtosIn(Class) * sizeof(uinT8));
+    for (int j = 0; j < Class->NumProtoSets; j++)
+      memcpy(Copy->ProtoSets[j], Class->ProtoSets[j],
+             sizeof(PROTO_SET_STRUCT));
+  }
+  for (i = 0; i < Templates->NumClassPruners; i++)
+    memcpy(T->ClassPruners[i], Templates->ClassPruners[i],
+           sizeof(CLASS_PRUNER_STRUCT));
+  return T;
+}                                /* CopyAdaptedIntTemplates */
+
+
 namespace tesseract {
 INT_TEMPLATES Classify::ReadIntTemplates(FILE *File) {
 /*
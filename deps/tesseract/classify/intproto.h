@@ -228,6 +228,12 @@ INT_TEMPLATES NewIntTemplates();
 
 void free_int_templates(INT_TEMPLATES templates);
 
+void WriteAdaptedIntTemplates(FILE *File, INT_TEMPLATES Templates);
+
+INT_TEMPLATES ReadAdaptedIntTemplates(FILE *File);
+
+INT_TEMPLATES CopyAdaptedIntTemplates(INT_TEMPLATES Templates);
+
 void ShowMatchDisplay();
 
 namespace tesseract {
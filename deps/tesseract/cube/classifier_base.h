@@ -74,6 +74,16 @@ class CharClassifier {
   virtual bool Init(const string &data_file_path, const string &lang,
                     LangModel *lang_mod) = 0;
 
+  // Classifies samp_cnt charsamps and stores the CharAltList of each one
+  // (NULL on failure) in alt_lists. Classifiers that can share work across
+  // samples override this; by default samples are classified one by one
+  virtual void ClassifyBatch(CharSamp **char_samps, int samp_cnt,
+                             CharAltList **alt_lists) {
+    for (int samp = 0; samp < samp_cnt; samp++) {
+      alt_lists[samp] = Classify(char_samps[samp]);
+    }
+  }
+
   // accessors
   FeatureBase *FeatureExtractor() {return feat_extract_;}
   inline bool CaseSensitive() const { return case_sensitive_; }
@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <wctype.h>
@@ -125,33 +126,42 @@ void ConvNetCharClassifier::Fold() {
   }
 }
 
-// Compute the features of specified charsamp and feedforward the
-// specified nets
-bool ConvNetCharClassifier::RunNets(CharSamp *char_samp) {
-  if (char_net_ == NULL) {
-    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::RunNets): "
-            "NeuralNet is NULL\n");
-    return false;
-  }
+// allocate the i/p and o/p buffers of the net if needed
+bool ConvNetCharClassifier::AllocNetBuffers() {
   int feat_cnt = char_net_->in_cnt();
   int class_cnt = char_set_->ClassCount();
 
-  // allocate i/p and o/p buffers if needed
   if (net_input_ == NULL) {
     net_input_ = new float[feat_cnt];
     if (net_input_ == NULL) {
-      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::RunNets): "
+      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::AllocNetBuffers): "
             "unable to allocate memory for input nodes\n");
       return false;
     }
 
     net_output_ = new float[class_cnt];
     if (net_output_ == NULL) {
-      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::RunNets): "
+      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::AllocNetBuffers): "
             "unable to allocate memory for output nodes\n");
       return false;
     }
   }
+  return true;
+}
+
+// Compute the features of specified charsamp and feedforward the
+// specified nets
+bool ConvNetCharClassifier::RunNets(CharSamp *char_samp) {
+  if (char_net_ == NULL) {
+    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::RunNets): "
+            "NeuralNet is NULL\n");
+    return false;
+  }
+
+  // allocate i/p and o/p buffers if needed
+  if (!AllocNetBuffers()) {
+    return false;
+  }
 
   // compute input features
   if (feat_extract_->ComputeFeatures(char_samp, net_input_) == false) {
@@ -188,13 +198,69 @@ CharAltList *ConvNetCharClassifier::Classify(CharSamp *char_samp) {
   if (RunNets(char_samp) == false) {
     return NULL;
   }
+  return NetOutputAltList();
+}
+
+// classifies a batch of charsamps and returns an alternate list for each
+// of them. The features of all the charsamps are fed forward together
+void ConvNetCharClassifier::ClassifyBatch(CharSamp **char_samps,
+                                          int samp_cnt,
+                                          CharAltList **alt_lists) {
+  for (int samp = 0; samp < samp_cnt; samp++) {
+    alt_lists[samp] = NULL;
+  }
+  if (char_net_ == NULL) {
+    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+            "NeuralNet is NULL\n");
+    return;
+  }
+  if (samp_cnt <= 0 || !AllocNetBuffers()) {
+    return;
+  }
+  int feat_cnt = char_net_->in_cnt();
+  int class_cnt = char_set_->ClassCount();
+
+  // compute input features, leaving out the charsamps that fail
+  vector<float> net_inputs(samp_cnt * feat_cnt);
+  vector<int> batch_samps;
+  for (int samp = 0; samp < samp_cnt; samp++) {
+    float *features = &net_inputs[batch_samps.size() * feat_cnt];
+    if (feat_extract_->ComputeFeatures(char_samps[samp], features) == false) {
+      fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+              "unable to compute features\n");
+      continue;
+    }
+    batch_samps.push_back(samp);
+  }
+  if (batch_samps.empty()) {
+    return;
+  }
+
+  vector<float> net_outputs(batch_samps.size() * class_cnt);
+  if (char_net_->FeedForward(&net_inputs[0], &net_outputs[0],
+                             batch_samps.size()) == false) {
+    fprintf(stderr, "Cube ERROR (ConvNetCharClassifier::ClassifyBatch): "
+            "unable to run feed-forward\n");
+    return;
+  }
+
+  // fold the outputs of each charsamp and create its altlist
+  for (int idx = 0; idx < batch_samps.size(); idx++) {
+    memcpy(net_output_, &net_outputs[idx * class_cnt],
+           class_cnt * sizeof(*net_output_));
+    Fold();
+    alt_lists[batch_samps[idx]] = NetOutputAltList();
+  }
+}
 
+// creates an alternate list of chars from the folded outputs of the net
+CharAltList *ConvNetCharClassifier::NetOutputAltList() {
   int class_cnt = char_set_->ClassCount();
 
   // create an altlist
   CharAltList *alt_list = new CharAltList(char_set_, class_cnt);
   if (alt_list == NULL) {
-    fprintf(stderr, "Cube WARNING (ConvNetCharClassifier::Classify): "
+    fprintf(stderr, "Cube WARNING (ConvNetCharClassifier::NetOutputAltList): "
             "returning emtpy CharAltList\n");
     return NULL;
   }
@@ -64,6 +64,10 @@ class ConvNetCharClassifier : public CharClassifier {
   // Classifies an input charsamp and return a CharAltList object containing
   // the possible candidates and corresponding scores
   virtual CharAltList * Classify(CharSamp *char_samp);
+  // Classifies a batch of charsamps with a single batched FeedForward of
+  // the NeuralNet
+  virtual void ClassifyBatch(CharSamp **char_samps, int samp_cnt,
+                             CharAltList **alt_lists);
   // Computes the cost of a specific charsamp being a character (versus a
   // non-character: part-of-a-character OR more-than-one-character)
   virtual int CharCost(CharSamp *char_samp);
@@ -87,8 +91,12 @@ class ConvNetCharClassifier : public CharClassifier {
                                LangModel *lang_mod);
   // Folds the output of the NeuralNet using the loaded folding sets
   virtual void Fold();
+  // Allocates the NeuralNet input and output buffers if needed
+  bool AllocNetBuffers();
   // Scales the input char_samp and feeds it to the NeuralNet as input
   bool RunNets(CharSamp *char_samp);
+  // Creates a CharAltList from the folded NeuralNet outputs
+  CharAltList *NetOutputAltList();
 };
 }
 #endif  // CONV_NET_CLASSIFIER_H
@@ -17,6 +17,7 @@
  *
  **********************************************************************/
 
+#include <vector>
 #include "cube_search_object.h"
 #include "cube_utils.h"
 #include "ndminx.h"
@@ -291,7 +292,26 @@ CharAltList * CubeSearchObject::RecognizeSegment(int start_pt, int end_pt) {
   // recognize the char sample
   CharClassifier *char_classifier = cntxt_->Classifier();
   if (char_classifier) {
-    reco_cache_[start_pt + 1][end_pt] = char_classifier->Classify(samp);
+    // beam search asks for all the segment ranges that end at end_pt in
+    // turn, so classify the ones not in the cache yet in a single batch
+    vector<int> start_pts(1, start_pt);
+    vector<CharSamp *> samps(1, samp);
+    for (int pt = end_pt - max_seg_per_char_; pt < end_pt; pt++) {
+      if (pt == start_pt || !IsValidSegmentRange(pt, end_pt) ||
+          reco_cache_[pt + 1][end_pt]) {
+        continue;
+      }
+      CharSamp *pt_samp = CharSample(pt, end_pt);
+      if (pt_samp) {
+        start_pts.push_back(pt);
+        samps.push_back(pt_samp);
+      }
+    }
+    vector<CharAltList *> alt_lists(samps.size());
+    char_classifier->ClassifyBatch(&samps[0], samps.size(), &alt_lists[0]);
+    for (int idx = 0; idx < samps.size(); idx++) {
+      reco_cache_[start_pts[idx] + 1][end_pt] = alt_lists[idx];
+    }
   } else {
     // no classifer: all characters are equally probable; add a penalty
     // that favors 2-segment characters and aspect ratios (w/h) > 1
@@ -7,6 +7,9 @@
 //
 #include <vector>
 #include <string>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "neural_net.h"
 #include "input_file_buffer.h"
 
@@ -23,11 +26,6 @@ NeuralNet::~NeuralNet() {
   }
   // clean up neurons
   delete []neurons_;
-  // clean up nodes
-  for (int node_idx = 0; node_idx < neuron_cnt_; node_idx++) {
-    delete []fast_nodes_[node_idx].inputs;
-  }
-
 }
 
 // Initiaization function
@@ -60,9 +58,10 @@ template <typename Type> bool NeuralNet::FastFeedForward(const Type *inputs,
   // compute nodes activations and outputs
   for (;node_idx < neuron_cnt_; node_idx++, node++) {
     double activation = -node->bias;
+    const int *fan_in = &fast_fan_in_[0] + node->fan_in_offset;
+    const float *wts = &fast_wts_[0] + node->fan_in_offset;
     for (int fan_in_idx = 0; fan_in_idx < node->fan_in_cnt; fan_in_idx++) {
-      activation += (node->inputs[fan_in_idx].input_weight *
-                     node->inputs[fan_in_idx].input_node->out);
+      activation += (wts[fan_in_idx] * fast_nodes_[fan_in[fan_in_idx]].out);
     }
     node->out = Neuron::Sigmoid(activation);
   }
@@ -74,6 +73,88 @@ template <typename Type> bool NeuralNet::FastFeedForward(const Type *inputs,
   return true;
 }
 
+// Feeds forward a batch of samples. Read-only nets run kBatchSize samples
+// at a time through FastFeedForwardBatch, other nets one at a time
+bool NeuralNet::FeedForward(const float *inputs, float *outputs,
+                            int sample_cnt) {
+  if (!read_only_) {
+    for (int samp = 0; samp < sample_cnt; samp++) {
+      if (!FeedForward(inputs + samp * in_cnt_, outputs + samp * out_cnt_)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  vector<float> batch_out(neuron_cnt_ * kBatchSize);
+  for (int samp = 0; samp < sample_cnt; samp += kBatchSize) {
+    int batch_cnt = sample_cnt - samp;
+    if (batch_cnt > kBatchSize) {
+      batch_cnt = kBatchSize;
+    }
+    FastFeedForwardBatch(inputs + samp * in_cnt_, outputs + samp * out_cnt_,
+                         batch_cnt, &batch_out[0]);
+  }
+  return true;
+}
+
+// Does a fast feedforward of up to kBatchSize samples for read_only nets.
+// batch_out holds the outputs of each node for all the samples next to
+// each other, so that every fan-in weight is applied to the whole batch
+// at once. Activations are accumulated in single precision
+void NeuralNet::FastFeedForwardBatch(const float *inputs, float *outputs,
+                                     int sample_cnt, float *batch_out) {
+  float *out = batch_out;
+  int node_idx = 0;
+  // feed inputs in and offset them by the pre-computed bias. The unused
+  // samples of a partial batch are zeroed
+  for (; node_idx < in_cnt_; node_idx++, out += kBatchSize) {
+    for (int samp = 0; samp < kBatchSize; samp++) {
+      out[samp] = samp >= sample_cnt ? 0.0f :
+          inputs[samp * in_cnt_ + node_idx] - fast_nodes_[node_idx].bias;
+    }
+  }
+  // compute nodes activations and outputs
+  for (; node_idx < neuron_cnt_; node_idx++, out += kBatchSize) {
+    const Node *node = &fast_nodes_[node_idx];
+    const int *fan_in = &fast_fan_in_[0] + node->fan_in_offset;
+    const float *wts = &fast_wts_[0] + node->fan_in_offset;
+    float activation[kBatchSize];
+#ifdef __SSE2__
+    // kBatchSize is two registers wide
+    __m128 act_lo = _mm_set1_ps(-node->bias);
+    __m128 act_hi = act_lo;
+    for (int fan_in_idx = 0; fan_in_idx < node->fan_in_cnt; fan_in_idx++) {
+      const float *in = batch_out + fan_in[fan_in_idx] * kBatchSize;
+      __m128 wgt = _mm_set1_ps(wts[fan_in_idx]);
+      act_lo = _mm_add_ps(act_lo, _mm_mul_ps(wgt, _mm_loadu_ps(in)));
+      act_hi = _mm_add_ps(act_hi, _mm_mul_ps(wgt, _mm_loadu_ps(in + 4)));
+    }
+    _mm_storeu_ps(activation, act_lo);
+    _mm_storeu_ps(activation + 4, act_hi);
+#else
+    for (int samp = 0; samp < kBatchSize; samp++) {
+      activation[samp] = -node->bias;
+    }
+    for (int fan_in_idx = 0; fan_in_idx < node->fan_in_cnt; fan_in_idx++) {
+      const float *in = batch_out + fan_in[fan_in_idx] * kBatchSize;
+      for (int samp = 0; samp < kBatchSize; samp++) {
+        activation[samp] += wts[fan_in_idx] * in[samp];
+      }
+    }
+#endif
+    for (int samp = 0; samp < kBatchSize; samp++) {
+      out[samp] = Neuron::Sigmoid(activation[samp]);
+    }
+  }
+  // copy the outputs to the output buffers
+  out = batch_out + (neuron_cnt_ - out_cnt_) * kBatchSize;
+  for (node_idx = 0; node_idx < out_cnt_; node_idx++, out += kBatchSize) {
+    for (int samp = 0; samp < sample_cnt; samp++) {
+      outputs[samp * out_cnt_ + node_idx] = out[samp];
+    }
+  }
+}
+
 // Performs a feedforward for general nets. Used mainly in training mode
 // Templatized for float and double Types
 template <typename Type> bool NeuralNet::FeedForward(const Type *inputs,
@@ -123,14 +204,18 @@ bool NeuralNet::SetConnection(int from, int to) {
 // Create a fast readonly version of the net
 bool NeuralNet::CreateFastNet() {
   fast_nodes_.resize(neuron_cnt_);
+  fast_fan_in_.clear();
+  fast_fan_in_.reserve(wts_cnt_);
+  fast_wts_.clear();
+  fast_wts_.reserve(wts_cnt_);
   // build the node structures
   int wts_cnt = 0;
   for (int node_idx = 0; node_idx < neuron_cnt_; node_idx++) {
     Node *node = &fast_nodes_[node_idx];
+    node->fan_in_offset = fast_fan_in_.size();
     if (neurons_[node_idx].node_type() == Neuron::Input) {
       // Input neurons have no fan-in
       node->fan_in_cnt = 0;
-      node->inputs = NULL;
       // Input bias is the normalization offset computed from
       // training input stats
       if (fabs(inputs_max_[node_idx] - inputs_min_[node_idx]) <
@@ -146,11 +231,6 @@ bool NeuralNet::CreateFastNet() {
     } else {
       node->bias = neurons_[node_idx].bias();
       node->fan_in_cnt = neurons_[node_idx].fan_in_cnt();
-      // allocate memory for fan-in nodes
-      node->inputs = new WeightedNode[node->fan_in_cnt];
-      if (node->inputs == NULL) {
-        return false;
-      }
       for (int fan_in = 0; fan_in < node->fan_in_cnt; fan_in++) {
         // identify fan-in neuron
         const int id = neurons_[node_idx].fan_in(fan_in)->id();
@@ -159,7 +239,7 @@ bool NeuralNet::CreateFastNet() {
           return false;
         }
         // add the the fan-in neuron and its wgt
-        node->inputs[fan_in].input_node = &fast_nodes_[id];
+        fast_fan_in_.push_back(id);
         float wgt_val = neurons_[node_idx].fan_in_wts(fan_in);
         // for input neurons normalize the wgt by the input scaling
         // values to save time during feedforward
@@ -174,7 +254,7 @@ bool NeuralNet::CreateFastNet() {
                 inputs_std_dev_[id]);
           }
         }
-        node->inputs[fan_in].input_weight = wgt_val;
+        fast_wts_.push_back(wgt_val);
       }
       // incr wgt count to validate against at the end
       wts_cnt += node->fan_in_cnt;
@@ -242,9 +322,10 @@ template <typename Type> bool NeuralNet::FastGetNetOutput(const Type *inputs,
   int hidden_node_cnt = neuron_cnt_ - out_cnt_;
   for (;node_idx < hidden_node_cnt; node_idx++, node++) {
     double activation = -node->bias;
+    const int *fan_in = &fast_fan_in_[0] + node->fan_in_offset;
+    const float *wts = &fast_wts_[0] + node->fan_in_offset;
     for (int fan_in_idx = 0; fan_in_idx < node->fan_in_cnt; fan_in_idx++) {
-      activation += (node->inputs[fan_in_idx].input_weight *
-                     node->inputs[fan_in_idx].input_node->out);
+      activation += (wts[fan_in_idx] * fast_nodes_[fan_in[fan_in_idx]].out);
     }
     node->out = Neuron::Sigmoid(activation);
   }
@@ -252,9 +333,10 @@ template <typename Type> bool NeuralNet::FastGetNetOutput(const Type *inputs,
   // compute the output of the required output node
   node += output_id;
   double activation = -node->bias;
+  const int *fan_in = &fast_fan_in_[0] + node->fan_in_offset;
+  const float *wts = &fast_wts_[0] + node->fan_in_offset;
   for (int fan_in_idx = 0; fan_in_idx < node->fan_in_cnt; fan_in_idx++) {
-    activation += (node->inputs[fan_in_idx].input_weight *
-                   node->inputs[fan_in_idx].input_node->out);
+    activation += (wts[fan_in_idx] * fast_nodes_[fan_in[fan_in_idx]].out);
   }
   (*output) = Neuron::Sigmoid(activation);
   return true;
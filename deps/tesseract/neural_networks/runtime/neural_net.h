@@ -30,6 +30,9 @@ class NeuralNet {
     // Different flavors of feed forward function
     template <typename Type> bool FeedForward(const Type *inputs,
                                               Type *outputs);
+    // Feeds forward a batch of samples. inputs holds in_cnt() values and
+    // outputs receives out_cnt() values for each of the sample_cnt samples
+    bool FeedForward(const float *inputs, float *outputs, int sample_cnt);
     // Compute the output of a specific output node.
     // This function is useful for application that are interested in a single
     // output of the net and do not want to waste time on the rest
@@ -41,20 +44,18 @@ class NeuralNet {
     int out_cnt() const { return out_cnt_; }
 
   protected:
-    struct Node;
-    // A node-weight pair
-    struct WeightedNode {
-      Node *input_node;
-      float input_weight;
-    };
     // node struct used for fast feedforward in
-    // Read only nets
+    // Read only nets. The fan-in of a node is the run of fan_in_cnt
+    // entries of fast_fan_in_ and fast_wts_ starting at fan_in_offset
     struct Node {
       float out;
       float bias;
       int fan_in_cnt;
-      WeightedNode *inputs;
+      int fan_in_offset;
     };
+    // count of samples fed forward together by the batched
+    // read-only feedforward function
+    static const int kBatchSize = 8;
     // Read-Only flag (no training: On by default)
     // will presumeably be set to false by
     // the inherting TrainableNeuralNet class
@@ -94,6 +95,12 @@ class NeuralNet {
     // vector of input offsets used by fast read-only
     // feedforward function
     vector<Node> fast_nodes_;
+    // ids of the fan-in nodes of all fast nodes, stored contiguously
+    // in node order
+    vector<int> fast_fan_in_;
+    // weights of the fan-in connections of all fast nodes, with the
+    // input normalization folded in
+    vector<float> fast_wts_;
     // Network Initialization function
     void Init();
     // Clears all neurons
@@ -233,6 +240,9 @@ class NeuralNet {
     // different flavors read-only feedforward function
     template <typename Type> bool FastFeedForward(const Type *inputs,
                                                   Type *outputs);
+    // read-only feedforward of up to kBatchSize samples at once
+    void FastFeedForwardBatch(const float *inputs, float *outputs,
+                              int sample_cnt, float *batch_out);
     // Compute the output of a specific output node.
     // This function is useful for application that are interested in a single
     // output of the net and do not want to waste time on the rest
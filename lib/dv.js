@@ -33,9 +33,18 @@ if (fs.existsSync(debugBinding)) {
 }
 
 // Wrap and export Tesseract.
-var Tesseract = exports.Tesseract = function(lang, image) {
+var Tesseract = exports.Tesseract = function(lang, image, engineMode) {
     var tess;
-    if (typeof lang !== "undefined" && lang !== null
+    if (typeof engineMode !== "undefined" && engineMode !== null) {
+        if (typeof lang === "undefined" || lang === null) {
+            lang = 'eng';
+        }
+        if (typeof image !== "undefined" && image !== null) {
+            tess = new binding.Tesseract(__dirname + '/../', lang, image, engineMode);
+        } else {
+            tess = new binding.Tesseract(__dirname + '/../', lang, engineMode);
+        }
+    } else if (typeof lang !== "undefined" && lang !== null
             && typeof image !== "undefined" && image !== null) {
         tess = new binding.Tesseract(__dirname + '/../', lang, image);
     } else if (typeof lang !== "undefined" && lang !== null) {
@@ -51,6 +60,40 @@ Tesseract.prototype = {
     constructor: Tesseract,
 };
 
+// Records Image operations and runs them in a single native call.
+var Pipeline = exports.Pipeline = function(image) {
+    this.image = image;
+    this.ops = [];
+};
+['toGray', 'applyCurve', 'invert', 'threshold', 'convolve', 'erode', 'dilate'].forEach(function(name) {
+    Pipeline.prototype[name] = function() {
+        this.ops.push([name].concat(Array.prototype.slice.call(arguments)));
+        return this;
+    };
+});
+Pipeline.prototype.run = function() {
+    return this.image.runPipeline(this.ops);
+};
+binding.Image.prototype.pipeline = function() {
+    return new Pipeline(this);
+};
+
+// Runs decoding, preprocessing and recognition of many pages as a pipeline.
+// Calls onPage(error, result) for each page as soon as it is done, in no
+// particular order, and onDone() after the last one.
+exports.processBatch = function(buffers, config, onPage, onDone) {
+    if (typeof onDone === 'function') {
+        binding.processBatch(__dirname + '/../', buffers, config, onPage, onDone);
+    } else {
+        binding.processBatch(__dirname + '/../', buffers, config, onPage);
+    }
+};
+
 // Export others.
 exports.Image = binding.Image;
 exports.ZXing = binding.ZXing;
+exports.ImageStore = binding.ImageStore;
+exports.OcrCache = binding.OcrCache;
+exports.setMemoryPool = binding.setMemoryPool;
+exports.memoryPoolStats = binding.memoryPoolStats;
+exports.memoryStats = binding.memoryStats;
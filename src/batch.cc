@@ -0,0 +1,605 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "batch.h"
+#include "image.h"
+#include "util.h"
+#include "zxing.h"
+#include <baseapi.h>
+#include <node_buffer.h>
+#include <uv.h>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+using namespace v8;
+using namespace node;
+
+namespace {
+
+enum Stage
+{
+    DECODE,
+    PREPROCESS,
+    RECOGNIZE,
+    STAGE_COUNT
+};
+
+// Same limits as pixDeskew().
+const float MIN_DESKEW_ANGLE = 0.1;
+const float MIN_DESKEW_CONFIDENCE = 3.0;
+
+struct BatchConfig
+{
+    std::string datapath;
+    std::string format;
+    bool gray;
+    bool threshold;
+    int32_t sx;
+    int32_t sy;
+    int32_t smoothx;
+    int32_t smoothy;
+    float scorefract;
+    bool deskew;
+    std::string textMode;
+    std::string language;
+    bool barcode;
+    bool image;
+    int32_t threads[STAGE_COUNT];
+    int32_t queueSize;
+};
+
+struct BatchPage
+{
+    size_t index;
+    Pix *pix;
+    bool hasSkew;
+    float angle;
+    float confidence;
+    bool hasText;
+    std::string text;
+    bool hasCode;
+    std::string codeFormat;
+    std::string codeText;
+    std::string error;
+};
+
+// Blocking queue of bounded size. Built on semaphores, which unlike
+// condition variables are available in every libuv that node 0.8 ships.
+class PageQueue
+{
+public:
+    void init(int capacity)
+    {
+        uv_mutex_init(&mutex_);
+        uv_sem_init(&slots_, capacity);
+        uv_sem_init(&items_, 0);
+    }
+
+    void destroy()
+    {
+        uv_mutex_destroy(&mutex_);
+        uv_sem_destroy(&slots_);
+        uv_sem_destroy(&items_);
+    }
+
+    // A NULL page tells one consumer that there is nothing left.
+    void push(BatchPage *page)
+    {
+        uv_sem_wait(&slots_);
+        uv_mutex_lock(&mutex_);
+        pages_.push_back(page);
+        uv_mutex_unlock(&mutex_);
+        uv_sem_post(&items_);
+    }
+
+    BatchPage *pop()
+    {
+        uv_sem_wait(&items_);
+        uv_mutex_lock(&mutex_);
+        BatchPage *page = pages_.front();
+        pages_.pop_front();
+        uv_mutex_unlock(&mutex_);
+        uv_sem_post(&slots_);
+        return page;
+    }
+
+private:
+    uv_mutex_t mutex_;
+    uv_sem_t slots_;
+    uv_sem_t items_;
+    std::deque<BatchPage*> pages_;
+};
+
+struct BatchJob;
+
+struct BatchWorker
+{
+    BatchJob *job;
+    Stage stage;
+    uv_thread_t thread;
+    bool started;
+};
+
+struct BatchJob
+{
+    BatchConfig config;
+    std::vector<const unsigned char*> data;
+    std::vector<size_t> lengths;
+    Persistent<Object> buffers;
+    Persistent<Function> pageCallback;
+    Persistent<Function> doneCallback;
+
+    std::vector<BatchWorker> workers;
+    PageQueue queues[STAGE_COUNT - 1];
+    uv_mutex_t mutex;
+    size_t nextIndex;
+    int running[STAGE_COUNT];
+    std::deque<BatchPage*> results;
+    bool finished;
+    // Set if not all workers could be started; the others are shut down
+    // without decoding a page, and onDone is not called.
+    bool aborted;
+    uv_async_t async;
+};
+
+const char *sniffFormat(const unsigned char *data, size_t length)
+{
+    if (length >= 4 && memcmp(data, "\x89PNG", 4) == 0) {
+        return "png";
+    } else if (length >= 2 && data[0] == 0xff && data[1] == 0xd8) {
+        return "jpg";
+    }
+    return NULL;
+}
+
+void decodePage(BatchJob *job, BatchPage *page)
+{
+    const unsigned char *data = job->data[page->index];
+    size_t length = job->lengths[page->index];
+    const char *format = job->config.format.empty()
+            ? sniffFormat(data, length) : job->config.format.c_str();
+    if (!format) {
+        page->error = "unknown image format";
+        return;
+    }
+    page->pix = Image::Decode(format, data, length, page->error);
+    if (!page->pix && page->error.empty()) {
+        page->error = "error while decoding image";
+    }
+}
+
+void preprocessPage(BatchJob *job, BatchPage *page)
+{
+    const BatchConfig &config = job->config;
+    if ((config.gray || config.threshold) && page->pix->d != 8) {
+        Pix *gray = pixConvertTo8(page->pix, 0);
+        pixDestroy(&page->pix);
+        page->pix = gray;
+        if (!gray) {
+            page->error = "error while computing grayscale image";
+            return;
+        }
+    }
+    if (config.threshold) {
+        Pix *binary = NULL;
+        pixOtsuAdaptiveThreshold(page->pix, config.sx, config.sy, config.smoothx,
+                                 config.smoothy, config.scorefract, NULL, &binary);
+        pixDestroy(&page->pix);
+        page->pix = binary;
+        if (!binary) {
+            page->error = "error while computing threshold";
+            return;
+        }
+    }
+    if (config.deskew && page->pix->d == 1
+            && pixFindSkew(page->pix, &page->angle, &page->confidence) == 0) {
+        page->hasSkew = true;
+        if (page->confidence >= MIN_DESKEW_CONFIDENCE
+                && fabs(page->angle) >= MIN_DESKEW_ANGLE) {
+            const float deg2rad = 3.1415926535 / 180.;
+            Pix *rotated = pixRotate(page->pix, deg2rad * page->angle, L_ROTATE_SHEAR,
+                                     L_BRING_IN_WHITE, 0, 0);
+            if (rotated) {
+                pixDestroy(&page->pix);
+                page->pix = rotated;
+            }
+        }
+    }
+}
+
+void recognizePage(BatchJob *job, BatchPage *page, tesseract::TessBaseAPI *api)
+{
+    const BatchConfig &config = job->config;
+    if (!config.textMode.empty()) {
+        if (!api) {
+            page->error = "error while initializing tesseract";
+            return;
+        }
+        api->SetImage(page->pix);
+        // Not deleted, see Tesseract::FindText().
+        const char *text = config.textMode == "unlv" ? api->GetUNLVText() : api->GetUTF8Text();
+        if (!text) {
+            page->error = "Internal tesseract error";
+            return;
+        }
+        page->hasText = true;
+        page->text = text;
+    }
+    if (config.barcode) {
+        page->hasCode = ZXing::Decode(page->pix, page->codeFormat, page->codeText, page->error);
+    }
+}
+
+// Called by the last thread of a stage on its way out.
+void finishStage(BatchJob *job, Stage stage)
+{
+    if (stage == RECOGNIZE) {
+        uv_mutex_lock(&job->mutex);
+        job->finished = true;
+        uv_mutex_unlock(&job->mutex);
+        uv_async_send(&job->async);
+        return;
+    }
+    for (int i = 0; i < job->config.threads[stage + 1]; ++i) {
+        job->queues[stage].push(NULL);
+    }
+}
+
+void batchWorker(void *arg)
+{
+    BatchWorker *worker = static_cast<BatchWorker*>(arg);
+    BatchJob *job = worker->job;
+    Stage stage = worker->stage;
+    // Every recognizer thread has an engine of its own. Tesseract sets up
+    // one engine at a time, as initialization touches global state.
+    tesseract::TessBaseAPI *api = NULL;
+    if (stage == RECOGNIZE && !job->config.textMode.empty()) {
+        api = new tesseract::TessBaseAPI();
+        if (api->Init(job->config.datapath.c_str(), job->config.language.c_str(),
+                      tesseract::OEM_DEFAULT) != 0) {
+            delete api;
+            api = NULL;
+        }
+    }
+    for (;;) {
+        BatchPage *page;
+        if (stage == DECODE) {
+            uv_mutex_lock(&job->mutex);
+            size_t index = job->nextIndex++;
+            uv_mutex_unlock(&job->mutex);
+            if (index >= job->data.size()) {
+                break;
+            }
+            page = new BatchPage();
+            page->index = index;
+            page->pix = NULL;
+            decodePage(job, page);
+        } else {
+            page = job->queues[stage - 1].pop();
+            if (!page) {
+                break;
+            }
+            if (page->error.empty()) {
+                if (stage == PREPROCESS) {
+                    preprocessPage(job, page);
+                } else {
+                    recognizePage(job, page, api);
+                }
+            }
+        }
+        if (stage == RECOGNIZE) {
+            if (!job->config.image || !page->error.empty()) {
+                pixDestroy(&page->pix);
+            }
+            uv_mutex_lock(&job->mutex);
+            job->results.push_back(page);
+            uv_mutex_unlock(&job->mutex);
+            uv_async_send(&job->async);
+        } else {
+            job->queues[stage].push(page);
+        }
+    }
+    if (api) {
+        api->End();
+        delete api;
+    }
+    uv_mutex_lock(&job->mutex);
+    bool last = --job->running[stage] == 0;
+    uv_mutex_unlock(&job->mutex);
+    if (last) {
+        finishStage(job, stage);
+    }
+}
+
+Local<Object> pageResult(BatchJob *job, BatchPage *page)
+{
+    Local<Object> result = Object::New();
+    result->Set(String::NewSymbol("index"), Number::New(page->index));
+    if (page->hasSkew) {
+        Local<Object> skew = Object::New();
+        skew->Set(String::NewSymbol("angle"), Number::New(page->angle));
+        skew->Set(String::NewSymbol("confidence"), Number::New(page->confidence));
+        result->Set(String::NewSymbol("skew"), skew);
+    }
+    if (page->hasText) {
+        result->Set(String::NewSymbol("text"), String::New(page->text.c_str()));
+    }
+    if (job->config.barcode && page->error.empty()) {
+        if (page->hasCode) {
+            Local<Object> code = Object::New();
+            code->Set(String::NewSymbol("type"), String::New(page->codeFormat.c_str()));
+            code->Set(String::NewSymbol("data"), String::New(page->codeText.c_str()));
+            result->Set(String::NewSymbol("code"), code);
+        } else {
+            result->Set(String::NewSymbol("code"), Null());
+        }
+    }
+    if (page->pix) {
+        result->Set(String::NewSymbol("image"), Image::New(page->pix));
+        page->pix = NULL;
+    }
+    return result;
+}
+
+void closeJob(uv_handle_t *handle)
+{
+    BatchJob *job = static_cast<BatchJob*>(handle->data);
+    job->buffers.Dispose();
+    job->pageCallback.Dispose();
+    job->doneCallback.Dispose();
+    delete job;
+}
+
+void deliverResults(uv_async_t *handle, int status)
+{
+    HandleScope scope;
+    BatchJob *job = static_cast<BatchJob*>(handle->data);
+    uv_mutex_lock(&job->mutex);
+    std::deque<BatchPage*> results;
+    results.swap(job->results);
+    bool finished = job->finished;
+    bool aborted = job->aborted;
+    uv_mutex_unlock(&job->mutex);
+    for (size_t i = 0; i < results.size(); ++i) {
+        BatchPage *page = results[i];
+        Handle<Value> argv[2];
+        if (page->error.empty()) {
+            argv[0] = Null();
+        } else {
+            argv[0] = Exception::Error(String::New(page->error.c_str()));
+        }
+        argv[1] = pageResult(job, page);
+        delete page;
+        TryCatch tryCatch;
+        job->pageCallback->Call(Context::GetCurrent()->Global(), 2, argv);
+        if (tryCatch.HasCaught()) {
+            FatalException(tryCatch);
+        }
+    }
+    if (finished) {
+        for (size_t i = 0; i < job->workers.size(); ++i) {
+            if (job->workers[i].started) {
+                uv_thread_join(&job->workers[i].thread);
+            }
+        }
+        for (int i = 0; i < STAGE_COUNT - 1; ++i) {
+            job->queues[i].destroy();
+        }
+        uv_mutex_destroy(&job->mutex);
+        uv_close(reinterpret_cast<uv_handle_t*>(&job->async), closeJob);
+        if (!job->doneCallback.IsEmpty() && !aborted) {
+            TryCatch tryCatch;
+            job->doneCallback->Call(Context::GetCurrent()->Global(), 0, NULL);
+            if (tryCatch.HasCaught()) {
+                FatalException(tryCatch);
+            }
+        }
+    }
+}
+
+bool parseConfig(Handle<Object> object, BatchConfig &config)
+{
+    config.gray = false;
+    config.threshold = false;
+    config.deskew = false;
+    config.barcode = false;
+    config.image = false;
+    config.language = "eng";
+    config.queueSize = 2;
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        config.threads[i] = 1;
+    }
+    Local<Value> format = object->Get(String::NewSymbol("format"));
+    if (format->IsString()) {
+        config.format = *String::AsciiValue(format);
+    } else if (!format->IsUndefined()) {
+        return false;
+    }
+    config.gray = object->Get(String::NewSymbol("gray"))->BooleanValue();
+    // Arguments of Image.otsuAdaptiveThreshold().
+    Local<Value> threshold = object->Get(String::NewSymbol("threshold"));
+    if (threshold->IsArray()) {
+        Local<Array> values = Local<Array>::Cast(threshold);
+        if (values->Length() != 5) {
+            return false;
+        }
+        for (int i = 0; i < 4; ++i) {
+            if (!values->Get(i)->IsInt32()) {
+                return false;
+            }
+        }
+        if (!values->Get(4)->IsNumber()) {
+            return false;
+        }
+        config.threshold = true;
+        config.sx = values->Get(0)->Int32Value();
+        config.sy = values->Get(1)->Int32Value();
+        config.smoothx = values->Get(2)->Int32Value();
+        config.smoothy = values->Get(3)->Int32Value();
+        config.scorefract = values->Get(4)->NumberValue();
+    } else if (!threshold->IsUndefined()) {
+        return false;
+    }
+    config.deskew = object->Get(String::NewSymbol("deskew"))->BooleanValue();
+    Local<Value> text = object->Get(String::NewSymbol("text"));
+    if (text->IsString()) {
+        config.textMode = *String::AsciiValue(text);
+        if (config.textMode != "plain" && config.textMode != "unlv") {
+            return false;
+        }
+    } else if (!text->IsUndefined()) {
+        return false;
+    }
+    Local<Value> language = object->Get(String::NewSymbol("language"));
+    if (language->IsString()) {
+        config.language = *String::AsciiValue(language);
+    } else if (!language->IsUndefined()) {
+        return false;
+    }
+    config.barcode = object->Get(String::NewSymbol("barcode"))->BooleanValue();
+    config.image = object->Get(String::NewSymbol("image"))->BooleanValue();
+    Local<Value> threads = object->Get(String::NewSymbol("threads"));
+    if (threads->IsArray()) {
+        Local<Array> counts = Local<Array>::Cast(threads);
+        if (counts->Length() != STAGE_COUNT) {
+            return false;
+        }
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            if (!counts->Get(i)->IsInt32() || counts->Get(i)->Int32Value() < 1) {
+                return false;
+            }
+            config.threads[i] = counts->Get(i)->Int32Value();
+        }
+    } else if (!threads->IsUndefined()) {
+        return false;
+    }
+    Local<Value> queueSize = object->Get(String::NewSymbol("queueSize"));
+    if (queueSize->IsInt32() && queueSize->Int32Value() >= 1) {
+        config.queueSize = queueSize->Int32Value();
+    } else if (!queueSize->IsUndefined()) {
+        return false;
+    }
+    return true;
+}
+
+}
+
+void Batch::Init(Handle<Object> target)
+{
+    target->Set(String::NewSymbol("processBatch"),
+                FunctionTemplate::New(ProcessBatch)->GetFunction());
+}
+
+Handle<Value> Batch::ProcessBatch(const Arguments &args)
+{
+    HandleScope scope;
+    if (args.Length() < 4 || !args[0]->IsString() || !args[1]->IsArray()
+            || !args[2]->IsObject() || !args[3]->IsFunction()
+            || (args.Length() == 5 && !args[4]->IsFunction()) || args.Length() > 5) {
+        return THROW(TypeError, "expected (string, array, object, function[, function]) signature");
+    }
+    BatchJob *job = new BatchJob();
+    job->config.datapath = *String::AsciiValue(args[0]);
+    if (!parseConfig(args[2]->ToObject(), job->config)) {
+        delete job;
+        return THROW(TypeError, "invalid batch configuration");
+    }
+    Local<Array> buffers = Local<Array>::Cast(args[1]);
+    for (uint32_t i = 0; i < buffers->Length(); ++i) {
+        Local<Value> buffer = buffers->Get(i);
+        if (!Buffer::HasInstance(buffer)) {
+            delete job;
+            return THROW(TypeError, "expected an array of buffers");
+        }
+        job->data.push_back(reinterpret_cast<unsigned char*>(Buffer::Data(buffer->ToObject())));
+        job->lengths.push_back(Buffer::Length(buffer->ToObject()));
+    }
+    // The buffers stay referenced, and their data in place, until the
+    // batch is done.
+    job->buffers = Persistent<Object>::New(buffers);
+    job->pageCallback = Persistent<Function>::New(Local<Function>::Cast(args[3]));
+    if (args.Length() == 5) {
+        job->doneCallback = Persistent<Function>::New(Local<Function>::Cast(args[4]));
+    }
+    job->nextIndex = 0;
+    job->finished = false;
+    job->aborted = false;
+    uv_mutex_init(&job->mutex);
+    for (int i = 0; i < STAGE_COUNT - 1; ++i) {
+        job->queues[i].init(job->config.queueSize);
+    }
+    uv_async_init(uv_default_loop(), &job->async, deliverResults);
+    job->async.data = job;
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        job->running[stage] = job->config.threads[stage];
+        for (int i = 0; i < job->config.threads[stage]; ++i) {
+            BatchWorker worker;
+            worker.job = job;
+            worker.stage = static_cast<Stage>(stage);
+            worker.started = false;
+            job->workers.push_back(worker);
+        }
+    }
+    // Workers take the job mutex before they decode a page or leave, so the
+    // counts can still be fixed while it is held. The last stage is started
+    // first: if a thread cannot be created, the started ones are a tail of
+    // the pipeline and shut down like at the end of a batch with no pages.
+    int started[STAGE_COUNT] = { 0 };
+    bool failed = false;
+    uv_mutex_lock(&job->mutex);
+    for (size_t i = job->workers.size(); i > 0 && !failed; --i) {
+        BatchWorker &worker = job->workers[i - 1];
+        if (uv_thread_create(&worker.thread, batchWorker, &worker) == 0) {
+            worker.started = true;
+            ++started[worker.stage];
+        } else {
+            failed = true;
+        }
+    }
+    if (!failed) {
+        uv_mutex_unlock(&job->mutex);
+        return scope.Close(Undefined());
+    }
+    job->aborted = true;
+    job->nextIndex = job->data.size();
+    int first = STAGE_COUNT;
+    for (int stage = STAGE_COUNT - 1; stage >= 0; --stage) {
+        job->config.threads[stage] = started[stage];
+        job->running[stage] = started[stage];
+        if (started[stage] > 0) {
+            first = stage;
+        }
+    }
+    uv_mutex_unlock(&job->mutex);
+    if (first == STAGE_COUNT) {
+        for (int i = 0; i < STAGE_COUNT - 1; ++i) {
+            job->queues[i].destroy();
+        }
+        uv_mutex_destroy(&job->mutex);
+        uv_close(reinterpret_cast<uv_handle_t*>(&job->async), closeJob);
+    } else if (first > DECODE) {
+        finishStage(job, static_cast<Stage>(first - 1));
+    }
+    return THROW(Error, "error while starting worker threads");
+}
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "edges.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Target size in bytes of the source rows processed by one band.
+const int BAND_BYTES = 256 * 1024;
+
+// Padding after a row buffer, so that the last vector loads stay inside.
+const int ROW_PADDING = 32;
+
+struct EdgeBands
+{
+    Pix *pixs;
+    Pix *pixd;
+    int orientflag;
+    int bandHeight;
+    int bandCount;
+    // Density only.
+    int blockWidth;
+    int blockHeight;
+    int threshold;
+    int columns;
+    l_uint32 *counts;
+};
+
+inline l_uint32 swapBytes(l_uint32 word)
+{
+    return (word >> 24) | ((word >> 8) & 0xff00) | ((word << 8) & 0xff0000) | (word << 24);
+}
+
+// Copies row y of pixs to buf in pixel order, with the first and last pixel
+// repeated on either side like pixAddMirroredBorder(pixs, 1, 1, 1, 1) does.
+void unpackRow(Pix *pixs, int y, l_uint8 *buf)
+{
+    int w = pixGetWidth(pixs);
+    int wpl = pixGetWpl(pixs);
+    const l_uint32 *line = pixGetData(pixs) + y * wpl;
+    for (int i = 0; i < wpl; ++i) {
+#ifdef L_BIG_ENDIAN
+        l_uint32 word = line[i];
+#else
+        l_uint32 word = swapBytes(line[i]);
+#endif
+        memcpy(buf + 1 + 4 * i, &word, 4);
+    }
+    buf[0] = buf[1];
+    buf[w + 1] = buf[w];
+}
+
+void packRow(const l_uint8 *buf, Pix *pixd, int y)
+{
+    int wpl = pixGetWpl(pixd);
+    l_uint32 *line = pixGetData(pixd) + y * wpl;
+    for (int i = 0; i < wpl; ++i) {
+        l_uint32 word;
+        memcpy(&word, buf + 4 * i, 4);
+#ifdef L_BIG_ENDIAN
+        line[i] = word;
+#else
+        line[i] = swapBytes(word);
+#endif
+    }
+}
+
+#ifdef __SSE2__
+// Edge values of 8 pixels from their neighbors widened to 16 bits; t0, m0
+// and b0 are the left neighbors, t1 and b1 the ones above and below, t2,
+// m2 and b2 the right ones. Sums of four pixels fit easily.
+inline __m128i edges8(__m128i t0, __m128i t1, __m128i t2, __m128i m0, __m128i m2,
+                      __m128i b0, __m128i b1, __m128i b2, int orientflag)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i edge = zero;
+    if (orientflag != L_HORIZONTAL_EDGES) {
+        __m128i left = _mm_add_epi16(_mm_add_epi16(t0, b0), _mm_add_epi16(m0, m0));
+        __m128i right = _mm_add_epi16(_mm_add_epi16(t2, b2), _mm_add_epi16(m2, m2));
+        __m128i diff = _mm_sub_epi16(left, right);
+        diff = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+        edge = _mm_srli_epi16(diff, 3);
+    }
+    if (orientflag != L_VERTICAL_EDGES) {
+        __m128i upper = _mm_add_epi16(_mm_add_epi16(t0, t2), _mm_add_epi16(t1, t1));
+        __m128i lower = _mm_add_epi16(_mm_add_epi16(b0, b2), _mm_add_epi16(b1, b1));
+        __m128i diff = _mm_sub_epi16(upper, lower);
+        diff = _mm_max_epi16(diff, _mm_sub_epi16(zero, diff));
+        edge = _mm_add_epi16(edge, _mm_srli_epi16(diff, 3));
+    }
+    return edge;
+}
+#endif
+
+// Filters one row given the rows above and below; top, mid and bottom
+// start at the left border pixel.
+void filterRow(const l_uint8 *top, const l_uint8 *mid, const l_uint8 *bottom,
+               l_uint8 *out, int w, int orientflag)
+{
+    int x = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= w; x += 16) {
+        __m128i t0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x));
+        __m128i t1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x + 1));
+        __m128i t2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(top + x + 2));
+        __m128i m0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x));
+        __m128i m2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x + 2));
+        __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x));
+        __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x + 1));
+        __m128i b2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bottom + x + 2));
+        __m128i lo = edges8(_mm_unpacklo_epi8(t0, zero), _mm_unpacklo_epi8(t1, zero),
+                            _mm_unpacklo_epi8(t2, zero), _mm_unpacklo_epi8(m0, zero),
+                            _mm_unpacklo_epi8(m2, zero), _mm_unpacklo_epi8(b0, zero),
+                            _mm_unpacklo_epi8(b1, zero), _mm_unpacklo_epi8(b2, zero), orientflag);
+        __m128i hi = edges8(_mm_unpackhi_epi8(t0, zero), _mm_unpackhi_epi8(t1, zero),
+                            _mm_unpackhi_epi8(t2, zero), _mm_unpackhi_epi8(m0, zero),
+                            _mm_unpackhi_epi8(m2, zero), _mm_unpackhi_epi8(b0, zero),
+                            _mm_unpackhi_epi8(b1, zero), _mm_unpackhi_epi8(b2, zero), orientflag);
+        // Both gradients are at most 127, so packing with saturation is
+        // the L_MIN(255, gx + gy) of leptonica.
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; x < w; ++x) {
+        int edge = 0;
+        if (orientflag != L_HORIZONTAL_EDGES) {
+            edge = L_ABS(top[x] + 2 * mid[x] + bottom[x]
+                         - top[x + 2] - 2 * mid[x + 2] - bottom[x + 2]) >> 3;
+        }
+        if (orientflag != L_VERTICAL_EDGES) {
+            edge += L_ABS(top[x] + 2 * top[x + 1] + top[x + 2]
+                          - bottom[x] - 2 * bottom[x + 1] - bottom[x + 2]) >> 3;
+        }
+        out[x] = L_MIN(255, edge);
+    }
+}
+
+// Number of pixels in [x0, x1) of the row with at least the threshold.
+l_uint32 countRange(const l_uint8 *edges, int x0, int x1, int threshold)
+{
+    l_uint32 count = 0;
+    int x = x0;
+#ifdef __SSE2__
+    const __m128i limit = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i one = _mm_set1_epi8(1);
+    __m128i sums = _mm_setzero_si128();
+    for (; x + 16 <= x1 && threshold >= 0 && threshold <= 255; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(edges + x));
+        __m128i above = _mm_cmpeq_epi8(_mm_max_epu8(v, limit), v);
+        sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_and_si128(above, one), _mm_setzero_si128()));
+    }
+    count = _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+#endif
+    for (; x < x1; ++x) {
+        count += edges[x] >= threshold;
+    }
+    return count;
+}
+
+void countRow(const l_uint8 *edges, int w, const EdgeBands &bands, l_uint32 *counts)
+{
+    for (int x0 = 0, column = 0; x0 < w; x0 += bands.blockWidth, ++column) {
+        counts[column] += countRange(edges, x0, std::min(w, x0 + bands.blockWidth), bands.threshold);
+    }
+}
+
+void runBand(int index, void *data)
+{
+    EdgeBands *bands = static_cast<EdgeBands*>(data);
+    Pix *pixs = bands->pixs;
+    int w = pixGetWidth(pixs);
+    int h = pixGetHeight(pixs);
+    int y0 = index * bands->bandHeight;
+    int y1 = std::min(h, y0 + bands->bandHeight);
+    int size = 4 * pixGetWpl(pixs) + 2 + ROW_PADDING;
+    std::vector<l_uint8> buffer(4 * size, 0);
+    l_uint8 *top = &buffer[0];
+    l_uint8 *mid = top + size;
+    l_uint8 *bottom = mid + size;
+    l_uint8 *out = bottom + size;
+    unpackRow(pixs, std::max(0, y0 - 1), top);
+    unpackRow(pixs, y0, mid);
+    for (int y = y0; y < y1; ++y) {
+        unpackRow(pixs, std::min(h - 1, y + 1), bottom);
+        filterRow(top, mid, bottom, out, w, bands->orientflag);
+        if (bands->pixd) {
+            packRow(out, bands->pixd, y);
+        }
+        if (bands->counts) {
+            countRow(out, w, *bands, bands->counts + (y / bands->blockHeight) * bands->columns);
+        }
+        std::swap(top, mid);
+        std::swap(mid, bottom);
+    }
+}
+
+void runBands(EdgeBands &bands)
+{
+    int h = pixGetHeight(bands.pixs);
+    bands.bandHeight = std::max(BAND_BYTES / (pixGetWpl(bands.pixs) * 4), 16);
+    if (bands.counts) {
+        // Bands hold whole rows of blocks, so no two share a count.
+        bands.bandHeight += bands.blockHeight - 1;
+        bands.bandHeight -= bands.bandHeight % bands.blockHeight;
+    }
+    bands.bandCount = (h + bands.bandHeight - 1) / bands.bandHeight;
+    parallelFor(bands.bandCount, runBand, &bands);
+}
+
+bool validInput(Pix *pixs, int orientflag)
+{
+    return pixs && pixGetDepth(pixs) == 8 && !pixGetColormap(pixs)
+            && (orientflag == L_HORIZONTAL_EDGES || orientflag == L_VERTICAL_EDGES
+                || orientflag == L_ALL_EDGES);
+}
+
+}
+
+Pix *sobelEdgeFilter(Pix *pixs, int orientflag)
+{
+    if (!validInput(pixs, orientflag)) {
+        return NULL;
+    }
+    Pix *pixd = pixCreateTemplateNoInit(pixs);
+    if (!pixd) {
+        return NULL;
+    }
+    EdgeBands bands;
+    bands.pixs = pixs;
+    bands.pixd = pixd;
+    bands.orientflag = orientflag;
+    bands.counts = NULL;
+    runBands(bands);
+    return pixd;
+}
+
+bool sobelEdgeDensity(Pix *pixs, int orientflag, int blockWidth, int blockHeight,
+                      int threshold, std::vector<l_uint32> &counts,
+                      int &columns, int &rows)
+{
+    if (!validInput(pixs, orientflag) || blockWidth <= 0 || blockHeight <= 0) {
+        return false;
+    }
+    columns = (pixGetWidth(pixs) + blockWidth - 1) / blockWidth;
+    rows = (pixGetHeight(pixs) + blockHeight - 1) / blockHeight;
+    counts.assign(columns * rows, 0);
+    EdgeBands bands;
+    bands.pixs = pixs;
+    bands.pixd = NULL;
+    bands.orientflag = orientflag;
+    bands.blockWidth = blockWidth;
+    bands.blockHeight = blockHeight;
+    bands.threshold = threshold;
+    bands.columns = columns;
+    bands.counts = &counts[0];
+    runBands(bands);
+    return true;
+}
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef EDGES_H
+#define EDGES_H
+
+#include <allheaders.h>
+#include <vector>
+
+// Same results as pixSobelEdgeFilter(), computed over bands of rows in
+// parallel and several pixels at a time.
+Pix *sobelEdgeFilter(Pix *pixs, int orientflag);
+
+// Counts the pixels of each blockWidth x blockHeight block whose Sobel edge
+// value (as above) is at least threshold, without creating the edge image.
+// The counts are stored row by row in counts, which gets
+// columns x rows entries.
+bool sobelEdgeDensity(Pix *pixs, int orientflag, int blockWidth, int blockHeight,
+                      int threshold, std::vector<l_uint32> &counts,
+                      int &columns, int &rows);
+
+#endif
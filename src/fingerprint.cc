@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "fingerprint.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// Cells per side of the signature grid.
+const int GRID_SIZE = 16;
+
+// Page pixels per pixel of the alignment thumbnail.
+const int THUMB_FACTOR = 4;
+const float THUMB_SCALE = 1.0 / THUMB_FACTOR;
+
+// Offsets, in thumbnail pixels, tried when aligning pages.
+const int MAX_SHIFT = 2;
+
+// Size of the brick that differences between the binarized pages must
+// cover. Edges moving by a pixel and specks are thinner; periods and
+// strokes at 300 dpi are not.
+const int MIN_DIFF_SIZE = 2;
+
+Pix *grayPage(Pix *pix)
+{
+    Pix *thumb;
+    if (pix->d == 1) {
+        thumb = pixScaleToGray(pix, THUMB_SCALE);
+    } else {
+        Pix *gray = pixConvertTo8(pix, 0);
+        thumb = gray ? pixScaleAreaMap(gray, THUMB_SCALE, THUMB_SCALE) : NULL;
+        pixDestroy(&gray);
+    }
+    if (!thumb) {
+        return NULL;
+    }
+    // Stretch to full contrast, so that brightness does not matter, and
+    // smooth, so that strokes moving by less than a pixel hardly do.
+    l_float32 black, white;
+    pixGetRankValueMasked(thumb, NULL, 0, 0, 1, 0.02, &black, NULL);
+    pixGetRankValueMasked(thumb, NULL, 0, 0, 1, 0.98, &white, NULL);
+    if (white > black) {
+        pixGammaTRC(thumb, thumb, 1.0, black, white);
+    }
+    Pix *smooth = pixBlockconv(thumb, 1, 1);
+    pixDestroy(&thumb);
+    return smooth;
+}
+
+// Binarizes the page halfway between ink and paper, so that brightness
+// does not move the edges of strokes.
+Pix *binaryPage(Pix *pix)
+{
+    if (pix->d == 1) {
+        return pixClone(pix);
+    }
+    Pix *gray = pixConvertTo8(pix, 0);
+    if (!gray) {
+        return NULL;
+    }
+    l_float32 black = 0, white = 255;
+    pixGetRankValueMasked(gray, NULL, 0, 0, 4, 0.02, &black, NULL);
+    pixGetRankValueMasked(gray, NULL, 0, 0, 4, 0.98, &white, NULL);
+    Pix *binary = pixThresholdToBinary(gray, static_cast<int>((black + white + 1) / 2));
+    pixDestroy(&gray);
+    return binary;
+}
+
+// Sum of absolute differences of pix2 shifted by (dx, dy) against pix1,
+// over the w x h region inside the margins of both.
+uint64_t shiftedDifference(Pix *pix1, Pix *pix2, int dx, int dy, int w, int h)
+{
+    uint64_t sum = 0;
+    for (int y = 0; y < h; ++y) {
+        l_uint32 *line1 = pix1->data + (y + MAX_SHIFT) * pix1->wpl;
+        l_uint32 *line2 = pix2->data + (y + MAX_SHIFT + dy) * pix2->wpl;
+        for (int x = 0; x < w; ++x) {
+            sum += abs(GET_DATA_BYTE(line1, x + MAX_SHIFT)
+                       - GET_DATA_BYTE(line2, x + MAX_SHIFT + dx));
+        }
+    }
+    return sum;
+}
+
+// Sets the pixels of diff in which pix1 and pix2, shifted by (dx, dy),
+// differ; pixels near the border, which may have been shifted in from
+// outside, are left clear.
+void binaryDifference(Pix *pix1, Pix *pix2, int dx, int dy, Pix *diff)
+{
+    const int border = (MAX_SHIFT + 1) * THUMB_FACTOR;
+    pixRasterop(diff, 0, 0, diff->w, diff->h, PIX_SRC, pix1, 0, 0);
+    pixRasterop(diff, 0, 0, diff->w, diff->h, PIX_SRC ^ PIX_DST, pix2, dx, dy);
+    pixSetOrClearBorder(diff, border, border, border, border, PIX_CLR);
+}
+
+}
+
+bool fingerprintCreate(Pix *pix, Fingerprint &fingerprint)
+{
+    fingerprint.thumb = grayPage(pix);
+    fingerprint.binary = binaryPage(pix);
+    if (!fingerprint.thumb || !fingerprint.binary) {
+        fingerprintDestroy(fingerprint);
+        return false;
+    }
+    Pix *grid = pixScaleToSize(fingerprint.thumb, GRID_SIZE, GRID_SIZE);
+    if (!grid) {
+        fingerprintDestroy(fingerprint);
+        return false;
+    }
+    // A cell is set if it is darker than the median cell, which keeps the
+    // signature independent of contrast and brightness.
+    l_uint32 values[GRID_SIZE * GRID_SIZE];
+    for (int y = 0; y < GRID_SIZE; ++y) {
+        for (int x = 0; x < GRID_SIZE; ++x) {
+            pixGetPixel(grid, x, y, &values[y * GRID_SIZE + x]);
+        }
+    }
+    pixDestroy(&grid);
+    l_uint32 sorted[GRID_SIZE * GRID_SIZE];
+    std::copy(values, values + GRID_SIZE * GRID_SIZE, sorted);
+    std::nth_element(sorted, sorted + GRID_SIZE * GRID_SIZE / 2, sorted + GRID_SIZE * GRID_SIZE);
+    l_uint32 median = sorted[GRID_SIZE * GRID_SIZE / 2];
+    std::fill(fingerprint.bits, fingerprint.bits + sizeof(fingerprint.bits), 0);
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; ++i) {
+        if (values[i] < median) {
+            fingerprint.bits[i / 8] |= 1 << (i % 8);
+        }
+    }
+    return true;
+}
+
+void fingerprintDestroy(Fingerprint &fingerprint)
+{
+    pixDestroy(&fingerprint.thumb);
+    pixDestroy(&fingerprint.binary);
+}
+
+std::string fingerprintHex(const Fingerprint &fingerprint)
+{
+    char hex[2 * sizeof(fingerprint.bits) + 1];
+    for (size_t i = 0; i < sizeof(fingerprint.bits); ++i) {
+        sprintf(hex + 2 * i, "%02x", fingerprint.bits[i]);
+    }
+    return std::string(hex, 2 * sizeof(fingerprint.bits));
+}
+
+int fingerprintDistance(const Fingerprint &a, const Fingerprint &b)
+{
+    int distance = 0;
+    for (size_t i = 0; i < sizeof(a.bits); ++i) {
+        uint8_t diff = a.bits[i] ^ b.bits[i];
+        while (diff) {
+            diff &= diff - 1;
+            ++distance;
+        }
+    }
+    return distance;
+}
+
+bool fingerprintMatch(const Fingerprint &a, const Fingerprint &b)
+{
+    Pix *pix1 = a.thumb;
+    Pix *pix2 = b.thumb;
+    if (abs(static_cast<int>(pix1->w) - static_cast<int>(pix2->w)) > MAX_SHIFT
+            || abs(static_cast<int>(pix1->h) - static_cast<int>(pix2->h)) > MAX_SHIFT) {
+        return false;
+    }
+    int w = std::min(pix1->w, pix2->w) - 2 * MAX_SHIFT;
+    int h = std::min(pix1->h, pix2->h) - 2 * MAX_SHIFT;
+    if (w <= 0 || h <= 0) {
+        return false;
+    }
+    // Align the pages roughly on the thumbnails.
+    int bestX = 0, bestY = 0;
+    uint64_t bestSum = shiftedDifference(pix1, pix2, 0, 0, w, h);
+    for (int dy = -MAX_SHIFT; dy <= MAX_SHIFT; ++dy) {
+        for (int dx = -MAX_SHIFT; dx <= MAX_SHIFT; ++dx) {
+            uint64_t sum = shiftedDifference(pix1, pix2, dx, dy, w, h);
+            if (sum < bestSum) {
+                bestSum = sum;
+                bestX = dx;
+                bestY = dy;
+            }
+        }
+    }
+    // Refine the alignment on the binarized pages, then look for
+    // differences that are more than edges moving or specks; any such is
+    // content that one page has and the other does not.
+    Pix *diff = pixCreate(std::min(a.binary->w, b.binary->w),
+                          std::min(a.binary->h, b.binary->h), 1);
+    if (!diff) {
+        return false;
+    }
+    int shiftX = 0, shiftY = 0;
+    l_int32 bestCount = -1;
+    for (int dy = -THUMB_FACTOR / 2; dy <= THUMB_FACTOR / 2; ++dy) {
+        for (int dx = -THUMB_FACTOR / 2; dx <= THUMB_FACTOR / 2; ++dx) {
+            int sx = bestX * THUMB_FACTOR + dx, sy = bestY * THUMB_FACTOR + dy;
+            l_int32 count;
+            binaryDifference(a.binary, b.binary, sx, sy, diff);
+            pixCountPixels(diff, &count, NULL);
+            if (bestCount < 0 || count < bestCount) {
+                bestCount = count;
+                shiftX = sx;
+                shiftY = sy;
+            }
+        }
+    }
+    binaryDifference(a.binary, b.binary, shiftX, shiftY, diff);
+    pixOpenBrick(diff, diff, MIN_DIFF_SIZE, MIN_DIFF_SIZE);
+    l_int32 empty = 0;
+    pixZero(diff, &empty);
+    pixDestroy(&diff);
+    return empty != 0;
+}
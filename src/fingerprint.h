@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <allheaders.h>
+#include <stdint.h>
+#include <string>
+
+// Identifies near-identical pages: a 256 bit signature of the coarse page
+// layout to find candidates, a smoothed gray thumbnail to align them and
+// the binarized page to verify them.
+struct Fingerprint
+{
+    uint8_t bits[32];
+    Pix *thumb;
+    Pix *binary;
+};
+
+bool fingerprintCreate(Pix *pix, Fingerprint &fingerprint);
+void fingerprintDestroy(Fingerprint &fingerprint);
+
+// Returns the signature as 64 hex digits.
+std::string fingerprintHex(const Fingerprint &fingerprint);
+
+// Number of signature bits in which two fingerprints differ.
+int fingerprintDistance(const Fingerprint &a, const Fingerprint &b);
+
+// Returns true if the pages differ in nothing but specks, edges moving by
+// a pixel and a small offset, i.e. if results computed for one are valid
+// for the other. A missing period at 300 dpi is a difference.
+bool fingerprintMatch(const Fingerprint &a, const Fingerprint &b);
+
+#endif
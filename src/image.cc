@@ -20,17 +20,38 @@
  * SOFTWARE.
  */
 #include "image.h"
+#include "edges.h"
+#include "fingerprint.h"
+#include "memory.h"
 #include "util.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include "rotation.h"
+#include "tiling.h"
+#include <algorithm>
 #include <cmath>
 #include <node_buffer.h>
 #include <jpgd.h>
 #include <lodepng.h>
+#include <uv.h>
+#include <map>
 #include <sstream>
+#include <vector>
 
 using namespace v8;
 using namespace node;
 
-Persistent<FunctionTemplate> Image::constructor_template;
+// Every isolate that loads the binding gets a constructor template of its
+// own; nothing in V8 is shared between them.
+typedef std::map<Isolate*, Persistent<FunctionTemplate> > TemplateMap;
+TemplateMap templates;
+uv_mutex_t templatesMutex;
+uv_once_t templatesOnce = UV_ONCE_INIT;
+
+void initTemplates()
+{
+    uv_mutex_init(&templatesMutex);
+}
 
 Pix* pixFromSource(uint8_t *pixSource, int32_t width, int32_t height, int32_t depth, int32_t targetDepth)
 {
@@ -51,13 +72,267 @@ Pix* pixFromSource(uint8_t *pixSource, int32_t width, int32_t height, int32_t de
     return pix;
 }
 
+struct SauvolaTiles
+{
+    Pix *pixs;
+    Pix *pixm;
+    Pix *pixms;
+    float factor;
+    std::vector<Box*> boxes;
+    std::vector<Pix*> thresholds;
+    std::vector<Pix*> images;
+};
+
+void sauvolaBinarizeTile(int index, void *data)
+{
+    // Thresholds one tile using the page-wide mean and mean square.
+    SauvolaTiles *tiles = static_cast<SauvolaTiles*>(data);
+    Box *box = tiles->boxes[index];
+    Pix *tileSource = pixClipRectangle(tiles->pixs, box, NULL);
+    Pix *tileMean = pixClipRectangle(tiles->pixm, box, NULL);
+    Pix *tileMeanSquare = pixClipRectangle(tiles->pixms, box, NULL);
+    Pix *tileThreshold = pixSauvolaGetThreshold(tileMean, tileMeanSquare, tiles->factor, NULL);
+    if (tileThreshold) {
+        tiles->images[index] = pixApplyLocalThreshold(tileSource, tileThreshold, 1);
+    }
+    tiles->thresholds[index] = tileThreshold;
+    pixDestroy(&tileSource);
+    pixDestroy(&tileMean);
+    pixDestroy(&tileMeanSquare);
+}
+
+struct NeighborhoodParams
+{
+    int32_t width;
+    int32_t height;
+    float rank;
+};
+
+Pix *convolveTile(Pix *tile, void *data)
+{
+    NeighborhoodParams *params = static_cast<NeighborhoodParams*>(data);
+    Pix *pixs;
+    if (tile->d == 1) {
+        pixs = pixConvert1To8(NULL, tile, 0, 255);
+    } else {
+        pixs = pixClone(tile);
+    }
+    Pix *pixd = pixBlockconv(pixs, params->width, params->height);
+    pixDestroy(&pixs);
+    return pixd;
+}
+
+Pix *rankFilterTile(Pix *tile, void *data)
+{
+    NeighborhoodParams *params = static_cast<NeighborhoodParams*>(data);
+    return pixRankFilter(tile, params->width, params->height, params->rank);
+}
+
+Pix *erodeGrayTile(Pix *tile, void *data)
+{
+    NeighborhoodParams *params = static_cast<NeighborhoodParams*>(data);
+    return pixErodeGray(tile, params->width, params->height);
+}
+
+Pix *dilateGrayTile(Pix *tile, void *data)
+{
+    NeighborhoodParams *params = static_cast<NeighborhoodParams*>(data);
+    return pixDilateGray(tile, params->width, params->height);
+}
+
+Pix *neighborhoodFilter(Pix *pixs, TileFilter filter, int32_t width, int32_t height,
+                        float rank = 0)
+{
+    // Tiles overlap by more than the filter's reach, so the result does
+    // not depend on the tiling.
+    NeighborhoodParams params = { width, height, rank };
+    return tileFilter(pixs, std::max(width, 0) + 1, std::max(height, 0) + 1,
+                      filter, &params);
+}
+
+struct OrientationResult
+{
+    int32_t angle;
+    float upConfidence;
+    float leftConfidence;
+    bool hasMirror;
+    float mirrorConfidence;
+};
+
+bool detectOrientation(Pix *pix, bool mirror, OrientationResult &result)
+{
+    Pix *pixb = pix->d == 1 ? pixClone(pix) : pixConvertTo1(pix, 128);
+    if (!pixb) {
+        return false;
+    }
+    // The up-down filters work as well on full-resolution scans reduced
+    // by two, at a quarter of the cost.
+    Pix *pixr;
+    if (pix->xres > 0 ? pix->xres >= 300 : pix->w >= 1600) {
+        pixr = pixReduceRankBinaryCascade(pixb, 1, 0, 0, 0);
+    } else {
+        pixr = pixClone(pixb);
+    }
+    if (!pixr) {
+        pixDestroy(&pixb);
+        return false;
+    }
+    result.angle = -1;
+    result.hasMirror = false;
+    result.mirrorConfidence = 0;
+    pixOrientDetectDwa(pixr, &result.upConfidence, &result.leftConfidence, 0, 0);
+    l_int32 orient = L_TEXT_ORIENT_UNKNOWN;
+    if (result.upConfidence != 0.0 && result.leftConfidence != 0.0) {
+        makeOrientDecision(result.upConfidence, result.leftConfidence, 0, 0, &orient, 0);
+    }
+    if (orient != L_TEXT_ORIENT_UNKNOWN) {
+        // Clockwise rotation that brings the text upright.
+        result.angle = (orient - L_TEXT_ORIENT_UP) * 90;
+        // Mirror detection needs the full resolution.
+        if (mirror) {
+            Pix *upright = result.angle ? pixRotateOrth(pixb, result.angle / 90) : pixClone(pixb);
+            result.hasMirror = upright
+                    && pixMirrorDetectDwa(upright, &result.mirrorConfidence, 0, 0) == 0;
+            pixDestroy(&upright);
+        }
+    }
+    pixDestroy(&pixr);
+    pixDestroy(&pixb);
+    return true;
+}
+
+struct BackgroundParams
+{
+    bool morph;
+    int32_t tileWidth;
+    int32_t tileHeight;
+    int32_t threshold;
+    int32_t minCount;
+    int32_t backgroundValue;
+    int32_t smoothX;
+    int32_t smoothY;
+    int32_t reduction;
+    int32_t size;
+};
+
+bool parseBackgroundParams(const Arguments &args, BackgroundParams &params)
+{
+    // Defaults are the ones of pixBackgroundNormSimple.
+    params.morph = false;
+    params.tileWidth = 10;
+    params.tileHeight = 15;
+    params.threshold = 60;
+    params.minCount = 40;
+    params.backgroundValue = 200;
+    params.smoothX = 2;
+    params.smoothY = 1;
+    params.reduction = 4;
+    params.size = 15;
+    if (args.Length() == 0) {
+        return true;
+    } else if (args.Length() == 7) {
+        for (int i = 0; i < 7; ++i) {
+            if (!args[i]->IsInt32()) {
+                return false;
+            }
+        }
+        params.tileWidth = args[0]->ToInt32()->Value();
+        params.tileHeight = args[1]->ToInt32()->Value();
+        params.threshold = args[2]->ToInt32()->Value();
+        params.minCount = args[3]->ToInt32()->Value();
+        params.backgroundValue = args[4]->ToInt32()->Value();
+        params.smoothX = args[5]->ToInt32()->Value();
+        params.smoothY = args[6]->ToInt32()->Value();
+        return true;
+    } else if ((args.Length() == 1 || args.Length() == 4) && args[0]->IsString()
+               && strcmp("morph", *String::AsciiValue(args[0]->ToString())) == 0) {
+        params.morph = true;
+        if (args.Length() == 4) {
+            if (!args[1]->IsInt32() || !args[2]->IsInt32() || !args[3]->IsInt32()) {
+                return false;
+            }
+            params.reduction = args[1]->ToInt32()->Value();
+            params.size = args[2]->ToInt32()->Value();
+            params.backgroundValue = args[3]->ToInt32()->Value();
+        }
+        return true;
+    }
+    return false;
+}
+
+// Whether pixm is a 16 bpp inverse background map for pixs with tiles of
+// sx x sy pixels. The maps of backgroundMap() cover the page, and those
+// computed by morphology have one extra row and column of tiles.
+bool backgroundMapMatches(Pix *pixm, Pix *pixs, int sx, int sy)
+{
+    int nx = (pixGetWidth(pixs) + sx - 1) / sx;
+    int ny = (pixGetHeight(pixs) + sy - 1) / sy;
+    return pixGetDepth(pixm) == 16
+        && pixGetWidth(pixm) >= nx && pixGetWidth(pixm) <= nx + 1
+        && pixGetHeight(pixm) >= ny && pixGetHeight(pixm) <= ny + 1;
+}
+
+// Parses the edge orientation argument at index, "all" if it is missing.
+bool parseEdgeOrientation(const Arguments &args, int index, int &orientflag)
+{
+    if (args.Length() <= index) {
+        orientflag = L_ALL_EDGES;
+        return true;
+    }
+    if (args.Length() != index + 1 || !args[index]->IsString()) {
+        return false;
+    }
+    String::AsciiValue orientation(args[index]->ToString());
+    if (strcmp("horizontal", *orientation) == 0) {
+        orientflag = L_HORIZONTAL_EDGES;
+    } else if (strcmp("vertical", *orientation) == 0) {
+        orientflag = L_VERTICAL_EDGES;
+    } else if (strcmp("all", *orientation) == 0) {
+        orientflag = L_ALL_EDGES;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Leptonica's boolean ops report errors by returning the pixd they were
+// given, which looks like success when writing into an existing image. So
+// their operands are checked beforehand.
+bool operandsMatch(Pix *pixs1, Pix *pixs2)
+{
+    return pixSizesEqual(pixs1, pixs2);
+}
+
+// Parses the optional trailing options of operations that can write into an
+// existing image: {inPlace: true} targets this image, {into: image} another
+// one. The target stays empty if a new image should be returned.
+bool parseTargetOption(const Arguments &args, int index, Handle<Object> &target)
+{
+    if (args.Length() <= index) {
+        return true;
+    }
+    if (args.Length() != index + 1 || !args[index]->IsObject()) {
+        return false;
+    }
+    Local<Object> options = args[index]->ToObject();
+    Local<Value> into = options->Get(String::NewSymbol("into"));
+    if (options->Get(String::NewSymbol("inPlace"))->BooleanValue()) {
+        target = args.This();
+    } else if (Image::HasInstance(into)) {
+        target = into->ToObject();
+    } else if (!into->IsUndefined()) {
+        return false;
+    }
+    return true;
+}
+
 bool Image::HasInstance(Handle<Value> val)
 {
     if (!val->IsObject()) {
         return false;
     }
     Local<Object> obj = val->ToObject();
-    return constructor_template->HasInstance(obj);
+    return Template()->HasInstance(obj);
 }
 
 Pix *Image::Pixels(Handle<Object> obj)
@@ -65,9 +340,18 @@ Pix *Image::Pixels(Handle<Object> obj)
     return ObjectWrap::Unwrap<Image>(obj)->pix_;
 }
 
+Handle<FunctionTemplate> Image::Template()
+{
+    uv_mutex_lock(&templatesMutex);
+    Handle<FunctionTemplate> constructor_template = templates[Isolate::GetCurrent()];
+    uv_mutex_unlock(&templatesMutex);
+    return constructor_template;
+}
+
 void Image::Init(Handle<Object> target)
 {
-    constructor_template = Persistent<FunctionTemplate>::New(FunctionTemplate::New(New));
+    uv_once(&templatesOnce, initTemplates);
+    Local<FunctionTemplate> constructor_template = FunctionTemplate::New(New);
     constructor_template->SetClassName(String::NewSymbol("Image"));
     constructor_template->InstanceTemplate()->SetInternalFieldCount(1);
     Local<ObjectTemplate> proto = constructor_template->PrototypeTemplate();
@@ -108,37 +392,134 @@ void Image::Init(Handle<Object> target)
                FunctionTemplate::New(Erode)->GetFunction());
     proto->Set(String::NewSymbol("dilate"),
                FunctionTemplate::New(Dilate)->GetFunction());
+    proto->Set(String::NewSymbol("morphSequence"),
+               FunctionTemplate::New(MorphSequence)->GetFunction());
     proto->Set(String::NewSymbol("thin"),
                FunctionTemplate::New(Thin)->GetFunction());
     proto->Set(String::NewSymbol("maxDynamicRange"),
                FunctionTemplate::New(MaxDynamicRange)->GetFunction());
     proto->Set(String::NewSymbol("otsuAdaptiveThreshold"),
                FunctionTemplate::New(OtsuAdaptiveThreshold)->GetFunction());
+    proto->Set(String::NewSymbol("sauvolaBinarize"),
+               FunctionTemplate::New(SauvolaBinarize)->GetFunction());
+    proto->Set(String::NewSymbol("backgroundNorm"),
+               FunctionTemplate::New(BackgroundNorm)->GetFunction());
+    proto->Set(String::NewSymbol("backgroundMap"),
+               FunctionTemplate::New(BackgroundMap)->GetFunction());
+    proto->Set(String::NewSymbol("runPipeline"),
+               FunctionTemplate::New(RunPipeline)->GetFunction());
     proto->Set(String::NewSymbol("findSkew"),
                FunctionTemplate::New(FindSkew)->GetFunction());
+    proto->Set(String::NewSymbol("detectOrientation"),
+               FunctionTemplate::New(DetectOrientation)->GetFunction());
+    proto->Set(String::NewSymbol("fingerprint"),
+               FunctionTemplate::New(Fingerprint)->GetFunction());
     proto->Set(String::NewSymbol("connectedComponents"),
                FunctionTemplate::New(ConnectedComponents)->GetFunction());
     proto->Set(String::NewSymbol("distanceFunction"),
                FunctionTemplate::New(DistanceFunction)->GetFunction());
+    proto->Set(String::NewSymbol("edgeFilter"),
+               FunctionTemplate::New(EdgeFilter)->GetFunction());
+    proto->Set(String::NewSymbol("edgeDensity"),
+               FunctionTemplate::New(EdgeDensity)->GetFunction());
     proto->Set(String::NewSymbol("clearBox"),
                FunctionTemplate::New(ClearBox)->GetFunction());
     proto->Set(String::NewSymbol("drawBox"),
                FunctionTemplate::New(DrawBox)->GetFunction());
     proto->Set(String::NewSymbol("toBuffer"),
                FunctionTemplate::New(ToBuffer)->GetFunction());
-    target->Set(String::NewSymbol("Image"),
-                Persistent<Function>::New(constructor_template->GetFunction()));
+    proto->Set(String::NewSymbol("share"),
+               FunctionTemplate::New(Share)->GetFunction());
+    constructor_template->Set(String::NewSymbol("fromShared"),
+                              FunctionTemplate::New(FromShared)->GetFunction());
+    uv_mutex_lock(&templatesMutex);
+    Persistent<FunctionTemplate> &stored = templates[Isolate::GetCurrent()];
+    if (!stored.IsEmpty()) {
+        stored.Dispose();
+    }
+    stored = Persistent<FunctionTemplate>::New(constructor_template);
+    uv_mutex_unlock(&templatesMutex);
+    target->Set(String::NewSymbol("Image"), constructor_template->GetFunction());
+}
+
+Pix *Image::Decode(const char *format, const unsigned char *in, size_t inLength,
+                   std::string &error)
+{
+    // Touches no V8 state, so that batches can decode on worker threads.
+    Pix *pix;
+    if (strcmp("png", format) == 0) {
+        std::vector<unsigned char> out;
+        unsigned int width;
+        unsigned int height;
+        lodepng::State state;
+        unsigned code = lodepng::decode(out, width, height, state, in, inLength);
+        if (code) {
+            std::stringstream msg;
+            msg << "error while decoding '" << lodepng_error_text(code) << "'";
+            error = msg.str();
+            return NULL;
+        }
+        if (state.info_png.color.colortype == LCT_GREY || state.info_png.color.colortype == LCT_GREY_ALPHA) {
+            pix = pixFromSource(&out[0], width, height, 32, 8);
+        } else {
+            pix = pixFromSource(&out[0], width, height, 32, 32);
+        }
+    } else if (strcmp("jpg", format) == 0) {
+        int width;
+        int height;
+        int comps;
+        unsigned char *out = jpgd::decompress_jpeg_image_from_memory(
+                    in, static_cast<int>(inLength), &width, &height, &comps, 4);
+        if (!out) {
+            error = "error while decoding jpg";
+            return NULL;
+        }
+        pix = pixFromSource(out, width, height, 32, comps == 1 ? 8 : 32);
+        free(out);
+    } else {
+        std::stringstream msg;
+        msg << "invalid bufffer format '" << format << "'";
+        error = msg.str();
+        return NULL;
+    }
+    return pix;
 }
 
 Handle<Value> Image::New(Pix *pix)
 {
     HandleScope scope;
-    Local<Object> instance = constructor_template->GetFunction()->NewInstance();
+    Local<Object> instance = Template()->GetFunction()->NewInstance();
     Image *obj = ObjectWrap::Unwrap<Image>(instance);
-    obj->pix_ = pix;
+    obj->setPix(pix);
     return scope.Close(instance);
 }
 
+Pix *Image::WritablePix(Handle<Object> target, Pix *pixs1, Pix *pixs2)
+{
+    // Only reuse pixels that nobody else sees and that fit the result.
+    if (target.IsEmpty()) {
+        return NULL;
+    }
+    Pix *pix = Image::Pixels(target);
+    if (!pix || pixGetRefcount(pix) > 1 || pix == pixs2
+            || !pixSizesEqual(pix, pixs1)) {
+        return NULL;
+    }
+    return pix;
+}
+
+Handle<Value> Image::Store(Handle<Object> target, Pix *pixd)
+{
+    if (target.IsEmpty()) {
+        return Image::New(pixd);
+    }
+    Image *obj = ObjectWrap::Unwrap<Image>(target);
+    if (obj->pix_ != pixd) {
+        obj->setPix(pixd);
+    }
+    return target;
+}
+
 Handle<Value> Image::New(const Arguments &args)
 {
     HandleScope scope;
@@ -146,43 +527,16 @@ Handle<Value> Image::New(const Arguments &args)
     if (args.Length() == 0) {
         pix = 0;
     } else if (args.Length() == 1 &&  Image::HasInstance(args[0])) {
-        pix = pixCopy(NULL, Image::Pixels(args[0]->ToObject()));
+        // Pixels are shared until either image is modified.
+        pix = pixClone(Image::Pixels(args[0]->ToObject()));
     } else if (args.Length() == 2 && Buffer::HasInstance(args[1])) {
         String::AsciiValue format(args[0]->ToString());
         Local<Object> buffer = args[1]->ToObject();
         unsigned char *in = reinterpret_cast<unsigned char*>(Buffer::Data(buffer));
-        size_t inLength = Buffer::Length(buffer);
-        if (strcmp("png", *format) == 0) {
-            std::vector<unsigned char> out;
-            unsigned int width;
-            unsigned int height;
-            lodepng::State state;
-            unsigned error = lodepng::decode(out, width, height, state, in, inLength);
-            if (error) {
-                std::stringstream msg;
-                msg << "error while decoding '" << lodepng_error_text(error) << "'";
-                return THROW(Error, msg.str().c_str());
-            }
-            if (state.info_png.color.colortype == LCT_GREY || state.info_png.color.colortype == LCT_GREY_ALPHA) {
-                pix = pixFromSource(&out[0], width, height, 32, 8);
-            } else {
-                pix = pixFromSource(&out[0], width, height, 32, 32);
-            }
-        } else if (strcmp("jpg", *format) == 0) {
-            int width;
-            int height;
-            int comps;
-            unsigned char *out = jpgd::decompress_jpeg_image_from_memory(
-                        in, static_cast<int>(inLength), &width, &height, &comps, 4);
-            if (!out) {
-                return THROW(Error, "error while decoding jpg");
-            }
-            pix = pixFromSource(out, width, height, 32, comps == 1 ? 8 : 32);
-            free(out);
-        } else {
-            std::stringstream msg;
-            msg << "invalid bufffer format '" << *format << "'";
-            return THROW(Error, msg.str().c_str());
+        std::string error;
+        pix = Decode(*format, in, Buffer::Length(buffer), error);
+        if (!pix) {
+            return THROW(Error, error.c_str());
         }
     } else if (args.Length() == 4 && Buffer::HasInstance(args[1])) {
         String::AsciiValue format(args[0]->ToString());
@@ -237,26 +591,36 @@ Handle<Value> Image::Invert(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    Pix *pixd = pixInvert(NULL, obj->pix_);
+    Handle<Object> target;
+    if (!parseTargetOption(args, 0, target)) {
+        return THROW(TypeError, "expected ([object]) signature");
+    }
+    Pix *pixd = pixInvert(WritablePix(target, obj->pix_), obj->pix_);
     if (pixd == NULL) {
         return THROW(TypeError, "error while applying INVERT");
     }
-    return scope.Close(Image::New(pixd));
+    return scope.Close(Store(target, pixd));
 }
 
 Handle<Value> Image::Or(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 1 && Image::HasInstance(args[0])) {
+    Handle<Object> target;
+    if (args.Length() >= 1 && Image::HasInstance(args[0])
+            && parseTargetOption(args, 1, target)) {
         Pix *otherPix = Image::Pixels(args[0]->ToObject());
-        Pix *pixd = pixOr(NULL, obj->pix_, otherPix);
+        if (!operandsMatch(obj->pix_, otherPix)) {
+            return THROW(Error, "images must have the same size and depth");
+        }
+        Pix *pixd = pixOr(WritablePix(target, obj->pix_, otherPix),
+                          obj->pix_, otherPix);
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying OR");
         }
-        return scope.Close(Image::New(pixd));
+        return scope.Close(Store(target, pixd));
     } else {
-        return THROW(TypeError, "expected image as first argument");
+        return THROW(TypeError, "expected (image[, object]) signature");
     }
 }
 
@@ -264,15 +628,21 @@ Handle<Value> Image::And(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 1 && Image::HasInstance(args[0])) {
+    Handle<Object> target;
+    if (args.Length() >= 1 && Image::HasInstance(args[0])
+            && parseTargetOption(args, 1, target)) {
         Pix *otherPix = Image::Pixels(args[0]->ToObject());
-        Pix *pixd = pixAnd(NULL, obj->pix_, otherPix);
+        if (!operandsMatch(obj->pix_, otherPix)) {
+            return THROW(Error, "images must have the same size and depth");
+        }
+        Pix *pixd = pixAnd(WritablePix(target, obj->pix_, otherPix),
+                           obj->pix_, otherPix);
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying AND");
         }
-        return scope.Close(Image::New(pixd));
+        return scope.Close(Store(target, pixd));
     } else {
-        return THROW(TypeError, "expected image as first argument");
+        return THROW(TypeError, "expected (image[, object]) signature");
     }
 }
 
@@ -280,15 +650,21 @@ Handle<Value> Image::Xor(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 1 && Image::HasInstance(args[0])) {
+    Handle<Object> target;
+    if (args.Length() >= 1 && Image::HasInstance(args[0])
+            && parseTargetOption(args, 1, target)) {
         Pix *otherPix = Image::Pixels(args[0]->ToObject());
-        Pix *pixd = pixXor(NULL, obj->pix_, otherPix);
+        if (!operandsMatch(obj->pix_, otherPix)) {
+            return THROW(Error, "images must have the same size and depth");
+        }
+        Pix *pixd = pixXor(WritablePix(target, obj->pix_, otherPix),
+                           obj->pix_, otherPix);
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying XOR");
         }
-        return scope.Close(Image::New(pixd));
+        return scope.Close(Store(target, pixd));
     } else {
-        return THROW(TypeError, "expected image as first argument");
+        return THROW(TypeError, "expected (image[, object]) signature");
     }
 }
 
@@ -296,20 +672,29 @@ Handle<Value> Image::Subtract(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 1 && Image::HasInstance(args[0])) {
+    Handle<Object> target;
+    if (args.Length() >= 1 && Image::HasInstance(args[0])
+            && parseTargetOption(args, 1, target)) {
         Pix *otherPix = Image::Pixels(args[0]->ToObject());
+        if (!operandsMatch(obj->pix_, otherPix)) {
+            return THROW(Error, "images must have the same size and depth");
+        }
+        if (obj->pix_->d >= 8 && obj->pix_ == otherPix) {
+            return THROW(Error, "cannot subtract an image from itself");
+        }
         Pix *pixd;
+        Pix *dest = WritablePix(target, obj->pix_, otherPix);
         if(obj->pix_->d >= 8) {
-            pixd = pixSubtractGray(NULL, obj->pix_, otherPix);
+            pixd = pixSubtractGray(dest, obj->pix_, otherPix);
         } else {
-            pixd = pixSubtract(NULL, obj->pix_, otherPix);
+            pixd = pixSubtract(dest, obj->pix_, otherPix);
         }
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying SUBTRACT");
         }
-        return scope.Close(Image::New(pixd));
+        return scope.Close(Store(target, pixd));
     } else {
-        return THROW(TypeError, "expected image as first argument");
+        return THROW(TypeError, "expected (image[, object]) signature");
     }
 }
 
@@ -320,14 +705,7 @@ Handle<Value> Image::Convolve(const Arguments &args)
     if (args.Length() == 2 && args[0]->IsInt32() && args[1]->IsInt32()) {
         int width = args[0]->Int32Value();
         int height = args[1]->Int32Value();
-        Pix *pixs;
-        if(obj->pix_->d == 1) {
-            pixs = pixConvert1To8(NULL, obj->pix_, 0, 255);
-        } else {
-            pixs = pixClone(obj->pix_);
-        }
-        Pix *pixd = pixBlockconv(pixs, width, height);
-        pixDestroy(&pixs);
+        Pix *pixd = neighborhoodFilter(obj->pix_, convolveTile, width, height);
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying convolve");
         }
@@ -341,18 +719,62 @@ Handle<Value> Image::Rotate(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 1 && args[0]->IsNumber()) {
+    if ((args.Length() == 1 || (args.Length() == 2 && args[1]->IsString()))
+            && args[0]->IsNumber()) {
         const float deg2rad = 3.1415926535 / 180.;
         float angle = args[0]->ToNumber()->Value();
-        Pix *pixd = pixRotate(obj->pix_, deg2rad * angle,
-                              L_ROTATE_AREA_MAP, L_BRING_IN_WHITE,
-                              obj->pix_->w, obj->pix_->h);
+        String::AsciiValue mode(args.Length() == 2 ? args[1]->ToString() : String::New("auto"));
+        // Multiples of 90 degrees are rotated exactly (without interpolation),
+        // so 90 and 270 swap width and height. The other modes rotate within
+        // a canvas grown to hold the whole rotated image, so they usually
+        // return a larger image.
+        float quadsFloat = angle / 90.;
+        int quads = static_cast<int>(floor(quadsFloat + 0.5));
+        bool orthogonal = fabs(quadsFloat - quads) < 1e-6;
+        quads = ((quads % 4) + 4) % 4;
+        int typeInt;
+        if (strcmp("auto", *mode) == 0) {
+            if (orthogonal) {
+                typeInt = -1;
+            } else if (obj->pix_->d == 1 && fabs(angle) <= 20.) {
+                typeInt = L_ROTATE_SHEAR;
+            } else {
+                typeInt = L_ROTATE_AREA_MAP;
+            }
+        } else if (strcmp("orthogonal", *mode) == 0) {
+            if (!orthogonal) {
+                return THROW(Error, "expected angle to be a multiple of 90");
+            }
+            typeInt = -1;
+        } else if (strcmp("shear", *mode) == 0) {
+            typeInt = L_ROTATE_SHEAR;
+        } else if (strcmp("sampling", *mode) == 0) {
+            typeInt = L_ROTATE_SAMPLING;
+        } else if (strcmp("areamap", *mode) == 0) {
+            typeInt = L_ROTATE_AREA_MAP;
+        } else {
+            return THROW(Error, "expected mode to be 'auto', 'orthogonal', "
+                         "'shear', 'sampling' or 'areamap'");
+        }
+        Pix *pixd;
+        if (typeInt == -1 && quads == 0) {
+            pixd = pixClone(obj->pix_);
+        } else if (typeInt == -1) {
+            pixd = pixRotateOrth(obj->pix_, quads);
+        } else if (typeInt == L_ROTATE_AREA_MAP && !pixGetColormap(obj->pix_)
+                   && (obj->pix_->d == 8 || obj->pix_->d == 32)) {
+            pixd = rotateAreaMap(obj->pix_, deg2rad * angle);
+        } else {
+            pixd = pixRotate(obj->pix_, deg2rad * angle,
+                             typeInt, L_BRING_IN_WHITE,
+                             obj->pix_->w, obj->pix_->h);
+        }
         if (pixd == NULL) {
             return THROW(TypeError, "error while rotating");
         }
         return scope.Close(Image::New(pixd));
     } else {
-        return THROW(TypeError, "expected number as first argument");
+        return THROW(TypeError, "expected (number[, string]) signature");
     }
 }
 
@@ -363,7 +785,17 @@ Handle<Value> Image::Scale(const Arguments &args)
     if ((args.Length() >= 1 && args[0]->IsNumber()) || (args.Length() == 2 && args[1]->IsNumber())) {
         float scaleX = args[0]->ToNumber()->Value();
         float scaleY = args.Length() == 2 ? args[1]->ToNumber()->Value() : scaleX;
-        Pix *pixd = pixScale(obj->pix_, scaleX, scaleY);
+        Pix *pixd;
+        bool reduce = scaleX == scaleY && scaleX < 1.0;
+        if (reduce && obj->pix_->d == 1) {
+            // Binary images are reduced to anti-aliased grayscale.
+            pixd = pixScaleToGray(obj->pix_, scaleX);
+        } else {
+            // Reductions are split into strips on the worker threads; the
+            // power of two ones take the fast 2x area map reduction and are
+            // sharpened like in pixScale().
+            pixd = stripScale(obj->pix_, scaleX, scaleY);
+        }
         if (pixd == NULL) {
             return THROW(TypeError, "error while scaling");
         }
@@ -435,6 +867,9 @@ Handle<Value> Image::SetMasked(const Arguments &args)
             args[1]->IsNumber()) {
         Pix *mask = Image::Pixels(args[0]->ToObject());
         int value = floor(args[1]->ToNumber()->Value());
+        if (!obj->detach()) {
+            return THROW(Error, "error while copying pixels");
+        }
         if (pixSetMasked(obj->pix_, mask, value) == 1) {
             return THROW(TypeError, "error while cropping");
         }
@@ -457,6 +892,9 @@ Handle<Value> Image::ApplyCurve(const Arguments &args)
         if (args.Length() >= 2 && Image::HasInstance(args[1])) {
             mask = Image::Pixels(args[1]->ToObject());
         }
+        if (!obj->detach()) {
+            return THROW(Error, "error while copying pixels");
+        }
         int result = pixTRCMap(obj->pix_, mask, numa);
         if (result != 0) {
             return THROW(TypeError, "error while applying value mapping");
@@ -476,7 +914,7 @@ Handle<Value> Image::RankFilter(const Arguments &args)
         int width = args[0]->ToInt32()->Value();
         int height = args[1]->ToInt32()->Value();
         float rank = args[2]->ToNumber()->Value();
-        PIX *pixd = pixRankFilter(obj->pix_, width, height, rank);
+        PIX *pixd = neighborhoodFilter(obj->pix_, rankFilterTile, width, height, rank);
         if (pixd == NULL) {
             return THROW(TypeError, "error while applying rank filter");
         }
@@ -572,6 +1010,9 @@ Handle<Value> Image::ClearBox(const Arguments &args)
         int top = floor(args[1]->ToNumber()->Value());
         int width = ceil(args[2]->ToNumber()->Value());
         int height = ceil(args[3]->ToNumber()->Value());
+        if (!obj->detach()) {
+            return THROW(Error, "error while copying pixels");
+        }
         BOX *box = boxCreate(left, top, width, height);
         int error;
         if (obj->pix_->d == 1) {
@@ -593,21 +1034,27 @@ Handle<Value> Image::Erode(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 2 && args[0]->IsInt32() && args[1]->IsInt32()) {
+    Handle<Object> target;
+    if (args.Length() >= 2 && args[0]->IsInt32() && args[1]->IsInt32()
+            && parseTargetOption(args, 2, target)) {
         int width = args[0]->ToInt32()->Value();
         int height = args[1]->ToInt32()->Value();
+        if (width < 1 || height < 1) {
+            return THROW(Error, "width and height must be at least 1");
+        }
         PIX *pixd = 0;
         if (obj->pix_->d == 1) {
-            pixd = pixErodeBrick(NULL, obj->pix_, width, height);
+            pixd = pixErodeBrick(WritablePix(target, obj->pix_), obj->pix_,
+                                  width, height);
         } else {
-            pixd = pixErodeGray(obj->pix_, width, height);
+            pixd = neighborhoodFilter(obj->pix_, erodeGrayTile, width, height);
         }
         if (pixd == NULL) {
             return THROW(TypeError, "error while eroding");
         }
-        return scope.Close(Image::New(pixd));
+        return scope.Close(Store(target, pixd));
     } else {
-        return THROW(TypeError, "expected (int, int) signature");
+        return THROW(TypeError, "expected (int, int[, object]) signature");
     }
 }
 
@@ -615,21 +1062,53 @@ Handle<Value> Image::Dilate(const Arguments &args)
 {
     HandleScope scope;
     Image *obj = ObjectWrap::Unwrap<Image>(args.This());
-    if (args.Length() == 2 && args[0]->IsInt32() && args[1]->IsInt32()) {
+    Handle<Object> target;
+    if (args.Length() >= 2 && args[0]->IsInt32() && args[1]->IsInt32()
+            && parseTargetOption(args, 2, target)) {
         int width = args[0]->ToInt32()->Value();
         int height = args[1]->ToInt32()->Value();
+        if (width < 1 || height < 1) {
+            return THROW(Error, "width and height must be at least 1");
+        }
         PIX *pixd = 0;
         if (obj->pix_->d == 1) {
-            pixd = pixDilateBrick(NULL, obj->pix_, width, height);
+            pixd = pixDilateBrick(WritablePix(target, obj->pix_), obj->pix_,
+                                  width, height);
         } else {
-            pixd = pixDilateGray(obj->pix_, width, height);
+            pixd = neighborhoodFilter(obj->pix_, dilateGrayTile, width, height);
         }
         if (pixd == NULL) {
             return THROW(TypeError, "error while dilating");
         }
+        return scope.Close(Store(target, pixd));
+    } else {
+        return THROW(TypeError, "expected (int, int[, object]) signature");
+    }
+}
+
+Handle<Value> Image::MorphSequence(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    if (args.Length() == 1 && args[0]->IsString()) {
+        String::AsciiValue sequence(args[0]->ToString());
+        PIX *pixd;
+        if (obj->pix_->d == 1) {
+            // Runs on a bordered image with two ping-pong buffers.
+            pixd = pixMorphCompSequenceDwa(obj->pix_, *sequence, 0);
+        } else if (obj->pix_->d == 8) {
+            pixd = pixGrayMorphSequence(obj->pix_, *sequence, 0, 0);
+        } else if (obj->pix_->d == 32) {
+            pixd = pixColorMorphSequence(obj->pix_, *sequence, 0, 0);
+        } else {
+            return THROW(TypeError, "expected binary, grayscale or RGB image");
+        }
+        if (pixd == NULL) {
+            return THROW(Error, "error while running morphological sequence");
+        }
         return scope.Close(Image::New(pixd));
     } else {
-        return THROW(TypeError, "expected (int, int) signature");
+        return THROW(TypeError, "expected (string) signature");
     }
 }
 
@@ -703,7 +1182,7 @@ Handle<Value> Image::OtsuAdaptiveThreshold(const Arguments &args)
             float scorefact = args[4]->ToNumber()->Value();
             PIX *ppixth;
             PIX *ppixd;
-            int error = pixOtsuAdaptiveThreshold(
+            int error = tileOtsuAdaptiveThreshold(
                         obj->pix_, sx, sy, smoothx, smoothy,
                         scorefact, &ppixth, &ppixd);
             if (error == 0) {
@@ -722,6 +1201,315 @@ Handle<Value> Image::OtsuAdaptiveThreshold(const Arguments &args)
     }
 }
 
+Handle<Value> Image::SauvolaBinarize(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    if (args.Length() >= 2 && args.Length() <= 4 && args[0]->IsInt32()
+            && args[1]->IsNumber()
+            && (args.Length() < 3 || args[2]->IsInt32())
+            && (args.Length() < 4 || args[3]->IsInt32())) {
+        int32_t whsize = (args[0]->ToInt32()->Value() - 1) / 2;
+        float factor = args[1]->ToNumber()->Value();
+        int32_t tilesX = args.Length() >= 3 ? args[2]->ToInt32()->Value() : 1;
+        int32_t tilesY = args.Length() >= 4 ? args[3]->ToInt32()->Value() : 1;
+        if (whsize < 2 || factor < 0 || tilesX < 1 || tilesY < 1) {
+            return THROW(Error, "expected windowSize >= 5, k >= 0 and tile counts >= 1");
+        }
+        PIX *pixs = obj->pix_->d == 8 ? pixClone(obj->pix_) : pixConvertTo8(obj->pix_, 0);
+        if (pixs == NULL || pixs->w < 2 * whsize + 3 || pixs->h < 2 * whsize + 3) {
+            pixDestroy(&pixs);
+            return THROW(Error, "windowSize too large for image");
+        }
+        // Both integral images are computed once for the whole page.
+        PIX *pixg = pixAddMirroredBorder(pixs, whsize + 1, whsize + 1,
+                                         whsize + 1, whsize + 1);
+        SauvolaTiles tiles;
+        tiles.pixs = pixs;
+        tiles.pixm = pixWindowedMean(pixg, whsize, whsize, 1, 1);
+        tiles.pixms = pixWindowedMeanSquare(pixg, whsize, whsize, 1);
+        tiles.factor = factor;
+        pixDestroy(&pixg);
+        // Tile columns start on word boundaries of the binary image.
+        int tileWidth = ((pixs->w + tilesX - 1) / tilesX + 31) & ~31;
+        int tileHeight = (pixs->h + tilesY - 1) / tilesY;
+        for (int y = 0; y < static_cast<int>(pixs->h); y += tileHeight) {
+            for (int x = 0; x < static_cast<int>(pixs->w); x += tileWidth) {
+                tiles.boxes.push_back(boxCreate(x, y, tileWidth, tileHeight));
+            }
+        }
+        tiles.thresholds.resize(tiles.boxes.size(), NULL);
+        tiles.images.resize(tiles.boxes.size(), NULL);
+        if (tiles.pixm && tiles.pixms) {
+            parallelFor(tiles.boxes.size(), sauvolaBinarizeTile, &tiles);
+        }
+        PIX *pixth = pixCreate(pixs->w, pixs->h, 8);
+        PIX *pixd = pixCreate(pixs->w, pixs->h, 1);
+        bool error = false;
+        for (size_t i = 0; i < tiles.boxes.size(); ++i) {
+            Box *box = tiles.boxes[i];
+            if (tiles.thresholds[i] && tiles.images[i]) {
+                pixRasterop(pixth, box->x, box->y, box->w, box->h, PIX_SRC,
+                            tiles.thresholds[i], 0, 0);
+                pixRasterop(pixd, box->x, box->y, box->w, box->h, PIX_SRC,
+                            tiles.images[i], 0, 0);
+            } else {
+                error = true;
+            }
+            pixDestroy(&tiles.thresholds[i]);
+            pixDestroy(&tiles.images[i]);
+            boxDestroy(&box);
+        }
+        pixDestroy(&tiles.pixm);
+        pixDestroy(&tiles.pixms);
+        pixDestroy(&pixs);
+        if (error) {
+            pixDestroy(&pixth);
+            pixDestroy(&pixd);
+            return THROW(Error, "error while computing threshold");
+        }
+        Local<Object> object = Object::New();
+        object->Set(String::NewSymbol("thresholdValues"), Image::New(pixth));
+        object->Set(String::NewSymbol("image"), Image::New(pixd));
+        return scope.Close(object);
+    } else {
+        return THROW(TypeError, "expected (int, float[, int, int]) signature");
+    }
+}
+
+Handle<Value> Image::BackgroundNorm(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    PIX *pixd;
+    if (args.Length() == 1 && args[0]->IsObject() && !args[0]->IsString()) {
+        // Apply a map previously made by backgroundMap().
+        Local<Object> map = args[0]->ToObject();
+        int32_t tileWidth = map->Get(String::NewSymbol("tileWidth"))->Int32Value();
+        int32_t tileHeight = map->Get(String::NewSymbol("tileHeight"))->Int32Value();
+        Local<Value> gray = map->Get(String::NewSymbol("gray"));
+        Local<Value> red = map->Get(String::NewSymbol("red"));
+        Local<Value> green = map->Get(String::NewSymbol("green"));
+        Local<Value> blue = map->Get(String::NewSymbol("blue"));
+        if (tileWidth <= 0 || tileHeight <= 0) {
+            return THROW(Error, "tile width and height must be at least 1");
+        }
+        if (obj->pix_->d == 8 && Image::HasInstance(gray)) {
+            if (!backgroundMapMatches(Image::Pixels(gray->ToObject()), obj->pix_,
+                                      tileWidth, tileHeight)) {
+                return THROW(Error, "background map does not match image size");
+            }
+            pixd = pixApplyInvBackgroundGrayMap(
+                        obj->pix_, Image::Pixels(gray->ToObject()),
+                        tileWidth, tileHeight);
+        } else if (obj->pix_->d == 32 && Image::HasInstance(red)
+                   && Image::HasInstance(green) && Image::HasInstance(blue)) {
+            if (!backgroundMapMatches(Image::Pixels(red->ToObject()), obj->pix_,
+                                      tileWidth, tileHeight)
+                    || !backgroundMapMatches(Image::Pixels(green->ToObject()), obj->pix_,
+                                             tileWidth, tileHeight)
+                    || !backgroundMapMatches(Image::Pixels(blue->ToObject()), obj->pix_,
+                                             tileWidth, tileHeight)) {
+                return THROW(Error, "background map does not match image size");
+            }
+            pixd = pixApplyInvBackgroundRGBMap(
+                        obj->pix_, Image::Pixels(red->ToObject()),
+                        Image::Pixels(green->ToObject()),
+                        Image::Pixels(blue->ToObject()),
+                        tileWidth, tileHeight);
+        } else {
+            return THROW(TypeError, "background map does not match image depth");
+        }
+    } else {
+        BackgroundParams params;
+        if (!parseBackgroundParams(args, params)) {
+            return THROW(TypeError, "expected () or (int, int, int, int, int, int, int) or "
+                         "(\"morph\"[, int, int, int]) or (map) signature");
+        }
+        if (params.morph) {
+            pixd = pixBackgroundNormMorph(obj->pix_, NULL, params.reduction,
+                                          params.size, params.backgroundValue);
+        } else {
+            pixd = pixBackgroundNorm(obj->pix_, NULL, NULL,
+                                     params.tileWidth, params.tileHeight,
+                                     params.threshold, params.minCount,
+                                     params.backgroundValue,
+                                     params.smoothX, params.smoothY);
+        }
+    }
+    if (pixd == NULL) {
+        return THROW(Error, "error while normalizing background");
+    }
+    return scope.Close(Image::New(pixd));
+}
+
+Handle<Value> Image::BackgroundMap(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    BackgroundParams params;
+    if (!parseBackgroundParams(args, params)) {
+        return THROW(TypeError, "expected () or (int, int, int, int, int, int, int) or "
+                     "(\"morph\"[, int, int, int]) signature");
+    }
+    int error;
+    Local<Object> map = Object::New();
+    if (obj->pix_->d == 8) {
+        PIX *pixm = NULL;
+        if (params.morph) {
+            error = pixBackgroundNormGrayArrayMorph(
+                        obj->pix_, NULL, params.reduction, params.size,
+                        params.backgroundValue, &pixm);
+        } else {
+            error = pixBackgroundNormGrayArray(
+                        obj->pix_, NULL, params.tileWidth, params.tileHeight,
+                        params.threshold, params.minCount, params.backgroundValue,
+                        params.smoothX, params.smoothY, &pixm);
+        }
+        if (error || !pixm) {
+            pixDestroy(&pixm);
+            return THROW(Error, "error while computing background map");
+        }
+        map->Set(String::NewSymbol("gray"), Image::New(pixm));
+    } else if (obj->pix_->d == 32) {
+        PIX *pixmr = NULL;
+        PIX *pixmg = NULL;
+        PIX *pixmb = NULL;
+        if (params.morph) {
+            error = pixBackgroundNormRGBArraysMorph(
+                        obj->pix_, NULL, params.reduction, params.size,
+                        params.backgroundValue, &pixmr, &pixmg, &pixmb);
+        } else {
+            error = pixBackgroundNormRGBArrays(
+                        obj->pix_, NULL, NULL, params.tileWidth, params.tileHeight,
+                        params.threshold, params.minCount, params.backgroundValue,
+                        params.smoothX, params.smoothY, &pixmr, &pixmg, &pixmb);
+        }
+        if (error || !pixmr || !pixmg || !pixmb) {
+            pixDestroy(&pixmr);
+            pixDestroy(&pixmg);
+            pixDestroy(&pixmb);
+            return THROW(Error, "error while computing background map");
+        }
+        map->Set(String::NewSymbol("red"), Image::New(pixmr));
+        map->Set(String::NewSymbol("green"), Image::New(pixmg));
+        map->Set(String::NewSymbol("blue"), Image::New(pixmb));
+    } else {
+        return THROW(TypeError, "expected grayscale or RGB image");
+    }
+    // The morphological maps are computed at the reduced scale.
+    map->Set(String::NewSymbol("tileWidth"),
+             Int32::New(params.morph ? params.reduction : params.tileWidth));
+    map->Set(String::NewSymbol("tileHeight"),
+             Int32::New(params.morph ? params.reduction : params.tileHeight));
+    return scope.Close(map);
+}
+
+bool parsePipelineOp(Handle<Value> value, PipelineOp &op)
+{
+    if (!value->IsArray()) {
+        return false;
+    }
+    Local<Array> args = Local<Array>::Cast(value);
+    if (args->Length() == 0 || !args->Get(0)->IsString()) {
+        return false;
+    }
+    String::AsciiValue name(args->Get(0)->ToString());
+    uint32_t length = args->Length() - 1;
+    op.grayType = 0;
+    op.hasWeights = false;
+    if (strcmp("toGray", *name) == 0) {
+        op.type = PipelineOp::ToGray;
+        if (length == 3) {
+            if (!args->Get(1)->IsNumber() || !args->Get(2)->IsNumber()
+                    || !args->Get(3)->IsNumber()) {
+                return false;
+            }
+            op.hasWeights = true;
+            for (int i = 0; i < 3; ++i) {
+                op.weights[i] = args->Get(i + 1)->NumberValue();
+            }
+        } else if (length == 1 && args->Get(1)->IsString()) {
+            String::AsciiValue type(args->Get(1)->ToString());
+            if (strcmp("min", *type) == 0) {
+                op.grayType = L_CHOOSE_MIN;
+            } else if (strcmp("max", *type) == 0) {
+                op.grayType = L_CHOOSE_MAX;
+            } else {
+                return false;
+            }
+        } else if (length != 0) {
+            return false;
+        }
+    } else if (strcmp("applyCurve", *name) == 0) {
+        op.type = PipelineOp::ApplyCurve;
+        if (length != 1 || !args->Get(1)->IsArray()) {
+            return false;
+        }
+        Local<Array> curve = Local<Array>::Cast(args->Get(1));
+        if (curve->Length() != 256) {
+            return false;
+        }
+        for (int i = 0; i < 256; ++i) {
+            op.curve[i] = curve->Get(i)->Int32Value();
+        }
+    } else if (strcmp("invert", *name) == 0) {
+        op.type = PipelineOp::Invert;
+        if (length != 0) {
+            return false;
+        }
+    } else if (strcmp("threshold", *name) == 0) {
+        op.type = PipelineOp::Threshold;
+        op.value = 128;
+        if (length == 1 && args->Get(1)->IsInt32()) {
+            op.value = args->Get(1)->Int32Value();
+        } else if (length != 0) {
+            return false;
+        }
+    } else {
+        if (strcmp("convolve", *name) == 0) {
+            op.type = PipelineOp::Convolve;
+        } else if (strcmp("erode", *name) == 0) {
+            op.type = PipelineOp::Erode;
+        } else if (strcmp("dilate", *name) == 0) {
+            op.type = PipelineOp::Dilate;
+        } else {
+            return false;
+        }
+        if (length != 2 || !args->Get(1)->IsInt32() || !args->Get(2)->IsInt32()) {
+            return false;
+        }
+        op.width = args->Get(1)->Int32Value();
+        op.height = args->Get(2)->Int32Value();
+    }
+    return true;
+}
+
+Handle<Value> Image::RunPipeline(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    if (args.Length() == 1 && args[0]->IsArray()) {
+        Local<Array> list = Local<Array>::Cast(args[0]);
+        std::vector<PipelineOp> ops(list->Length());
+        for (uint32_t i = 0; i < list->Length(); ++i) {
+            if (!parsePipelineOp(list->Get(i), ops[i])) {
+                std::stringstream msg;
+                msg << "invalid pipeline operation at index " << i;
+                return THROW(TypeError, msg.str().c_str());
+            }
+        }
+        const char *error = 0;
+        Pix *pixd = runPipeline(obj->pix_, ops, &error);
+        if (pixd == NULL) {
+            return THROW(Error, error);
+        }
+        return scope.Close(Image::New(pixd));
+    } else {
+        return THROW(TypeError, "expected (array) signature");
+    }
+}
+
 Handle<Value> Image::FindSkew(const Arguments &args)
 {
     HandleScope scope;
@@ -743,6 +1531,50 @@ Handle<Value> Image::FindSkew(const Arguments &args)
     }
 }
 
+Handle<Value> Image::DetectOrientation(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    if (args.Length() == 0 || (args.Length() == 1 && args[0]->IsBoolean())) {
+        bool mirror = args.Length() == 1 && args[0]->BooleanValue();
+        OrientationResult result;
+        if (!detectOrientation(obj->pix_, mirror, result)) {
+            return THROW(Error, "error while detecting orientation");
+        }
+        Local<Object> object = Object::New();
+        if (result.angle >= 0) {
+            bool upDown = result.angle % 180 == 0;
+            object->Set(String::NewSymbol("angle"), Int32::New(result.angle));
+            object->Set(String::NewSymbol("confidence"),
+                        Number::New(fabs(upDown ? result.upConfidence : result.leftConfidence)));
+        } else {
+            object->Set(String::NewSymbol("angle"), Null());
+            object->Set(String::NewSymbol("confidence"), Number::New(0));
+        }
+        object->Set(String::NewSymbol("upConfidence"), Number::New(result.upConfidence));
+        object->Set(String::NewSymbol("leftConfidence"), Number::New(result.leftConfidence));
+        if (result.hasMirror) {
+            object->Set(String::NewSymbol("mirrorConfidence"), Number::New(result.mirrorConfidence));
+        }
+        return scope.Close(object);
+    } else {
+        return THROW(TypeError, "expected ([bool]) signature");
+    }
+}
+
+Handle<Value> Image::Fingerprint(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    ::Fingerprint fingerprint;
+    if (!fingerprintCreate(obj->pix_, fingerprint)) {
+        return THROW(Error, "error while computing fingerprint");
+    }
+    std::string hex = fingerprintHex(fingerprint);
+    fingerprintDestroy(fingerprint);
+    return scope.Close(String::New(hex.c_str()));
+}
+
 Handle<Value> Image::ConnectedComponents(const Arguments &args)
 {
     HandleScope scope;
@@ -796,6 +1628,55 @@ Handle<Value> Image::DistanceFunction(const Arguments &args)
     }
 }
 
+Handle<Value> Image::EdgeFilter(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    int orientflag;
+    if (!parseEdgeOrientation(args, 0, orientflag)) {
+        return THROW(TypeError, "expected ([\"horizontal\" | \"vertical\" | \"all\"]) signature");
+    }
+    if (obj->pix_->d != 8 || pixGetColormap(obj->pix_)) {
+        return THROW(TypeError, "expected grayscale image");
+    }
+    Pix *pixd = sobelEdgeFilter(obj->pix_, orientflag);
+    if (pixd == NULL) {
+        return THROW(TypeError, "error while applying edge filter");
+    }
+    return scope.Close(Image::New(pixd));
+}
+
+Handle<Value> Image::EdgeDensity(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    int orientflag;
+    if (args.Length() < 3 || !args[0]->IsInt32() || !args[1]->IsInt32() || !args[2]->IsInt32()
+            || args[0]->Int32Value() <= 0 || args[1]->Int32Value() <= 0
+            || !parseEdgeOrientation(args, 3, orientflag)) {
+        return THROW(TypeError, "expected (blockWidth: int, blockHeight: int, threshold: int"
+                     "[, \"horizontal\" | \"vertical\" | \"all\"]) signature");
+    }
+    if (obj->pix_->d != 8 || pixGetColormap(obj->pix_)) {
+        return THROW(TypeError, "expected grayscale image");
+    }
+    std::vector<l_uint32> counts;
+    int columns, rows;
+    if (!sobelEdgeDensity(obj->pix_, orientflag, args[0]->Int32Value(), args[1]->Int32Value(),
+                          args[2]->Int32Value(), counts, columns, rows)) {
+        return THROW(TypeError, "error while computing edge density");
+    }
+    Local<Array> countArray = Array::New(counts.size());
+    for (size_t i = 0; i < counts.size(); ++i) {
+        countArray->Set(i, Uint32::New(counts[i]));
+    }
+    Local<Object> object = Object::New();
+    object->Set(String::NewSymbol("columns"), Int32::New(columns));
+    object->Set(String::NewSymbol("rows"), Int32::New(rows));
+    object->Set(String::NewSymbol("counts"), countArray);
+    return scope.Close(object);
+}
+
 Handle<Value> Image::DrawBox(const Arguments &args)
 {
     HandleScope scope;
@@ -821,6 +1702,10 @@ Handle<Value> Image::DrawBox(const Arguments &args)
                 opInt = L_FLIP_PIXELS;
             }
         }
+        if (!obj->detach()) {
+            boxDestroy(&box);
+            return THROW(Error, "error while copying pixels");
+        }
         int error = pixRenderBox(obj->pix_, box, borderWidth, opInt);
         boxDestroy(&box);
         if (error) {
@@ -906,24 +1791,67 @@ Handle<Value> Image::ToBuffer(const Arguments &args)
 }
 
 Image::Image(Pix *pix)
-    : pix_(pix)
+    : pix_(0)
 {
-    V8::AdjustAmountOfExternalAllocatedMemory(size());
+    setPix(pix);
 }
 
 Image::~Image()
 {
-    V8::AdjustAmountOfExternalAllocatedMemory(-size());
+    setPix(0);
+}
+
+Handle<Value> Image::Share(const Arguments &args)
+{
+    HandleScope scope;
+    Image *obj = ObjectWrap::Unwrap<Image>(args.This());
+    std::string error;
+    std::string name = Memory::Share(obj->pix_, error);
+    if (name.empty()) {
+        return THROW(Error, error.c_str());
+    }
+    return scope.Close(String::New(name.c_str()));
+}
+
+Handle<Value> Image::FromShared(const Arguments &args)
+{
+    HandleScope scope;
+    if (args.Length() == 1 && args[0]->IsString()) {
+        std::string error;
+        Pix *pix = Memory::MapShared(*String::AsciiValue(args[0]), error);
+        if (!pix) {
+            return THROW(Error, error.c_str());
+        }
+        return scope.Close(Image::New(pix));
+    } else {
+        return THROW(TypeError, "expected (string) signature");
+    }
+}
+
+void Image::setPix(Pix *pix)
+{
+    // Every change of ownership goes through here, so that V8 and
+    // dv.memoryStats() always see the memory we actually hold. A Pix
+    // shared by several images is accounted once, by Memory.
     if (pix_) {
+        V8::AdjustAmountOfExternalAllocatedMemory(-Memory::Untrack(pix_));
         pixDestroy(&pix_);
     }
+    pix_ = pix;
+    if (pix_) {
+        V8::AdjustAmountOfExternalAllocatedMemory(Memory::Track(pix_));
+    }
 }
 
-int Image::size() const
+bool Image::detach()
 {
-    if (pix_) {
-        return pix_->h * pix_->wpl * sizeof(uint32_t);
-    } else {
-        return 0;
+    // Copy-on-write: give this image its own pixels before mutating them.
+    if (pix_ && pixGetRefcount(pix_) > 1) {
+        Pix *pix = pixCopy(NULL, pix_);
+        if (!pix) {
+            return false;
+        }
+        setPix(pix);
     }
+    return true;
 }
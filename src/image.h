@@ -25,12 +25,11 @@
 #include <v8.h>
 #include <node.h>
 #include <allheaders.h>
+#include <string>
 
 class Image : public node::ObjectWrap
 {
 public:
-    static v8::Persistent<v8::FunctionTemplate> constructor_template;
-
     static bool HasInstance(v8::Handle<v8::Value> val);
     static Pix *Pixels(v8::Handle<v8::Object> obj);
 
@@ -38,7 +37,12 @@ public:
 
     static v8::Handle<v8::Value> New(Pix *pix);
 
+    // Decodes "png" or "jpg" data. Returns NULL and sets error on failure.
+    static Pix *Decode(const char *format, const unsigned char *in, size_t length,
+                       std::string &error);
+
 private:
+    static v8::Handle<v8::FunctionTemplate> Template();
     static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
     // Accessors.
@@ -64,20 +68,35 @@ private:
     static v8::Handle<v8::Value> ToGray(const v8::Arguments& args);
     static v8::Handle<v8::Value> Erode(const v8::Arguments& args);
     static v8::Handle<v8::Value> Dilate(const v8::Arguments& args);
+    static v8::Handle<v8::Value> MorphSequence(const v8::Arguments& args);
     static v8::Handle<v8::Value> Thin(const v8::Arguments& args);
     static v8::Handle<v8::Value> MaxDynamicRange(const v8::Arguments &args);
     static v8::Handle<v8::Value> OtsuAdaptiveThreshold(const v8::Arguments& args);
+    static v8::Handle<v8::Value> SauvolaBinarize(const v8::Arguments& args);
+    static v8::Handle<v8::Value> BackgroundNorm(const v8::Arguments& args);
+    static v8::Handle<v8::Value> BackgroundMap(const v8::Arguments& args);
+    static v8::Handle<v8::Value> RunPipeline(const v8::Arguments& args);
     static v8::Handle<v8::Value> FindSkew(const v8::Arguments& args);
+    static v8::Handle<v8::Value> DetectOrientation(const v8::Arguments& args);
+    static v8::Handle<v8::Value> Fingerprint(const v8::Arguments& args);
     static v8::Handle<v8::Value> ConnectedComponents(const v8::Arguments& args);
     static v8::Handle<v8::Value> DistanceFunction(const v8::Arguments& args);
+    static v8::Handle<v8::Value> EdgeFilter(const v8::Arguments& args);
+    static v8::Handle<v8::Value> EdgeDensity(const v8::Arguments& args);
     static v8::Handle<v8::Value> ClearBox(const v8::Arguments& args);
     static v8::Handle<v8::Value> DrawBox(const v8::Arguments& args);
     static v8::Handle<v8::Value> ToBuffer(const v8::Arguments& args);
+    static v8::Handle<v8::Value> Share(const v8::Arguments& args);
+    static v8::Handle<v8::Value> FromShared(const v8::Arguments& args);
 
     Image(Pix *pix);
     ~Image();
 
-    int size() const;
+    void setPix(Pix *pix);
+    bool detach();
+
+    static Pix *WritablePix(v8::Handle<v8::Object> target, Pix *pixs1, Pix *pixs2 = 0);
+    static v8::Handle<v8::Value> Store(v8::Handle<v8::Object> target, Pix *pixd);
 
     Pix *pix_;
 };
@@ -0,0 +1,392 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "imagestore.h"
+#include "image.h"
+#include "memory.h"
+#include "util.h"
+#include <lodepng.h>
+#include <cstdlib>
+#include <cstring>
+
+using namespace v8;
+using namespace node;
+
+namespace {
+
+// Cache budget of a store created without one.
+const int64_t DEFAULT_BUDGET = 64 * 1024 * 1024;
+
+int64_t pixelBytes(Pix *pix)
+{
+    return static_cast<int64_t>(pix->h) * pix->wpl * sizeof(uint32_t);
+}
+
+// The store owns its decoded pages like an Image does.
+void holdPix(Pix *pix)
+{
+    V8::AdjustAmountOfExternalAllocatedMemory(Memory::Track(pix));
+}
+
+void releasePix(Pix **ppix)
+{
+    V8::AdjustAmountOfExternalAllocatedMemory(-Memory::Untrack(*ppix));
+    pixDestroy(ppix);
+}
+
+// PackBits run-length coding, which suits the long runs of white in
+// binary pages far better than deflate does for its cost.
+void packBits(const unsigned char *in, size_t size, std::vector<unsigned char> &out)
+{
+    size_t i = 0;
+    while (i < size) {
+        size_t run = 1;
+        while (i + run < size && run < 128 && in[i + run] == in[i]) {
+            ++run;
+        }
+        if (run >= 3) {
+            out.push_back(static_cast<unsigned char>(257 - run));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+        size_t literal = 0;
+        while (i + literal < size && literal < 128) {
+            if (i + literal + 2 < size && in[i + literal] == in[i + literal + 1]
+                    && in[i + literal] == in[i + literal + 2]) {
+                break;
+            }
+            ++literal;
+        }
+        out.push_back(static_cast<unsigned char>(literal - 1));
+        out.insert(out.end(), in + i, in + i + literal);
+        i += literal;
+    }
+}
+
+bool unpackBits(const std::vector<unsigned char> &in, unsigned char *out, size_t size)
+{
+    size_t i = 0;
+    size_t o = 0;
+    while (i < in.size()) {
+        unsigned char header = in[i++];
+        if (header < 128) {
+            size_t literal = header + 1;
+            if (i + literal > in.size() || o + literal > size) {
+                return false;
+            }
+            memcpy(out + o, &in[i], literal);
+            i += literal;
+            o += literal;
+        } else if (header > 128) {
+            size_t run = 257 - header;
+            if (i >= in.size() || o + run > size) {
+                return false;
+            }
+            memset(out + o, in[i++], run);
+            o += run;
+        }
+    }
+    return o == size;
+}
+
+}
+
+void ImageStore::Init(Handle<Object> target)
+{
+    Local<FunctionTemplate> constructor_template = FunctionTemplate::New(New);
+    constructor_template->SetClassName(String::NewSymbol("ImageStore"));
+    constructor_template->InstanceTemplate()->SetInternalFieldCount(1);
+    Local<ObjectTemplate> proto = constructor_template->PrototypeTemplate();
+    proto->SetAccessor(String::NewSymbol("length"), GetLength);
+    proto->SetAccessor(String::NewSymbol("budget"), GetBudget, SetBudget);
+    proto->SetAccessor(String::NewSymbol("compressedBytes"), GetCompressedBytes);
+    proto->SetAccessor(String::NewSymbol("cachedBytes"), GetCachedBytes);
+    proto->Set(String::NewSymbol("add"),
+               FunctionTemplate::New(Add)->GetFunction());
+    proto->Set(String::NewSymbol("get"),
+               FunctionTemplate::New(Get)->GetFunction());
+    proto->Set(String::NewSymbol("set"),
+               FunctionTemplate::New(Set)->GetFunction());
+    proto->Set(String::NewSymbol("clear"),
+               FunctionTemplate::New(Clear)->GetFunction());
+    target->Set(String::NewSymbol("ImageStore"), constructor_template->GetFunction());
+}
+
+Handle<Value> ImageStore::New(const Arguments &args)
+{
+    HandleScope scope;
+    int64_t budget = DEFAULT_BUDGET;
+    if (args.Length() == 1 && args[0]->IsNumber() && args[0]->NumberValue() >= 0) {
+        budget = args[0]->IntegerValue();
+    } else if (args.Length() != 0) {
+        return THROW(TypeError, "cannot convert argument list to "
+                     "() or "
+                     "(budget: number)");
+    }
+    ImageStore* obj = new ImageStore(budget);
+    obj->Wrap(args.This());
+    return args.This();
+}
+
+Handle<Value> ImageStore::GetLength(Local<String> prop, const AccessorInfo &info)
+{
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(info.This());
+    return Number::New(obj->pages_.size());
+}
+
+Handle<Value> ImageStore::GetBudget(Local<String> prop, const AccessorInfo &info)
+{
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(info.This());
+    return Number::New(obj->budget_);
+}
+
+void ImageStore::SetBudget(Local<String> prop, Local<Value> value, const AccessorInfo &info)
+{
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(info.This());
+    if (value->IsNumber() && value->NumberValue() >= 0) {
+        obj->budget_ = value->IntegerValue();
+        obj->spill();
+    } else {
+        THROW(TypeError, "value must be a non-negative number");
+    }
+}
+
+Handle<Value> ImageStore::GetCompressedBytes(Local<String> prop, const AccessorInfo &info)
+{
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(info.This());
+    return Number::New(obj->compressedBytes_);
+}
+
+Handle<Value> ImageStore::GetCachedBytes(Local<String> prop, const AccessorInfo &info)
+{
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(info.This());
+    return Number::New(obj->cachedBytes_);
+}
+
+Handle<Value> ImageStore::Add(const Arguments &args)
+{
+    HandleScope scope;
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(args.This());
+    if (args.Length() == 1 && Image::HasInstance(args[0])) {
+        size_t index = obj->pages_.size();
+        obj->pages_.resize(index + 1);
+        obj->setPage(index, Image::Pixels(args[0]->ToObject()));
+        obj->spill();
+        return scope.Close(Number::New(index));
+    } else {
+        return THROW(TypeError, "expected (image) signature");
+    }
+}
+
+Handle<Value> ImageStore::Get(const Arguments &args)
+{
+    HandleScope scope;
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(args.This());
+    if (args.Length() == 1 && args[0]->IsUint32()) {
+        size_t index = args[0]->Uint32Value();
+        if (index >= obj->pages_.size()) {
+            return THROW(RangeError, "index out of range");
+        }
+        Page &page = obj->pages_[index];
+        if (page.pix) {
+            obj->lru_.splice(obj->lru_.begin(), obj->lru_, page.used);
+        } else {
+            Pix *pix = obj->decompress(index);
+            if (!pix) {
+                return THROW(Error, "error while decompressing image");
+            }
+            obj->cache(index, pix);
+        }
+        // The image shares the cached pixels and copies them on write,
+        // so the page stays intact.
+        Handle<Value> image = Image::New(pixClone(page.pix));
+        obj->spill();
+        return scope.Close(image);
+    } else {
+        return THROW(TypeError, "expected (int) signature");
+    }
+}
+
+Handle<Value> ImageStore::Set(const Arguments &args)
+{
+    HandleScope scope;
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(args.This());
+    if (args.Length() == 2 && args[0]->IsUint32() && Image::HasInstance(args[1])) {
+        size_t index = args[0]->Uint32Value();
+        if (index >= obj->pages_.size()) {
+            return THROW(RangeError, "index out of range");
+        }
+        obj->clearPage(index);
+        obj->setPage(index, Image::Pixels(args[1]->ToObject()));
+        obj->spill();
+        return scope.Close(Undefined());
+    } else {
+        return THROW(TypeError, "expected (int, image) signature");
+    }
+}
+
+Handle<Value> ImageStore::Clear(const Arguments &args)
+{
+    HandleScope scope;
+    ImageStore* obj = ObjectWrap::Unwrap<ImageStore>(args.This());
+    for (size_t i = 0; i < obj->pages_.size(); ++i) {
+        obj->clearPage(i);
+    }
+    obj->pages_.clear();
+    return scope.Close(Undefined());
+}
+
+ImageStore::ImageStore(int64_t budget)
+    : budget_(budget), compressedBytes_(0), cachedBytes_(0)
+{
+}
+
+ImageStore::~ImageStore()
+{
+    for (size_t i = 0; i < pages_.size(); ++i) {
+        clearPage(i);
+    }
+}
+
+void ImageStore::setPage(size_t index, Pix *pix)
+{
+    Page &page = pages_[index];
+    page.width = pix->w;
+    page.height = pix->h;
+    page.depth = pix->d;
+    page.xres = pix->xres;
+    page.yres = pix->yres;
+    page.colormap = pix->colormap ? pixcmapCopy(pix->colormap) : NULL;
+    page.pix = NULL;
+    cache(index, pixClone(pix));
+}
+
+void ImageStore::clearPage(size_t index)
+{
+    Page &page = pages_[index];
+    if (page.pix) {
+        uncache(index);
+    }
+    if (!page.data.empty()) {
+        V8::AdjustAmountOfExternalAllocatedMemory(-static_cast<int64_t>(page.data.size()));
+        compressedBytes_ -= page.data.size();
+        std::vector<unsigned char>().swap(page.data);
+    }
+    pixcmapDestroy(&page.colormap);
+}
+
+void ImageStore::cache(size_t index, Pix *pix)
+{
+    Page &page = pages_[index];
+    holdPix(pix);
+    page.pix = pix;
+    page.used = lru_.insert(lru_.begin(), index);
+    cachedBytes_ += pixelBytes(pix);
+}
+
+void ImageStore::uncache(size_t index)
+{
+    Page &page = pages_[index];
+    cachedBytes_ -= pixelBytes(page.pix);
+    lru_.erase(page.used);
+    releasePix(&page.pix);
+}
+
+bool ImageStore::compress(size_t index)
+{
+    // Pages are immutable, so the data of a page that was spilled before
+    // is still valid.
+    Page &page = pages_[index];
+    if (!page.data.empty()) {
+        return true;
+    }
+    const unsigned char *raw = reinterpret_cast<unsigned char*>(pixGetData(page.pix));
+    size_t size = pixelBytes(page.pix);
+    if (page.depth == 1) {
+        packBits(raw, size, page.data);
+    } else {
+        // A smaller window and greedy matching compress a page about
+        // three times faster at the cost of a tenth in size.
+        LodePNGCompressSettings settings = lodepng_default_compress_settings;
+        settings.windowsize = 512;
+        settings.lazymatching = 0;
+        unsigned char *out = NULL;
+        size_t outSize = 0;
+        if (lodepng_zlib_compress(&out, &outSize, raw, size, &settings)) {
+            free(out);
+            return false;
+        }
+        page.data.assign(out, out + outSize);
+        free(out);
+    }
+    V8::AdjustAmountOfExternalAllocatedMemory(page.data.size());
+    compressedBytes_ += page.data.size();
+    return true;
+}
+
+Pix *ImageStore::decompress(size_t index)
+{
+    Page &page = pages_[index];
+    Pix *pix = pixCreateNoInit(page.width, page.height, page.depth);
+    if (!pix) {
+        return NULL;
+    }
+    pixSetResolution(pix, page.xres, page.yres);
+    if (page.colormap) {
+        pixSetColormap(pix, pixcmapCopy(page.colormap));
+    }
+    unsigned char *raw = reinterpret_cast<unsigned char*>(pixGetData(pix));
+    size_t size = pixelBytes(pix);
+    bool ok;
+    if (page.depth == 1) {
+        ok = unpackBits(page.data, raw, size);
+    } else {
+        unsigned char *out = NULL;
+        size_t outSize = 0;
+        ok = !lodepng_zlib_decompress(&out, &outSize, &page.data[0], page.data.size(),
+                                      &lodepng_default_decompress_settings)
+                && outSize == size;
+        if (ok) {
+            memcpy(raw, out, size);
+        }
+        free(out);
+    }
+    if (!ok) {
+        pixDestroy(&pix);
+    }
+    return pix;
+}
+
+void ImageStore::spill()
+{
+    // Compress the least recently used pages until the cache fits.
+    std::list<size_t>::iterator it = lru_.end();
+    while (cachedBytes_ > budget_ && it != lru_.begin()) {
+        size_t index = *--it;
+        if (compress(index)) {
+            it = lru_.erase(it);
+            pages_[index].used = lru_.end();
+            cachedBytes_ -= pixelBytes(pages_[index].pix);
+            releasePix(&pages_[index].pix);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef IMAGESTORE_H
+#define IMAGESTORE_H
+
+#include <v8.h>
+#include <node.h>
+#include <allheaders.h>
+#include <list>
+#include <vector>
+
+class ImageStore : public node::ObjectWrap
+{
+public:
+    static void Init(v8::Handle<v8::Object> target);
+
+private:
+    static v8::Handle<v8::Value> New(const v8::Arguments& args);
+
+    // Accessors.
+    static v8::Handle<v8::Value> GetLength(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetBudget(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static void SetBudget(v8::Local<v8::String> prop, v8::Local<v8::Value> value, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetCompressedBytes(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetCachedBytes(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+
+    // Methods.
+    static v8::Handle<v8::Value> Add(const v8::Arguments& args);
+    static v8::Handle<v8::Value> Get(const v8::Arguments& args);
+    static v8::Handle<v8::Value> Set(const v8::Arguments& args);
+    static v8::Handle<v8::Value> Clear(const v8::Arguments& args);
+
+    // A page keeps its pixels compressed once it has been spilled, and
+    // uncompressed while it is in the cache.
+    struct Page
+    {
+        int32_t width;
+        int32_t height;
+        int32_t depth;
+        int32_t xres;
+        int32_t yres;
+        PIXCMAP *colormap;
+        std::vector<unsigned char> data;
+        Pix *pix;
+        std::list<size_t>::iterator used;
+    };
+
+    ImageStore(int64_t budget);
+    ~ImageStore();
+
+    void setPage(size_t index, Pix *pix);
+    void clearPage(size_t index);
+    void cache(size_t index, Pix *pix);
+    void uncache(size_t index);
+    bool compress(size_t index);
+    Pix *decompress(size_t index);
+    void spill();
+
+    std::vector<Page> pages_;
+    std::list<size_t> lru_;
+    int64_t budget_;
+    int64_t compressedBytes_;
+    int64_t cachedBytes_;
+};
+
+#endif
@@ -0,0 +1,467 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "memory.h"
+#include "util.h"
+#include <uv.h>
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace v8;
+using namespace node;
+
+namespace {
+
+// Leptonica's memory store is a process-wide global that is not
+// thread-safe by itself, so every access goes through this lock.
+uv_mutex_t poolMutex;
+
+// Pixel data mapped from shared memory, by address, with the mapping it
+// belongs to. Guarded by poolMutex, as it is consulted on every free.
+struct SharedMapping
+{
+    void *base;
+    size_t length;
+};
+
+std::map<void*, SharedMapping> sharedData;
+bool sharedUsed = false;
+unsigned int sharedCounter = 0;
+
+// Names of the segments created by Share() that have not been mapped in
+// this process, with the Pix they were copied from. They are removed once
+// that Pix loses its last owner. Guarded by poolMutex.
+std::map<std::string, Pix*> sharedNames;
+
+// Layout of a shared segment; the pixels start at the next page boundary.
+struct SharedHeader
+{
+    char magic[4];
+    int32_t width;
+    int32_t height;
+    int32_t depth;
+    int32_t wpl;
+    int32_t xres;
+    int32_t yres;
+    int32_t colors;
+    RGBA_QUAD colormap[256];
+};
+
+const char SHARED_MAGIC[4] = {'d', 'v', 'p', 'x'};
+
+// Live Pix statistics, indexed by depth (1 to 32 bpp).
+struct PixStats
+{
+    int32_t count;
+    int64_t bytes;
+    int32_t depthCount[33];
+    int64_t depthBytes[33];
+    int32_t peakCount;
+    int64_t peakBytes;
+};
+
+// Owners and accounted size of every tracked Pix. Guarded by statsMutex.
+struct PixOwners
+{
+    int count;
+    int64_t bytes;
+    int depth;
+};
+
+uv_mutex_t statsMutex;
+PixStats stats;
+std::map<Pix*, PixOwners> owners;
+
+// The pool and the statistics are process-wide; whichever isolate loads
+// the binding first sets up their locks.
+uv_once_t mutexOnce = UV_ONCE_INIT;
+
+void initMutexes()
+{
+    uv_mutex_init(&poolMutex);
+    uv_mutex_init(&statsMutex);
+}
+
+int64_t pixBytes(Pix *pix)
+{
+    return static_cast<int64_t>(pix->h) * pix->wpl * sizeof(uint32_t);
+}
+
+void *poolAlloc(size_t nbytes)
+{
+    uv_mutex_lock(&poolMutex);
+    void *data;
+    if (pmsGetInfo(NULL, NULL, NULL, NULL) == 0) {
+        data = pmsCustomAlloc(nbytes);
+    } else {
+        // The store was removed while this call was waiting for the lock.
+        data = malloc(nbytes);
+    }
+    uv_mutex_unlock(&poolMutex);
+    return data;
+}
+
+size_t sharedDataOffset()
+{
+#ifndef _WIN32
+    size_t page = sysconf(_SC_PAGESIZE);
+    return (sizeof(SharedHeader) + page - 1) / page * page;
+#else
+    return 0;
+#endif
+}
+
+void poolFree(void *data)
+{
+    uv_mutex_lock(&poolMutex);
+    std::map<void*, SharedMapping>::iterator shared = sharedData.find(data);
+    if (shared != sharedData.end()) {
+#ifndef _WIN32
+        munmap(shared->second.base, shared->second.length);
+#endif
+        sharedData.erase(shared);
+        // Without mappings or a store, plain malloc() and free() will do.
+        if (sharedData.empty() && sharedUsed) {
+            sharedUsed = false;
+            if (pmsGetInfo(NULL, NULL, NULL, NULL) != 0) {
+                setPixMemoryManager(malloc, free);
+            }
+        }
+    } else if (pmsGetInfo(NULL, NULL, NULL, NULL) == 0) {
+        // Chunks from outside the store are freed by the store itself.
+        pmsCustomDealloc(data);
+    } else {
+        free(data);
+    }
+    uv_mutex_unlock(&poolMutex);
+}
+
+}
+
+void Memory::Init(Handle<Object> target)
+{
+    uv_once(&mutexOnce, initMutexes);
+    target->Set(String::NewSymbol("setMemoryPool"),
+                FunctionTemplate::New(SetMemoryPool)->GetFunction());
+    target->Set(String::NewSymbol("memoryPoolStats"),
+                FunctionTemplate::New(MemoryPoolStats)->GetFunction());
+    target->Set(String::NewSymbol("memoryStats"),
+                FunctionTemplate::New(MemoryStats)->GetFunction());
+}
+
+int64_t Memory::Track(Pix *pix)
+{
+    uv_mutex_lock(&statsMutex);
+    PixOwners &entry = owners[pix];
+    if (entry.count++ > 0) {
+        uv_mutex_unlock(&statsMutex);
+        return 0;
+    }
+    entry.bytes = pixBytes(pix);
+    entry.depth = pix->d;
+    stats.count++;
+    stats.bytes += entry.bytes;
+    if (entry.depth <= 32) {
+        stats.depthCount[entry.depth]++;
+        stats.depthBytes[entry.depth] += entry.bytes;
+    }
+    if (stats.count > stats.peakCount) {
+        stats.peakCount = stats.count;
+    }
+    if (stats.bytes > stats.peakBytes) {
+        stats.peakBytes = stats.bytes;
+    }
+    int64_t bytes = entry.bytes;
+    uv_mutex_unlock(&statsMutex);
+    return bytes;
+}
+
+int64_t Memory::Untrack(Pix *pix)
+{
+    uv_mutex_lock(&statsMutex);
+    std::map<Pix*, PixOwners>::iterator entry = owners.find(pix);
+    if (entry == owners.end() || --entry->second.count > 0) {
+        uv_mutex_unlock(&statsMutex);
+        return 0;
+    }
+    // Released with the size it was accounted with.
+    int64_t bytes = entry->second.bytes;
+    int depth = entry->second.depth;
+    owners.erase(entry);
+    stats.count--;
+    stats.bytes -= bytes;
+    if (depth <= 32) {
+        stats.depthCount[depth]--;
+        stats.depthBytes[depth] -= bytes;
+    }
+    uv_mutex_unlock(&statsMutex);
+#ifndef _WIN32
+    uv_mutex_lock(&poolMutex);
+    std::map<std::string, Pix*>::iterator name = sharedNames.begin();
+    while (name != sharedNames.end()) {
+        if (name->second == pix) {
+            shm_unlink(name->first.c_str());
+            sharedNames.erase(name++);
+        } else {
+            ++name;
+        }
+    }
+    uv_mutex_unlock(&poolMutex);
+#endif
+    return bytes;
+}
+
+std::string Memory::Share(Pix *pix, std::string &error)
+{
+#ifndef _WIN32
+    uv_mutex_lock(&poolMutex);
+    unsigned int counter = sharedCounter++;
+    uv_mutex_unlock(&poolMutex);
+    std::stringstream name;
+    name << "/dv-" << getpid() << "-" << counter;
+    size_t offset = sharedDataOffset();
+    size_t length = offset + pixBytes(pix);
+    int fd = shm_open(name.str().c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        error = "error while creating shared memory";
+        return std::string();
+    }
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, length) == 0) {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        shm_unlink(name.str().c_str());
+        error = "error while mapping shared memory";
+        return std::string();
+    }
+    SharedHeader *header = static_cast<SharedHeader*>(base);
+    memcpy(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC));
+    header->width = pix->w;
+    header->height = pix->h;
+    header->depth = pix->d;
+    header->wpl = pix->wpl;
+    header->xres = pix->xres;
+    header->yres = pix->yres;
+    header->colors = 0;
+    PIXCMAP *colormap = pixGetColormap(pix);
+    if (colormap) {
+        header->colors = pixcmapGetCount(colormap);
+        memcpy(header->colormap, colormap->array, header->colors * sizeof(RGBA_QUAD));
+    }
+    memcpy(static_cast<char*>(base) + offset, pix->data, pixBytes(pix));
+    munmap(base, length);
+    uv_mutex_lock(&poolMutex);
+    sharedNames[name.str()] = pix;
+    uv_mutex_unlock(&poolMutex);
+    return name.str();
+#else
+    error = "shared images are not supported on this platform";
+    return std::string();
+#endif
+}
+
+Pix *Memory::MapShared(const char *name, std::string &error)
+{
+#ifndef _WIN32
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        error = "no such shared image";
+        return NULL;
+    }
+    // The segment is handed over: once mapped, its name is no longer needed.
+    shm_unlink(name);
+    uv_mutex_lock(&poolMutex);
+    sharedNames.erase(name);
+    uv_mutex_unlock(&poolMutex);
+    struct stat info;
+    void *base = MAP_FAILED;
+    size_t offset = sharedDataOffset();
+    size_t length = 0;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= offset) {
+        length = info.st_size;
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        error = "error while mapping shared memory";
+        return NULL;
+    }
+    SharedHeader *header = static_cast<SharedHeader*>(base);
+    Pix *pix = NULL;
+    if (memcmp(header->magic, SHARED_MAGIC, sizeof(SHARED_MAGIC)) == 0
+            && header->colors >= 0 && header->colors <= 256) {
+        pix = pixCreateHeader(header->width, header->height, header->depth);
+    }
+    if (!pix || pix->wpl != static_cast<uint32_t>(header->wpl)
+            || offset + pixBytes(pix) > length) {
+        pixDestroy(&pix);
+        munmap(base, length);
+        error = "invalid shared image";
+        return NULL;
+    }
+    pixSetResolution(pix, header->xres, header->yres);
+    if (header->colors > 0) {
+        PIXCMAP *colormap = pixcmapCreate(header->depth);
+        for (int i = 0; i < header->colors; ++i) {
+            RGBA_QUAD *color = &header->colormap[i];
+            pixcmapAddColor(colormap, color->red, color->green, color->blue);
+        }
+        pixSetColormap(pix, colormap);
+    }
+    void *data = static_cast<char*>(base) + offset;
+    // From now on the data is released by poolFree(), which must stay the
+    // free function for as long as mappings may exist.
+    uv_mutex_lock(&poolMutex);
+    SharedMapping mapping = { base, length };
+    sharedData[data] = mapping;
+    if (!sharedUsed) {
+        sharedUsed = true;
+        setPixMemoryManager(poolAlloc, poolFree);
+    }
+    uv_mutex_unlock(&poolMutex);
+    pixSetData(pix, static_cast<l_uint32*>(data));
+    return pix;
+#else
+    error = "shared images are not supported on this platform";
+    return NULL;
+#endif
+}
+
+Handle<Value> Memory::SetMemoryPool(const Arguments &args)
+{
+    HandleScope scope;
+    bool enable = args.Length() == 3;
+    NUMA *numalloc = NULL;
+    if (enable) {
+        if (!args[0]->IsInt32() || !args[1]->IsInt32() || !args[2]->IsArray()) {
+            return THROW(TypeError, "expected (int, int, array) signature");
+        }
+        Local<Array> counts = Local<Array>::Cast(args[2]);
+        if (args[0]->Int32Value() < 0 || args[1]->Int32Value() <= 0
+                || counts->Length() == 0) {
+            return THROW(Error, "invalid memory pool sizes");
+        }
+        numalloc = numaCreate(counts->Length());
+        for (uint32_t i = 0; i < counts->Length(); ++i) {
+            numaAddNumber(numalloc, counts->Get(i)->Int32Value());
+        }
+    } else if (args.Length() != 0) {
+        return THROW(TypeError, "expected () or (int, int, array) signature");
+    }
+    uv_mutex_lock(&poolMutex);
+    l_int32 inUse;
+    if (pmsGetInfo(NULL, NULL, NULL, &inUse) == 0) {
+        // Chunks that are lent out would be orphaned by pmsDestroy().
+        if (inUse > 0) {
+            uv_mutex_unlock(&poolMutex);
+            numaDestroy(&numalloc);
+            return THROW(Error, "memory pool is in use");
+        }
+        // Mapped pixels must keep going through poolFree().
+        if (!sharedUsed) {
+            setPixMemoryManager(malloc, free);
+        }
+        pmsDestroy();
+    }
+    int error = 0;
+    if (enable) {
+        error = pmsCreate(args[0]->Int32Value(), args[1]->Int32Value(),
+                          numalloc, NULL);
+        if (error) {
+            pmsDestroy();
+        } else {
+            setPixMemoryManager(poolAlloc, poolFree);
+        }
+        numaDestroy(&numalloc);
+    }
+    uv_mutex_unlock(&poolMutex);
+    if (error) {
+        return THROW(Error, "error while creating memory pool");
+    }
+    return scope.Close(Undefined());
+}
+
+Handle<Value> Memory::MemoryPoolStats(const Arguments &args)
+{
+    HandleScope scope;
+    uv_mutex_lock(&poolMutex);
+    l_int32 nlevels, inUse;
+    size_t minSize, nbytes;
+    if (pmsGetInfo(&nlevels, &minSize, &nbytes, &inUse)) {
+        uv_mutex_unlock(&poolMutex);
+        return scope.Close(Null());
+    }
+    Local<Array> levels = Array::New(nlevels);
+    for (int i = 0; i < nlevels; ++i) {
+        size_t size;
+        l_int32 count, used, levelInUse, maxInUse, missed;
+        pmsGetLevelInfo(i, &size, &count, &used, &levelInUse, &maxInUse, &missed);
+        Local<Object> level = Object::New();
+        level->Set(String::NewSymbol("size"), Number::New(size));
+        level->Set(String::NewSymbol("count"), Int32::New(count));
+        level->Set(String::NewSymbol("used"), Int32::New(used));
+        level->Set(String::NewSymbol("inUse"), Int32::New(levelInUse));
+        level->Set(String::NewSymbol("maxInUse"), Int32::New(maxInUse));
+        level->Set(String::NewSymbol("missed"), Int32::New(missed));
+        levels->Set(i, level);
+    }
+    uv_mutex_unlock(&poolMutex);
+    Local<Object> stats = Object::New();
+    stats->Set(String::NewSymbol("size"), Number::New(nbytes));
+    stats->Set(String::NewSymbol("minSize"), Number::New(minSize));
+    stats->Set(String::NewSymbol("inUse"), Int32::New(inUse));
+    stats->Set(String::NewSymbol("levels"), levels);
+    return scope.Close(stats);
+}
+
+Handle<Value> Memory::MemoryStats(const Arguments &args)
+{
+    HandleScope scope;
+    uv_mutex_lock(&statsMutex);
+    PixStats current = stats;
+    uv_mutex_unlock(&statsMutex);
+    Local<Object> depths = Object::New();
+    for (int depth = 1; depth <= 32; ++depth) {
+        if (current.depthCount[depth] > 0) {
+            Local<Object> entry = Object::New();
+            entry->Set(String::NewSymbol("count"), Int32::New(current.depthCount[depth]));
+            entry->Set(String::NewSymbol("bytes"), Number::New(current.depthBytes[depth]));
+            depths->Set(depth, entry);
+        }
+    }
+    Local<Object> result = Object::New();
+    result->Set(String::NewSymbol("count"), Int32::New(current.count));
+    result->Set(String::NewSymbol("bytes"), Number::New(current.bytes));
+    result->Set(String::NewSymbol("peakCount"), Int32::New(current.peakCount));
+    result->Set(String::NewSymbol("peakBytes"), Number::New(current.peakBytes));
+    result->Set(String::NewSymbol("depths"), depths);
+    return scope.Close(result);
+}
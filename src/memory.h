@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <v8.h>
+#include <node.h>
+#include <allheaders.h>
+#include <string>
+
+class Memory
+{
+public:
+    static void Init(v8::Handle<v8::Object> target);
+
+    // Account the data of a Pix held by an Image or an ImageStore. The
+    // owners of a Pix are counted here, independently of its refcount
+    // (tesseract keeps clones of its own), so it is accounted from its
+    // first owner's Track() to its last owner's Untrack(). Both return
+    // the bytes that were added or released, to report to V8.
+    static int64_t Track(Pix *pix);
+    static int64_t Untrack(Pix *pix);
+
+    // Copies pix into a new POSIX shared memory segment and returns the
+    // segment's name, or an empty string and sets error. The segment is
+    // removed when pix is untracked by its last owner, unless it has been
+    // mapped by then.
+    static std::string Share(Pix *pix, std::string &error);
+
+    // Maps a segment created by Share() and removes its name. The pixels
+    // are mapped copy-on-write: changes stay private to this process.
+    static Pix *MapShared(const char *name, std::string &error);
+
+private:
+    static v8::Handle<v8::Value> SetMemoryPool(const v8::Arguments& args);
+    static v8::Handle<v8::Value> MemoryPoolStats(const v8::Arguments& args);
+    static v8::Handle<v8::Value> MemoryStats(const v8::Arguments& args);
+};
+
+#endif
@@ -20,15 +20,25 @@
  * SOFTWARE.
  */
 #include <node.h>
+#include "batch.h"
 #include "image.h"
+#include "imagestore.h"
+#include "memory.h"
+#include "ocrcache.h"
 #include "tesseract.h"
 #include "zxing.h"
 
 using namespace v8;
 
+// May run once for every isolate that loads the binding: all V8 state is
+// created per call and process-wide native state is set up only once.
 extern "C" void init(Handle<Object> target) 
 {
     Image::Init(target);
+    ImageStore::Init(target);
+    Memory::Init(target);
+    Batch::Init(target);
+    OcrCache::Init(target);
     Tesseract::Init(target);
     ZXing::Init(target);
 }
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ocrcache.h"
+#include "util.h"
+#include <uv.h>
+
+using namespace v8;
+using namespace node;
+
+namespace {
+
+// Capacity, in pages, of a cache created without one.
+const size_t DEFAULT_CAPACITY = 64;
+
+// Pages whose signatures differ in more bits than this are not worth
+// verifying; rescans of the same page differ in a few.
+const int MAX_DISTANCE = 32;
+
+typedef std::map<Isolate*, Persistent<FunctionTemplate> > TemplateMap;
+TemplateMap templates;
+uv_mutex_t templatesMutex;
+uv_once_t templatesOnce = UV_ONCE_INIT;
+
+void initTemplates()
+{
+    uv_mutex_init(&templatesMutex);
+}
+
+// Results are arrays of plain objects and strings; callers get copies of
+// their own, so changing one does not change the cache.
+Handle<Value> cloneValue(Handle<Value> value)
+{
+    if (value->IsArray()) {
+        Handle<Array> array = Handle<Array>::Cast(value);
+        Local<Array> clone = Array::New(array->Length());
+        for (uint32_t i = 0; i < array->Length(); ++i) {
+            clone->Set(i, cloneValue(array->Get(i)));
+        }
+        return clone;
+    } else if (value->IsObject()) {
+        Handle<Object> object = value->ToObject();
+        Local<Object> clone = Object::New();
+        Local<Array> names = object->GetOwnPropertyNames();
+        for (uint32_t i = 0; i < names->Length(); ++i) {
+            Local<Value> name = names->Get(i);
+            clone->Set(name, cloneValue(object->Get(name)));
+        }
+        return clone;
+    }
+    return value;
+}
+
+}
+
+void OcrCache::Init(Handle<Object> target)
+{
+    uv_once(&templatesOnce, initTemplates);
+    Local<FunctionTemplate> constructor_template = FunctionTemplate::New(New);
+    constructor_template->SetClassName(String::NewSymbol("OcrCache"));
+    constructor_template->InstanceTemplate()->SetInternalFieldCount(1);
+    Local<ObjectTemplate> proto = constructor_template->PrototypeTemplate();
+    proto->SetAccessor(String::NewSymbol("length"), GetLength);
+    proto->SetAccessor(String::NewSymbol("capacity"), GetCapacity);
+    proto->SetAccessor(String::NewSymbol("hits"), GetHits);
+    proto->SetAccessor(String::NewSymbol("misses"), GetMisses);
+    proto->Set(String::NewSymbol("clear"),
+               FunctionTemplate::New(Clear)->GetFunction());
+    uv_mutex_lock(&templatesMutex);
+    Persistent<FunctionTemplate> &stored = templates[Isolate::GetCurrent()];
+    if (!stored.IsEmpty()) {
+        stored.Dispose();
+    }
+    stored = Persistent<FunctionTemplate>::New(constructor_template);
+    uv_mutex_unlock(&templatesMutex);
+    target->Set(String::NewSymbol("OcrCache"), constructor_template->GetFunction());
+}
+
+bool OcrCache::HasInstance(Handle<Value> val)
+{
+    if (!val->IsObject()) {
+        return false;
+    }
+    uv_mutex_lock(&templatesMutex);
+    Handle<FunctionTemplate> constructor_template = templates[Isolate::GetCurrent()];
+    uv_mutex_unlock(&templatesMutex);
+    return constructor_template->HasInstance(val->ToObject());
+}
+
+Handle<Value> OcrCache::Lookup(const Fingerprint &fingerprint, const std::string &key,
+                               Page *&page)
+{
+    std::list<Page*>::iterator it = find(fingerprint);
+    page = NULL;
+    if (it != pages_.end()) {
+        page = *it;
+        std::map<std::string, Persistent<Value> >::iterator result = page->results.find(key);
+        if (result != page->results.end()) {
+            hits_++;
+            return cloneValue(result->second);
+        }
+    }
+    misses_++;
+    return Handle<Value>();
+}
+
+void OcrCache::Store(Page *page, const Fingerprint &fingerprint, const std::string &key,
+                     Handle<Value> result)
+{
+    if (!page) {
+        page = new Page();
+        page->fingerprint = fingerprint;
+        page->fingerprint.thumb = pixClone(fingerprint.thumb);
+        page->fingerprint.binary = pixClone(fingerprint.binary);
+        pages_.push_front(page);
+        if (pages_.size() > capacity_) {
+            destroyPage(pages_.back());
+            pages_.pop_back();
+        }
+    }
+    Persistent<Value> &stored = page->results[key];
+    if (!stored.IsEmpty()) {
+        stored.Dispose();
+    }
+    stored = Persistent<Value>::New(cloneValue(result));
+}
+
+Handle<Value> OcrCache::New(const Arguments &args)
+{
+    HandleScope scope;
+    size_t capacity = DEFAULT_CAPACITY;
+    if (args.Length() == 1 && args[0]->IsUint32() && args[0]->Uint32Value() > 0) {
+        capacity = args[0]->Uint32Value();
+    } else if (args.Length() != 0) {
+        return THROW(TypeError, "cannot convert argument list to "
+                     "() or "
+                     "(capacity: Uint32)");
+    }
+    OcrCache *obj = new OcrCache(capacity);
+    obj->Wrap(args.This());
+    return args.This();
+}
+
+Handle<Value> OcrCache::GetLength(Local<String> prop, const AccessorInfo &info)
+{
+    OcrCache *obj = ObjectWrap::Unwrap<OcrCache>(info.This());
+    return Number::New(obj->pages_.size());
+}
+
+Handle<Value> OcrCache::GetCapacity(Local<String> prop, const AccessorInfo &info)
+{
+    OcrCache *obj = ObjectWrap::Unwrap<OcrCache>(info.This());
+    return Number::New(obj->capacity_);
+}
+
+Handle<Value> OcrCache::GetHits(Local<String> prop, const AccessorInfo &info)
+{
+    OcrCache *obj = ObjectWrap::Unwrap<OcrCache>(info.This());
+    return Number::New(obj->hits_);
+}
+
+Handle<Value> OcrCache::GetMisses(Local<String> prop, const AccessorInfo &info)
+{
+    OcrCache *obj = ObjectWrap::Unwrap<OcrCache>(info.This());
+    return Number::New(obj->misses_);
+}
+
+Handle<Value> OcrCache::Clear(const Arguments &args)
+{
+    HandleScope scope;
+    OcrCache *obj = ObjectWrap::Unwrap<OcrCache>(args.This());
+    obj->clear();
+    obj->hits_ = 0;
+    obj->misses_ = 0;
+    return args.This();
+}
+
+OcrCache::OcrCache(size_t capacity)
+    : capacity_(capacity), hits_(0), misses_(0)
+{
+}
+
+OcrCache::~OcrCache()
+{
+    clear();
+}
+
+std::list<OcrCache::Page*>::iterator OcrCache::find(const Fingerprint &fingerprint)
+{
+    for (std::list<Page*>::iterator it = pages_.begin(); it != pages_.end(); ++it) {
+        if (fingerprintDistance((*it)->fingerprint, fingerprint) <= MAX_DISTANCE
+                && fingerprintMatch((*it)->fingerprint, fingerprint)) {
+            pages_.splice(pages_.begin(), pages_, it);
+            return pages_.begin();
+        }
+    }
+    return pages_.end();
+}
+
+void OcrCache::destroyPage(Page *page)
+{
+    for (std::map<std::string, Persistent<Value> >::iterator it = page->results.begin();
+         it != page->results.end(); ++it) {
+        it->second.Dispose();
+    }
+    fingerprintDestroy(page->fingerprint);
+    delete page;
+}
+
+void OcrCache::clear()
+{
+    for (std::list<Page*>::iterator it = pages_.begin(); it != pages_.end(); ++it) {
+        destroyPage(*it);
+    }
+    pages_.clear();
+}
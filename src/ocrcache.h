@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef OCRCACHE_H
+#define OCRCACHE_H
+
+#include <v8.h>
+#include <node.h>
+#include <list>
+#include <map>
+#include <string>
+#include "fingerprint.h"
+
+// Remembers recognition results of recent pages, so that they need not be
+// recognized again when a near-identical page comes along.
+class OcrCache : public node::ObjectWrap
+{
+public:
+    static void Init(v8::Handle<v8::Object> target);
+    static bool HasInstance(v8::Handle<v8::Value> val);
+
+    struct Page
+    {
+        Fingerprint fingerprint;
+        std::map<std::string, v8::Persistent<v8::Value> > results;
+    };
+
+    // Returns a copy of the result stored under key for a page matching the
+    // fingerprint, or an empty handle. Sets page to the matching page, or
+    // to NULL if there is none.
+    v8::Handle<v8::Value> Lookup(const Fingerprint &fingerprint, const std::string &key,
+                                 Page *&page);
+
+    // Stores a copy of result under key for the page found by the last
+    // lookup, or for a new page with the fingerprint if page is NULL.
+    void Store(Page *page, const Fingerprint &fingerprint, const std::string &key,
+               v8::Handle<v8::Value> result);
+
+private:
+    static v8::Handle<v8::Value> New(const v8::Arguments& args);
+
+    // Accessors.
+    static v8::Handle<v8::Value> GetLength(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetCapacity(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetHits(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetMisses(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+
+    // Methods.
+    static v8::Handle<v8::Value> Clear(const v8::Arguments& args);
+
+    OcrCache(size_t capacity);
+    ~OcrCache();
+
+    std::list<Page*>::iterator find(const Fingerprint &fingerprint);
+    void destroyPage(Page *page);
+    void clear();
+
+    // Most recently used first.
+    std::list<Page*> pages_;
+    size_t capacity_;
+    double hits_;
+    double misses_;
+};
+
+#endif
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "parallel.h"
+#include <uv.h>
+#include <algorithm>
+#include <deque>
+
+namespace {
+
+struct ParallelJob
+{
+    ParallelTask task;
+    void *data;
+    int count;
+    int next;
+    uv_mutex_t mutex;
+    // Posted by each pool thread that has finished its ticket.
+    uv_sem_t done;
+};
+
+void parallelWorker(void *arg)
+{
+    ParallelJob *job = static_cast<ParallelJob*>(arg);
+    for (;;) {
+        uv_mutex_lock(&job->mutex);
+        int index = job->next++;
+        uv_mutex_unlock(&job->mutex);
+        if (index >= job->count) {
+            break;
+        }
+        job->task(index, job->data);
+    }
+}
+
+uv_once_t workerCountOnce = UV_ONCE_INIT;
+int workerCount = 1;
+
+void initWorkerCount()
+{
+    uv_cpu_info_t *cpuInfos;
+    int cpuCount = 0;
+    uv_cpu_info(&cpuInfos, &cpuCount);
+    if (cpuCount > 0) {
+        uv_free_cpu_info(cpuInfos, cpuCount);
+        workerCount = cpuCount;
+    }
+}
+
+// The pool threads live for the rest of the process and wait on
+// poolTickets for jobs to help with. Each ticket in poolQueue lets one
+// thread join a job; tickets nobody took in time are withdrawn by the
+// caller, which leaves spare posts that the threads skip.
+uv_once_t poolOnce = UV_ONCE_INIT;
+uv_mutex_t poolMutex;
+uv_sem_t poolTickets;
+std::deque<ParallelJob*> poolQueue;
+int poolSize = 0;
+
+void poolThread(void *)
+{
+    for (;;) {
+        uv_sem_wait(&poolTickets);
+        ParallelJob *job = NULL;
+        uv_mutex_lock(&poolMutex);
+        if (!poolQueue.empty()) {
+            job = poolQueue.front();
+            poolQueue.pop_front();
+        }
+        uv_mutex_unlock(&poolMutex);
+        if (job) {
+            parallelWorker(job);
+            uv_sem_post(&job->done);
+        }
+    }
+}
+
+void startPool()
+{
+    uv_mutex_init(&poolMutex);
+    uv_sem_init(&poolTickets, 0);
+    // The calling thread of parallelFor makes up the last worker.
+    for (int i = 1; i < parallelThreadCount(); ++i) {
+        uv_thread_t thread;
+        if (uv_thread_create(&thread, poolThread, NULL) != 0) {
+            break;
+        }
+        ++poolSize;
+    }
+}
+
+}
+
+int parallelThreadCount()
+{
+    uv_once(&workerCountOnce, initWorkerCount);
+    return workerCount;
+}
+
+void parallelFor(int count, ParallelTask task, void *data)
+{
+    if (count <= 0) {
+        return;
+    }
+    if (parallelThreadCount() == 1 || count == 1) {
+        for (int index = 0; index < count; ++index) {
+            task(index, data);
+        }
+        return;
+    }
+    uv_once(&poolOnce, startPool);
+    ParallelJob job;
+    job.task = task;
+    job.data = data;
+    job.count = count;
+    job.next = 0;
+    uv_mutex_init(&job.mutex);
+    uv_sem_init(&job.done, 0);
+    int tickets = std::min(count - 1, poolSize);
+    uv_mutex_lock(&poolMutex);
+    poolQueue.insert(poolQueue.end(), tickets, &job);
+    uv_mutex_unlock(&poolMutex);
+    for (int i = 0; i < tickets; ++i) {
+        uv_sem_post(&poolTickets);
+    }
+    // The calling thread takes part in the work as well, and picks up the
+    // share of any ticket that is still queued, e.g. while the pool is busy
+    // with other jobs or when parallelFor is called from a task.
+    parallelWorker(&job);
+    uv_mutex_lock(&poolMutex);
+    size_t queued = poolQueue.size();
+    poolQueue.erase(std::remove(poolQueue.begin(), poolQueue.end(), &job), poolQueue.end());
+    int taken = tickets - static_cast<int>(queued - poolQueue.size());
+    uv_mutex_unlock(&poolMutex);
+    for (int i = 0; i < taken; ++i) {
+        uv_sem_wait(&job.done);
+    }
+    uv_sem_destroy(&job.done);
+    uv_mutex_destroy(&job.mutex);
+}
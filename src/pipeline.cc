@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "pipeline.h"
+#include "parallel.h"
+#include <algorithm>
+
+namespace {
+
+// Target size in bytes of the source rows processed by one band.
+const int BAND_BYTES = 1024 * 1024;
+
+// A fused run of pointwise operations: an optional conversion to gray
+// (from RGB or binary), a lookup table and an optional threshold.
+struct Pointwise
+{
+    int inDepth;
+    int outDepth;
+    // RGB to gray: 0 for weights, L_CHOOSE_MIN or L_CHOOSE_MAX.
+    bool toGray;
+    int grayType;
+    float rwt;
+    float gwt;
+    float bwt;
+    // Binary to gray: the values of 0 and 1 pixels.
+    bool expand;
+    l_uint8 val0;
+    l_uint8 val1;
+    // Binary to binary: invert all pixels.
+    bool flip;
+    l_uint8 lut[256];
+    bool identityLut;
+    bool thresholded;
+    int threshold;
+    bool invertBits;
+};
+
+struct Stage
+{
+    bool pointwise;
+    Pointwise pw;
+    PipelineOp::Type type;
+    int width;
+    int height;
+};
+
+void resetPointwise(Pointwise &pw, int depth)
+{
+    pw.inDepth = depth;
+    pw.outDepth = depth;
+    pw.toGray = false;
+    pw.expand = false;
+    pw.flip = false;
+    for (int i = 0; i < 256; ++i) {
+        pw.lut[i] = i;
+    }
+    pw.identityLut = true;
+    pw.thresholded = false;
+    pw.invertBits = false;
+}
+
+bool isIdentity(const Pointwise &pw)
+{
+    return !pw.toGray && !pw.expand && !pw.flip && pw.identityLut
+            && !pw.thresholded;
+}
+
+inline l_uint8 grayValue(const Pointwise &pw, l_uint32 word)
+{
+    // Same arithmetic as pixConvertRGBToGray() and
+    // pixConvertRGBToGrayMinMax().
+    l_int32 rval = (word >> L_RED_SHIFT) & 0xff;
+    l_int32 gval = (word >> L_GREEN_SHIFT) & 0xff;
+    l_int32 bval = (word >> L_BLUE_SHIFT) & 0xff;
+    if (pw.grayType == L_CHOOSE_MIN) {
+        return L_MIN(L_MIN(rval, gval), bval);
+    } else if (pw.grayType == L_CHOOSE_MAX) {
+        return L_MAX(L_MAX(rval, gval), bval);
+    }
+    return (l_int32)(pw.rwt * rval + pw.gwt * gval + pw.bwt * bval + 0.5);
+}
+
+// Applies a fused pointwise run to rows [sy, sy + rows) of pixs and writes
+// them to rows [dy, dy + rows) of pixd.
+void applyPointwise(const Pointwise &pw, Pix *pixs, int sy, Pix *pixd, int dy, int rows)
+{
+    int w = pixGetWidth(pixs);
+    int wpls = pixGetWpl(pixs);
+    int wpld = pixGetWpl(pixd);
+    for (int i = 0; i < rows; ++i) {
+        l_uint32 *lines = pixGetData(pixs) + (sy + i) * wpls;
+        l_uint32 *lined = pixGetData(pixd) + (dy + i) * wpld;
+        if (pw.inDepth == 1 && pw.outDepth == 1 && !pw.expand
+                && pw.identityLut && !pw.thresholded) {
+            for (int j = 0; j < wpls; ++j) {
+                lined[j] = pw.flip ? ~lines[j] : lines[j];
+            }
+            // Flipping also sets the pad bits past the last pixel.
+            if (w & 31) {
+                lined[wpls - 1] &= ~(l_uint32)0 << (32 - (w & 31));
+            }
+            continue;
+        }
+        l_uint32 dword = 0;
+        for (int j = 0; j < w; ++j) {
+            l_int32 val;
+            if (pw.inDepth == 32) {
+                val = grayValue(pw, lines[j]);
+            } else if (pw.inDepth == 8) {
+                val = GET_DATA_BYTE(lines, j);
+            } else {
+                val = (GET_DATA_BIT(lines, j) ^ pw.flip) ? pw.val1 : pw.val0;
+            }
+            val = pw.lut[val];
+            if (pw.outDepth == 8) {
+                SET_DATA_BYTE(lined, j, val);
+            } else {
+                dword |= (l_uint32)((val < pw.threshold) ^ pw.invertBits) << (31 - (j & 31));
+                if ((j & 31) == 31) {
+                    lined[j >> 5] = dword;
+                    dword = 0;
+                }
+            }
+        }
+        if (pw.outDepth == 1 && (w & 31) != 0) {
+            lined[w >> 5] = dword;
+        }
+    }
+}
+
+Pix *applyNeighborhood(const Stage &stage, Pix *pixs)
+{
+    switch (stage.type) {
+    case PipelineOp::Convolve:
+        return pixBlockconv(pixs, stage.width, stage.height);
+    case PipelineOp::Erode:
+        if (pixGetDepth(pixs) == 1) {
+            return pixErodeBrick(NULL, pixs, stage.width, stage.height);
+        }
+        return pixErodeGray(pixs, stage.width, stage.height);
+    case PipelineOp::Dilate:
+        if (pixGetDepth(pixs) == 1) {
+            return pixDilateBrick(NULL, pixs, stage.width, stage.height);
+        }
+        return pixDilateGray(pixs, stage.width, stage.height);
+    default:
+        return NULL;
+    }
+}
+
+// Turns the operations into stages, folding consecutive pointwise
+// operations into one Pointwise run.
+bool compileStages(int depth, const std::vector<PipelineOp> &ops,
+                   std::vector<Stage> &stages, int &outDepth, const char **error)
+{
+    Stage current;
+    current.pointwise = true;
+    resetPointwise(current.pw, depth);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        const PipelineOp &op = ops[i];
+        Pointwise &pw = current.pw;
+        // A run can only convert to gray once at its start; after a
+        // threshold only inversions can be folded into it.
+        bool startRun = pw.thresholded
+                && op.type != PipelineOp::Invert && op.type != PipelineOp::Threshold;
+        if (startRun) {
+            stages.push_back(current);
+            resetPointwise(current.pw, depth);
+        }
+        switch (op.type) {
+        case PipelineOp::ToGray:
+            if (depth == 32) {
+                pw.toGray = true;
+                pw.grayType = op.grayType;
+                pw.rwt = op.hasWeights ? op.weights[0] : 0.0;
+                pw.gwt = op.hasWeights ? op.weights[1] : 0.0;
+                pw.bwt = op.hasWeights ? op.weights[2] : 0.0;
+                if (pw.rwt == 0.0 && pw.gwt == 0.0 && pw.bwt == 0.0) {
+                    pw.rwt = L_RED_WEIGHT;
+                    pw.gwt = L_GREEN_WEIGHT;
+                    pw.bwt = L_BLUE_WEIGHT;
+                }
+                l_float32 sum = pw.rwt + pw.gwt + pw.bwt;
+                if (L_ABS(sum - 1.0) > 0.0001) {
+                    pw.rwt = pw.rwt / sum;
+                    pw.gwt = pw.gwt / sum;
+                    pw.bwt = pw.bwt / sum;
+                }
+                pw.outDepth = depth = 8;
+            } else if (depth == 1) {
+                if (op.hasWeights || op.grayType != 0) {
+                    *error = "expected RGB image for toGray";
+                    return false;
+                }
+                pw.expand = true;
+                pw.val0 = pw.flip ? 0 : 255;
+                pw.val1 = pw.flip ? 255 : 0;
+                pw.flip = false;
+                pw.outDepth = depth = 8;
+            }
+            break;
+        case PipelineOp::ApplyCurve:
+            if (depth != 8) {
+                *error = "expected grayscale image for applyCurve";
+                return false;
+            }
+            for (int j = 0; j < 256; ++j) {
+                pw.lut[j] = op.curve[pw.lut[j]] & 0xff;
+            }
+            pw.identityLut = false;
+            break;
+        case PipelineOp::Invert:
+            if (depth == 8) {
+                for (int j = 0; j < 256; ++j) {
+                    pw.lut[j] = 255 - pw.lut[j];
+                }
+                pw.identityLut = false;
+            } else if (depth == 1 && pw.thresholded) {
+                pw.invertBits = !pw.invertBits;
+            } else if (depth == 1) {
+                pw.flip = !pw.flip;
+            } else {
+                *error = "expected binary or grayscale image for invert";
+                return false;
+            }
+            break;
+        case PipelineOp::Threshold:
+            if (depth == 32) {
+                pw.toGray = true;
+                pw.grayType = 0;
+                pw.rwt = L_RED_WEIGHT;
+                pw.gwt = L_GREEN_WEIGHT;
+                pw.bwt = L_BLUE_WEIGHT;
+                depth = 8;
+            }
+            if (depth == 8) {
+                pw.thresholded = true;
+                pw.threshold = op.value;
+                pw.outDepth = depth = 1;
+            }
+            break;
+        case PipelineOp::Convolve:
+        case PipelineOp::Erode:
+        case PipelineOp::Dilate:
+            if (depth == 32) {
+                *error = "expected binary or grayscale image";
+                return false;
+            }
+            if (op.type == PipelineOp::Convolve && depth == 1) {
+                // Convolve works on 0/255 gray values, like Image.convolve.
+                pw.expand = true;
+                pw.val0 = pw.flip ? 255 : 0;
+                pw.val1 = pw.flip ? 0 : 255;
+                pw.flip = false;
+                pw.outDepth = depth = 8;
+            }
+            if (!isIdentity(pw)) {
+                stages.push_back(current);
+            }
+            Stage stage;
+            stage.pointwise = false;
+            stage.type = op.type;
+            stage.width = op.width;
+            stage.height = op.height;
+            stages.push_back(stage);
+            resetPointwise(pw, depth);
+            break;
+        }
+    }
+    if (!isIdentity(current.pw)) {
+        stages.push_back(current);
+    }
+    outDepth = depth;
+    return true;
+}
+
+int stageMargin(const Stage &stage)
+{
+    // Rows of context a neighborhood stage needs above and below a band.
+    // Even gray morphology sizes are rounded up by leptonica.
+    return stage.pointwise ? 0 : stage.height + 1;
+}
+
+struct PipelineBands
+{
+    Pix *pixs;
+    Pix *pixd;
+    const std::vector<Stage> *stages;
+    int margin;
+    int bandHeight;
+    int bandCount;
+    bool failed;
+};
+
+void runBand(int index, void *data)
+{
+    PipelineBands *bands = static_cast<PipelineBands*>(data);
+    int w = pixGetWidth(bands->pixs);
+    int h = pixGetHeight(bands->pixs);
+    int y0 = index * bands->bandHeight;
+    int y1 = index == bands->bandCount - 1 ? h : y0 + bands->bandHeight;
+    int inY0 = std::max(0, y0 - bands->margin);
+    int inY1 = std::min(h, y1 + bands->margin);
+    // NULL while the band still is rows [inY0, inY1) of the source.
+    Pix *pix = NULL;
+    for (size_t i = 0; i < bands->stages->size(); ++i) {
+        const Stage &stage = (*bands->stages)[i];
+        Pix *pixt;
+        if (stage.pointwise) {
+            pixt = pixCreateNoInit(w, inY1 - inY0, stage.pw.outDepth);
+            if (pixt) {
+                applyPointwise(stage.pw, pix ? pix : bands->pixs,
+                               pix ? 0 : inY0, pixt, 0, inY1 - inY0);
+            }
+        } else {
+            if (!pix) {
+                BOX *box = boxCreate(0, inY0, w, inY1 - inY0);
+                pix = pixClipRectangle(bands->pixs, box, NULL);
+                boxDestroy(&box);
+            }
+            pixt = pix ? applyNeighborhood(stage, pix) : NULL;
+        }
+        pixDestroy(&pix);
+        if (!pixt) {
+            bands->failed = true;
+            return;
+        }
+        pix = pixt;
+    }
+    pixRasterop(bands->pixd, 0, y0, w, y1 - y0, PIX_SRC, pix, 0, y0 - inY0);
+    pixDestroy(&pix);
+}
+
+}
+
+Pix *runPipeline(Pix *pixs, const std::vector<PipelineOp> &ops, const char **error)
+{
+    int depth = pixGetDepth(pixs);
+    if ((depth != 1 && depth != 8 && depth != 32) || pixGetColormap(pixs)) {
+        *error = "expected binary, grayscale or RGB image without colormap";
+        return NULL;
+    }
+    std::vector<Stage> stages;
+    int outDepth;
+    if (!compileStages(depth, ops, stages, outDepth, error)) {
+        return NULL;
+    }
+    if (stages.empty()) {
+        return pixClone(pixs);
+    }
+    int w = pixGetWidth(pixs);
+    int h = pixGetHeight(pixs);
+    Pix *pixd = pixCreateNoInit(w, h, outDepth);
+    if (!pixd) {
+        *error = "error while allocating image";
+        return NULL;
+    }
+    pixCopyResolution(pixd, pixs);
+    if (stages.size() == 1 && stages[0].pointwise) {
+        applyPointwise(stages[0].pw, pixs, 0, pixd, 0, h);
+        return pixd;
+    }
+    PipelineBands bands;
+    bands.pixs = pixs;
+    bands.pixd = pixd;
+    bands.stages = &stages;
+    bands.margin = 0;
+    for (size_t i = 0; i < stages.size(); ++i) {
+        bands.margin += stageMargin(stages[i]);
+    }
+    // Bands are sized to stay in cache but have to be large compared to
+    // their margins, which are computed twice.
+    bands.bandHeight = std::max(BAND_BYTES / (pixGetWpl(pixs) * 4), 16 * bands.margin);
+    bands.bandHeight = std::max(bands.bandHeight, 16);
+    bands.bandCount = std::max(h / bands.bandHeight, 1);
+    bands.failed = false;
+    parallelFor(bands.bandCount, runBand, &bands);
+    if (bands.failed) {
+        pixDestroy(&pixd);
+        *error = "error while running pipeline";
+        return NULL;
+    }
+    return pixd;
+}
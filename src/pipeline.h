@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <allheaders.h>
+#include <vector>
+
+// An operation recorded by Image.pipeline().
+struct PipelineOp
+{
+    enum Type
+    {
+        ToGray,
+        ApplyCurve,
+        Invert,
+        Threshold,
+        Convolve,
+        Erode,
+        Dilate
+    };
+
+    Type type;
+    // ToGray: 0 for luminance (or the given weights), L_CHOOSE_MIN or
+    // L_CHOOSE_MAX.
+    int grayType;
+    bool hasWeights;
+    float weights[3];
+    // ApplyCurve: the mapping of each gray value.
+    int curve[256];
+    // Threshold: the threshold; Convolve, Erode, Dilate: the kernel size.
+    int value;
+    int width;
+    int height;
+};
+
+// Runs the operations on pixs with the same results as calling the
+// corresponding Image methods one after another. Consecutive pointwise
+// operations are fused into one pass and neighborhood operations are
+// run over bands of rows, so only the final image is allocated at full
+// size. Returns NULL and sets error if the operations do not apply.
+Pix *runPipeline(Pix *pixs, const std::vector<PipelineOp> &ops, const char **error);
+
+#endif
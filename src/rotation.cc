@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "rotation.h"
+#include "parallel.h"
+#include <algorithm>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Target size in bytes of the destination rows computed by one band.
+const int BAND_BYTES = 256 * 1024;
+
+// Same as in rotate.c: smaller angles return the image unrotated.
+const float VERY_SMALL_ANGLE = 0.001;
+
+// The fixed point setup of rotateAMGrayLow() and rotateAMColorLow():
+// coordinates are in 1/16 pixels relative to the center.
+struct Rotation
+{
+    Pix *pixs;
+    Pix *pixd;
+    int xcen;
+    int ycen;
+    int wm2;
+    int hm2;
+    float sina;
+    float cosa;
+    int bandHeight;
+};
+
+// Source position of destination pixel (j, i) and whether it lies inside,
+// in the same float arithmetic as leptonica.
+inline bool sourcePosition(const Rotation &rot, int j, int i,
+                           int &xp, int &yp, int &xf, int &yf)
+{
+    int xdif = rot.xcen - j;
+    int ydif = rot.ycen - i;
+    int xpm = (l_int32)(-xdif * rot.cosa - ydif * rot.sina);
+    int ypm = (l_int32)(-ydif * rot.cosa + xdif * rot.sina);
+    xp = rot.xcen + (xpm >> 4);
+    yp = rot.ycen + (ypm >> 4);
+    xf = xpm & 0x0f;
+    yf = ypm & 0x0f;
+    return xp >= 0 && yp >= 0 && xp <= rot.wm2 && yp <= rot.hm2;
+}
+
+#ifdef __SSE2__
+// Source positions of the destination pixels j to j + 3 of row i, with
+// xp and yp clamped to 0 for pixels outside (marked in outside).
+inline void sourcePositions4(const Rotation &rot, int j, int i, __m128i &xp,
+                             __m128i &yp, __m128i &xf, __m128i &yf, __m128i &outside)
+{
+    const __m128i xcen = _mm_set1_epi32(rot.xcen);
+    const __m128i ycen = _mm_set1_epi32(rot.ycen);
+    const __m128i fraction = _mm_set1_epi32(0x0f);
+    const __m128 cosa = _mm_set1_ps(rot.cosa);
+    const __m128 sina = _mm_set1_ps(rot.sina);
+    __m128i xdif = _mm_sub_epi32(xcen, _mm_setr_epi32(j, j + 1, j + 2, j + 3));
+    __m128 xdiff = _mm_cvtepi32_ps(xdif);
+    __m128 negxdif = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_setzero_si128(), xdif));
+    __m128 ydif = _mm_set1_ps(static_cast<float>(rot.ycen - i));
+    __m128 negydif = _mm_set1_ps(static_cast<float>(i - rot.ycen));
+    __m128i xpm = _mm_cvttps_epi32(_mm_sub_ps(_mm_mul_ps(negxdif, cosa),
+                                              _mm_mul_ps(ydif, sina)));
+    __m128i ypm = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(negydif, cosa),
+                                              _mm_mul_ps(xdiff, sina)));
+    xp = _mm_add_epi32(xcen, _mm_srai_epi32(xpm, 4));
+    yp = _mm_add_epi32(ycen, _mm_srai_epi32(ypm, 4));
+    xf = _mm_and_si128(xpm, fraction);
+    yf = _mm_and_si128(ypm, fraction);
+    const __m128i zero = _mm_setzero_si128();
+    outside = _mm_or_si128(_mm_or_si128(_mm_cmpgt_epi32(zero, xp),
+                                        _mm_cmpgt_epi32(zero, yp)),
+                           _mm_or_si128(_mm_cmpgt_epi32(xp, _mm_set1_epi32(rot.wm2)),
+                                        _mm_cmpgt_epi32(yp, _mm_set1_epi32(rot.hm2))));
+    xp = _mm_andnot_si128(outside, xp);
+    yp = _mm_andnot_si128(outside, yp);
+}
+
+// The four area weights of the lanes, as 16 bit values.
+inline void weights4(__m128i xf, __m128i yf, __m128i &w00, __m128i &w10,
+                     __m128i &w01, __m128i &w11)
+{
+    const __m128i sixteen = _mm_set1_epi32(16);
+    __m128i xr = _mm_sub_epi32(sixteen, xf);
+    __m128i yr = _mm_sub_epi32(sixteen, yf);
+    // The products are at most 256, so 16 bit multiplies suffice.
+    w00 = _mm_mullo_epi16(xr, yr);
+    w10 = _mm_mullo_epi16(xf, yr);
+    w01 = _mm_mullo_epi16(xr, yf);
+    w11 = _mm_mullo_epi16(xf, yf);
+}
+#endif
+
+void rotateGrayRow(const Rotation &rot, int i)
+{
+    Pix *pixs = rot.pixs;
+    int w = pixGetWidth(pixs);
+    int wpls = pixGetWpl(pixs);
+    const l_uint32 *datas = pixGetData(pixs);
+    l_uint32 *lined = pixGetData(rot.pixd) + i * pixGetWpl(rot.pixd);
+    int j = 0;
+#ifdef __SSE2__
+    const __m128i fill = _mm_set1_epi16(255);
+    const __m128i round = _mm_set1_epi16(128);
+    // The vector loops read the row below as well, even for outside pixels.
+    for (; rot.hm2 >= 0 && j + 8 <= w; j += 8) {
+        __m128i xp[2], yp[2], xf[2], yf[2], outside[2];
+        sourcePositions4(rot, j, i, xp[0], yp[0], xf[0], yf[0], outside[0]);
+        sourcePositions4(rot, j + 4, i, xp[1], yp[1], xf[1], yf[1], outside[1]);
+        l_int32 xs[8], ys[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(xs), xp[0]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(xs + 4), xp[1]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ys), yp[0]);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ys + 4), yp[1]);
+        // Pixels outside read the top left pixel and are replaced below.
+        l_int16 v[4][8];
+        for (int k = 0; k < 8; ++k) {
+            const l_uint32 *lines = datas + ys[k] * wpls;
+            v[0][k] = GET_DATA_BYTE(lines, xs[k]);
+            v[1][k] = GET_DATA_BYTE(lines, xs[k] + 1);
+            v[2][k] = GET_DATA_BYTE(lines + wpls, xs[k]);
+            v[3][k] = GET_DATA_BYTE(lines + wpls, xs[k] + 1);
+        }
+        __m128i w00[2], w10[2], w01[2], w11[2];
+        weights4(xf[0], yf[0], w00[0], w10[0], w01[0], w11[0]);
+        weights4(xf[1], yf[1], w00[1], w10[1], w01[1], w11[1]);
+        // Each weighted sum is at most 256 * 255 + 128, which fits in
+        // unsigned 16 bit lanes.
+        __m128i sum = _mm_add_epi16(
+            _mm_add_epi16(
+                _mm_mullo_epi16(_mm_packs_epi32(w00[0], w00[1]),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(v[0]))),
+                _mm_mullo_epi16(_mm_packs_epi32(w10[0], w10[1]),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(v[1])))),
+            _mm_add_epi16(
+                _mm_mullo_epi16(_mm_packs_epi32(w01[0], w01[1]),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(v[2]))),
+                _mm_mullo_epi16(_mm_packs_epi32(w11[0], w11[1]),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i*>(v[3])))));
+        __m128i val = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+        __m128i mask = _mm_packs_epi32(outside[0], outside[1]);
+        val = _mm_or_si128(_mm_and_si128(mask, fill), _mm_andnot_si128(mask, val));
+        l_int16 out[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), val);
+        for (int k = 0; k < 8; ++k) {
+            SET_DATA_BYTE(lined, j + k, out[k]);
+        }
+    }
+#endif
+    for (; j < w; ++j) {
+        int xp, yp, xf, yf;
+        if (!sourcePosition(rot, j, i, xp, yp, xf, yf)) {
+            SET_DATA_BYTE(lined, j, 255);
+            continue;
+        }
+        const l_uint32 *lines = datas + yp * wpls;
+        l_int32 v00 = (16 - xf) * (16 - yf) * GET_DATA_BYTE(lines, xp);
+        l_int32 v10 = xf * (16 - yf) * GET_DATA_BYTE(lines, xp + 1);
+        l_int32 v01 = (16 - xf) * yf * GET_DATA_BYTE(lines + wpls, xp);
+        l_int32 v11 = xf * yf * GET_DATA_BYTE(lines + wpls, xp + 1);
+        SET_DATA_BYTE(lined, j, (v00 + v01 + v10 + v11 + 128) / 256);
+    }
+}
+
+void rotateColorRow(const Rotation &rot, int i)
+{
+    Pix *pixs = rot.pixs;
+    int w = pixGetWidth(pixs);
+    int wpls = pixGetWpl(pixs);
+    const l_uint32 *datas = pixGetData(pixs);
+    l_uint32 *lined = pixGetData(rot.pixd) + i * pixGetWpl(rot.pixd);
+    const l_uint32 fill = 0xffffff00;
+    int j = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i round = _mm_set1_epi16(128);
+    // composeRGBPixel() leaves the alpha byte clear.
+    const __m128i rgbMask = _mm_set1_epi32(static_cast<int>(0xffffff00));
+    for (; rot.hm2 >= 0 && j + 4 <= w; j += 4) {
+        __m128i xp, yp, xf, yf, outside;
+        sourcePositions4(rot, j, i, xp, yp, xf, yf, outside);
+        l_int32 xs[4], ys[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(xs), xp);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ys), yp);
+        __m128i w00, w10, w01, w11;
+        weights4(xf, yf, w00, w10, w01, w11);
+        l_int32 ws[4][4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ws[0]), w00);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ws[1]), w10);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ws[2]), w01);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(ws[3]), w11);
+        __m128i halves[2];
+        // Two pixels at a time, with the four channels of each widened to
+        // 16 bits; the sums fit as in rotateGrayRow().
+        for (int k = 0; k < 4; k += 2) {
+            const l_uint32 *line0 = datas + ys[k] * wpls + xs[k];
+            const l_uint32 *line1 = datas + ys[k + 1] * wpls + xs[k + 1];
+            __m128i sum = round;
+            for (int n = 0; n < 4; ++n) {
+                int offset = (n & 1) + (n >> 1) * wpls;
+                __m128i words = _mm_unpacklo_epi8(
+                    _mm_setr_epi32(line0[offset], line1[offset], 0, 0), zero);
+                __m128i weight = _mm_setr_epi16(ws[n][k], ws[n][k], ws[n][k], ws[n][k],
+                                                ws[n][k + 1], ws[n][k + 1],
+                                                ws[n][k + 1], ws[n][k + 1]);
+                sum = _mm_add_epi16(sum, _mm_mullo_epi16(words, weight));
+            }
+            halves[k / 2] = _mm_srli_epi16(sum, 8);
+        }
+        __m128i val = _mm_and_si128(_mm_packus_epi16(halves[0], halves[1]), rgbMask);
+        val = _mm_or_si128(_mm_and_si128(outside, _mm_set1_epi32(static_cast<int>(fill))),
+                           _mm_andnot_si128(outside, val));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lined + j), val);
+    }
+#endif
+    for (; j < w; ++j) {
+        int xp, yp, xf, yf;
+        if (!sourcePosition(rot, j, i, xp, yp, xf, yf)) {
+            lined[j] = fill;
+            continue;
+        }
+        const l_uint32 *lines = datas + yp * wpls;
+        l_uint32 word00 = lines[xp];
+        l_uint32 word10 = lines[xp + 1];
+        l_uint32 word01 = lines[wpls + xp];
+        l_uint32 word11 = lines[wpls + xp + 1];
+        l_int32 vals[3];
+        const int shifts[3] = { L_RED_SHIFT, L_GREEN_SHIFT, L_BLUE_SHIFT };
+        for (int c = 0; c < 3; ++c) {
+            vals[c] = ((16 - xf) * (16 - yf) * ((word00 >> shifts[c]) & 0xff) +
+                       xf * (16 - yf) * ((word10 >> shifts[c]) & 0xff) +
+                       (16 - xf) * yf * ((word01 >> shifts[c]) & 0xff) +
+                       xf * yf * ((word11 >> shifts[c]) & 0xff) + 128) / 256;
+        }
+        composeRGBPixel(vals[0], vals[1], vals[2], lined + j);
+    }
+}
+
+void rotateBand(int index, void *data)
+{
+    Rotation *rot = static_cast<Rotation*>(data);
+    int h = pixGetHeight(rot->pixs);
+    int y1 = std::min(h, (index + 1) * rot->bandHeight);
+    for (int i = index * rot->bandHeight; i < y1; ++i) {
+        if (pixGetDepth(rot->pixs) == 8) {
+            rotateGrayRow(*rot, i);
+        } else {
+            rotateColorRow(*rot, i);
+        }
+    }
+}
+
+}
+
+Pix *rotateAreaMap(Pix *pixs, float angle)
+{
+    if (!pixs || pixGetColormap(pixs)
+            || (pixGetDepth(pixs) != 8 && pixGetDepth(pixs) != 32)) {
+        return NULL;
+    }
+    if (L_ABS(angle) < VERY_SMALL_ANGLE) {
+        return pixClone(pixs);
+    }
+    // Like pixRotate(), rotate within an image that holds all of pixs.
+    pixs = pixEmbedForRotation(pixs, angle, L_BRING_IN_WHITE,
+                               pixGetWidth(pixs), pixGetHeight(pixs));
+    if (!pixs) {
+        return NULL;
+    }
+    Pix *pixd = pixCreateTemplate(pixs);
+    if (!pixd) {
+        pixDestroy(&pixs);
+        return NULL;
+    }
+    Rotation rot;
+    rot.pixs = pixs;
+    rot.pixd = pixd;
+    rot.xcen = pixGetWidth(pixs) / 2;
+    rot.ycen = pixGetHeight(pixs) / 2;
+    rot.wm2 = pixGetWidth(pixs) - 2;
+    rot.hm2 = pixGetHeight(pixs) - 2;
+    rot.sina = 16. * sin(angle);
+    rot.cosa = 16. * cos(angle);
+    rot.bandHeight = std::max(BAND_BYTES / (pixGetWpl(pixs) * 4), 16);
+    int bandCount = (pixGetHeight(pixs) + rot.bandHeight - 1) / rot.bandHeight;
+    parallelFor(bandCount, rotateBand, &rot);
+    pixDestroy(&pixs);
+    return pixd;
+}
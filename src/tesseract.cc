@@ -21,14 +21,34 @@
  */
 #include "tesseract.h"
 #include "image.h"
+#include "ocrcache.h"
 #include "util.h"
+#include <node_buffer.h>
+#include <cstdio>
 #include <sstream>
+#include <vector>
 #include <strngs.h>
 #include <resultiterator.h>
 
 using namespace v8;
 using namespace node;
 
+static bool toEngineMode(const char *name, tesseract::OcrEngineMode &mode)
+{
+    if (strcmp("tesseract_only", name) == 0) {
+        mode = tesseract::OEM_TESSERACT_ONLY;
+    } else if (strcmp("cube_only", name) == 0) {
+        mode = tesseract::OEM_CUBE_ONLY;
+    } else if (strcmp("tesseract_cube_combined", name) == 0) {
+        mode = tesseract::OEM_TESSERACT_CUBE_COMBINED;
+    } else if (strcmp("default", name) == 0) {
+        mode = tesseract::OEM_DEFAULT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 void Tesseract::Init(Handle<Object> target)
 {
     Local<FunctionTemplate> constructor_template = FunctionTemplate::New(New);
@@ -38,6 +58,9 @@ void Tesseract::Init(Handle<Object> target)
     proto->SetAccessor(String::NewSymbol("image"), GetImage, SetImage);
     proto->SetAccessor(String::NewSymbol("rectangle"), GetRectangle, SetRectangle);
     proto->SetAccessor(String::NewSymbol("pageSegMode"), GetPageSegMode, SetPageSegMode);
+    proto->SetAccessor(String::NewSymbol("engineMode"), GetEngineMode);
+    proto->SetAccessor(String::NewSymbol("threads"), GetThreads, SetThreads);
+    proto->SetAccessor(String::NewSymbol("cache"), GetCache, SetCache);
     proto->Set(String::NewSymbol("SetVariable"),
                FunctionTemplate::New(SetVariable)->GetFunction());
     proto->Set(String::NewSymbol("MeanTextConf"),
@@ -46,6 +69,10 @@ void Tesseract::Init(Handle<Object> target)
                FunctionTemplate::New(Clear)->GetFunction());
     proto->Set(String::NewSymbol("clearAdaptiveClassifier"),
                FunctionTemplate::New(ClearAdaptiveClassifier)->GetFunction());
+    proto->Set(String::NewSymbol("saveAdaptation"),
+               FunctionTemplate::New(SaveAdaptation)->GetFunction());
+    proto->Set(String::NewSymbol("loadAdaptation"),
+               FunctionTemplate::New(LoadAdaptation)->GetFunction());
     proto->Set(String::NewSymbol("thresholdImage"),
                FunctionTemplate::New(ThresholdImage)->GetFunction());
     proto->Set(String::NewSymbol("findRegions"),
@@ -60,8 +87,7 @@ void Tesseract::Init(Handle<Object> target)
                FunctionTemplate::New(FindSymbols)->GetFunction());
     proto->Set(String::NewSymbol("findText"),
                FunctionTemplate::New(FindText)->GetFunction());
-    target->Set(String::NewSymbol("Tesseract"),
-                Persistent<Function>::New(constructor_template->GetFunction()));
+    target->Set(String::NewSymbol("Tesseract"), constructor_template->GetFunction());
 }
 
 Handle<Value> Tesseract::New(const Arguments &args)
@@ -70,6 +96,8 @@ Handle<Value> Tesseract::New(const Arguments &args)
     Local<String> datapath;
     Local<String> lang;
     Local<Object> image;
+    tesseract::OcrEngineMode mode = tesseract::OEM_DEFAULT;
+    Local<Value> engineMode;
     if (args.Length() == 1 && args[0]->IsString()) {
         datapath = args[0]->ToString();
         lang = String::New("eng");
@@ -81,14 +109,35 @@ Handle<Value> Tesseract::New(const Arguments &args)
         datapath = args[0]->ToString();
         lang = args[1]->ToString();
         image = args[2]->ToObject();
+    } else if (args.Length() == 3 && args[0]->IsString() && args[1]->IsString()
+               && args[2]->IsString()) {
+        datapath = args[0]->ToString();
+        lang = args[1]->ToString();
+        engineMode = args[2];
+    } else if (args.Length() == 4 && args[0]->IsString() && args[1]->IsString()
+               && Image::HasInstance(args[2]) && args[3]->IsString()) {
+        datapath = args[0]->ToString();
+        lang = args[1]->ToString();
+        image = args[2]->ToObject();
+        engineMode = args[3];
     } else {
         return THROW(TypeError, "cannot convert argument list to "
                      "(datapath: String) or "
                      "(datapath: String, language: String) or "
-                     "(datapath: String, language: String, image: Image)");
+                     "(datapath: String, language: String, image: Image) or "
+                     "(datapath: String, language: String, engineMode: String) or "
+                     "(datapath: String, language: String, image: Image, engineMode: String)");
+    }
+    if (!engineMode.IsEmpty() && !toEngineMode(*String::AsciiValue(engineMode), mode)) {
+        return THROW(TypeError, "engineMode must be one of: "
+                     "tesseract_only, cube_only, tesseract_cube_combined, default");
+    }
+    Tesseract* obj = new Tesseract();
+    if (obj->api_.Init(*String::AsciiValue(datapath), *String::AsciiValue(lang), mode) != 0) {
+        delete obj;
+        return THROW(Error, "error while initializing tesseract");
     }
-    Tesseract* obj = new Tesseract(*String::AsciiValue(datapath),
-                                   *String::AsciiValue(lang));
+    obj->api_.SetVariable("save_blob_choices", "T");
     if (!image.IsEmpty()) {
         obj->image_ = Persistent<Object>::New(image->ToObject());
         obj->api_.SetImage(Image::Pixels(obj->image_));
@@ -113,6 +162,7 @@ void Tesseract::SetImage(Local<String> prop, Local<Value> value, const AccessorI
         }
         obj->image_ = Persistent<Object>::New(value->ToObject());
         obj->api_.SetImage(Image::Pixels(obj->image_));
+        obj->updateFingerprint();
     } else {
         THROW(TypeError, "value must be of type Image");
     }
@@ -213,6 +263,71 @@ void Tesseract::SetPageSegMode(Local<String> prop, Local<Value> value, const Acc
     }
 }
 
+Handle<Value> Tesseract::GetEngineMode(Local<String> prop, const AccessorInfo &info)
+{
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(info.This());
+    switch (obj->api_.oem()) {
+    case tesseract::OEM_TESSERACT_ONLY:
+        return String::New("tesseract_only");
+    case tesseract::OEM_CUBE_ONLY:
+        return String::New("cube_only");
+    case tesseract::OEM_TESSERACT_CUBE_COMBINED:
+        return String::New("tesseract_cube_combined");
+    case tesseract::OEM_DEFAULT:
+        return String::New("default");
+    default:
+        return THROW(Error, "cannot convert internal OEM to String");
+    }
+}
+
+Handle<Value> Tesseract::GetThreads(Local<String> prop, const AccessorInfo &info)
+{
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(info.This());
+    int threads = 1;
+    obj->api_.GetIntVariable("tessedit_pass1_threads", &threads);
+    return Int32::New(threads);
+}
+
+void Tesseract::SetThreads(Local<String> prop, Local<Value> value, const AccessorInfo &info)
+{
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(info.This());
+    if (value->IsInt32() && value->Int32Value() >= 1) {
+        // Recorded like SetVariable, as the thread count can change results.
+        std::stringstream threads;
+        threads << value->Int32Value();
+        obj->variables_["tessedit_pass1_threads"] = threads.str();
+        obj->api_.SetVariable("tessedit_pass1_threads", threads.str().c_str());
+    } else {
+        THROW(TypeError, "value must be a positive integer");
+    }
+}
+
+Handle<Value> Tesseract::GetCache(Local<String> prop, const AccessorInfo &info)
+{
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(info.This());
+    if (obj->cache_.IsEmpty()) {
+        return Null();
+    }
+    return obj->cache_;
+}
+
+void Tesseract::SetCache(Local<String> prop, Local<Value> value, const AccessorInfo &info)
+{
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(info.This());
+    if (OcrCache::HasInstance(value) || value->IsNull()) {
+        if (!obj->cache_.IsEmpty()) {
+            obj->cache_.Dispose();
+            obj->cache_.Clear();
+        }
+        if (!value->IsNull()) {
+            obj->cache_ = Persistent<Object>::New(value->ToObject());
+        }
+        obj->updateFingerprint();
+    } else {
+        THROW(TypeError, "value must be of type OcrCache or null");
+    }
+}
+
 Handle<Value> Tesseract::SetVariable(const Arguments &args)
 {
     HandleScope scope;
@@ -220,6 +335,7 @@ Handle<Value> Tesseract::SetVariable(const Arguments &args)
     if (args.Length() == 2 && args[0]->IsString() && args[1]->IsString()) {
         String::AsciiValue key(args[0]);
         String::AsciiValue val(args[1]);
+        obj->variables_[*key] = *val;
         return Number::New(obj->api_.SetVariable(*key, *val));
     }
     return THROW(TypeError, "cannot convert argument list to (key, value)");
@@ -248,6 +364,57 @@ Handle<Value> Tesseract::ClearAdaptiveClassifier(const Arguments &args)
     return args.This();
 }
 
+// Tesseract only reads and writes the adapted templates through a FILE, so
+// they pass through a temporary file on their way to and from the Buffer.
+Handle<Value> Tesseract::SaveAdaptation(const Arguments &args)
+{
+    HandleScope scope;
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(args.This());
+    FILE *file = tmpfile();
+    if (!file) {
+        return THROW(Error, "cannot create temporary file");
+    }
+    std::vector<char> data;
+    long size = obj->api_.SaveAdaptiveClassifier(file) ? ftell(file) : 0;
+    if (size > 0) {
+        data.resize(size);
+        rewind(file);
+        if (fread(&data[0], 1, data.size(), file) != data.size()) {
+            data.clear();
+        }
+    }
+    fclose(file);
+    if (data.empty()) {
+        return THROW(Error, "Internal tesseract error");
+    }
+    return scope.Close(Buffer::New(&data[0], data.size())->handle_);
+}
+
+Handle<Value> Tesseract::LoadAdaptation(const Arguments &args)
+{
+    HandleScope scope;
+    Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(args.This());
+    if (args.Length() == 1 && Buffer::HasInstance(args[0])) {
+        Local<Object> buffer = args[0]->ToObject();
+        FILE *file = tmpfile();
+        if (!file) {
+            return THROW(Error, "cannot create temporary file");
+        }
+        size_t length = Buffer::Length(buffer);
+        bool loaded = fwrite(Buffer::Data(buffer), 1, length, file) == length;
+        if (loaded) {
+            rewind(file);
+            loaded = obj->api_.LoadAdaptiveClassifier(file);
+        }
+        fclose(file);
+        if (!loaded) {
+            return THROW(Error, "buffer holds no adaptation for this language");
+        }
+        return args.This();
+    }
+    return THROW(TypeError, "cannot convert argument list to (buffer: Buffer)");
+}
+
 Handle<Value> Tesseract::ThresholdImage(const Arguments &args)
 {
     HandleScope scope;
@@ -300,6 +467,16 @@ Handle<Value> Tesseract::FindText(const Arguments &args)
     HandleScope scope;
     Tesseract* obj = ObjectWrap::Unwrap<Tesseract>(args.This());
     if (args.Length() >= 1 && args[0]->IsString()) {
+        OcrCache *cache = obj->cache();
+        std::string key;
+        OcrCache::Page *page = NULL;
+        if (cache) {
+            key = obj->cacheKey("text", args);
+            Handle<Value> cached = cache->Lookup(obj->fingerprint_, key, page);
+            if (!cached.IsEmpty()) {
+                return scope.Close(cached);
+            }
+        }
         String::AsciiValue mode(args[0]);
         const char *text = NULL;
         if (strcmp("plain", *mode) == 0) {
@@ -314,6 +491,9 @@ Handle<Value> Tesseract::FindText(const Arguments &args)
         if (text) {
             Local<String> textString = String::New(text);
             // Don't "delete[] text;": it breaks Tesseract 3.02 (documentation bug?)
+            if (cache) {
+                cache->Store(page, obj->fingerprint_, key, textString);
+            }
             return scope.Close(textString);
         }
         return THROW(Error, "Internal tesseract error");
@@ -325,20 +505,73 @@ Handle<Value> Tesseract::FindText(const Arguments &args)
                  "(\"box\", pageNumber: Int32)");
 }
 
-Tesseract::Tesseract(const char *datapath, const char *language)
+Tesseract::Tesseract()
 {
-    int res = api_.Init(datapath, language, tesseract::OEM_DEFAULT);
-    api_.SetVariable("save_blob_choices", "T");
-    assert(res == 0);
+    fingerprint_.thumb = NULL;
+    fingerprint_.binary = NULL;
 }
 
 Tesseract::~Tesseract()
 {
     api_.End();
+    if (!cache_.IsEmpty()) {
+        cache_.Dispose();
+    }
+    fingerprintDestroy(fingerprint_);
+}
+
+void Tesseract::updateFingerprint()
+{
+    fingerprintDestroy(fingerprint_);
+    if (!cache_.IsEmpty() && !image_.IsEmpty()) {
+        fingerprintCreate(Image::Pixels(image_), fingerprint_);
+    }
+}
+
+std::string Tesseract::cacheKey(const char *method, const Arguments &args)
+{
+    std::stringstream key;
+    key << api_.GetInitLanguagesAsString() << "\n" << api_.oem() << "\n"
+        << api_.GetPageSegMode() << "\n";
+    if (!rectangle_.IsEmpty()) {
+        key << rectangle_->Get(String::NewSymbol("x"))->Int32Value() << ","
+            << rectangle_->Get(String::NewSymbol("y"))->Int32Value() << ","
+            << rectangle_->Get(String::NewSymbol("width"))->Int32Value() << ","
+            << rectangle_->Get(String::NewSymbol("height"))->Int32Value();
+    }
+    key << "\n";
+    for (std::map<std::string, std::string>::const_iterator it = variables_.begin();
+            it != variables_.end(); ++it) {
+        key << it->first << "=" << it->second << "\n";
+    }
+    key << method;
+    for (int i = 0; i < args.Length(); ++i) {
+        key << "\n" << *String::Utf8Value(args[i]);
+    }
+    return key.str();
+}
+
+OcrCache *Tesseract::cache()
+{
+    if (cache_.IsEmpty() || !fingerprint_.thumb) {
+        return NULL;
+    }
+    return ObjectWrap::Unwrap<OcrCache>(cache_);
 }
 
 Handle<Value> Tesseract::TransformResult(tesseract::PageIteratorLevel level, const Arguments &args)
 {
+    static const char *methods[] = { "regions", "paragraphs", "textLines", "words", "symbols" };
+    OcrCache *cache = this->cache();
+    std::string key;
+    OcrCache::Page *page = NULL;
+    if (cache) {
+        key = cacheKey(methods[level], args);
+        Handle<Value> cached = cache->Lookup(fingerprint_, key, page);
+        if (!cached.IsEmpty()) {
+            return cached;
+        }
+    }
     bool recognize = true;
     if (args.Length() >= 1 && args[0]->IsBoolean()) {
         recognize = args[0]->BooleanValue();
@@ -408,5 +641,8 @@ Handle<Value> Tesseract::TransformResult(tesseract::PageIteratorLevel level, con
         results->Set(index++, result);
     } while (it->Next(level));
     delete it;
+    if (cache) {
+        cache->Store(page, fingerprint_, key, results);
+    }
     return results;
 }
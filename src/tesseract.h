@@ -25,6 +25,11 @@
 #include <v8.h>
 #include <node.h>
 #include <baseapi.h>
+#include <map>
+#include <string>
+#include "fingerprint.h"
+
+class OcrCache;
 
 class Tesseract : public node::ObjectWrap
 {
@@ -41,12 +46,19 @@ private:
     static void SetRectangle(v8::Local<v8::String> prop, v8::Local<v8::Value> value, const v8::AccessorInfo &info);
     static v8::Handle<v8::Value> GetPageSegMode(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
     static void SetPageSegMode(v8::Local<v8::String> prop, v8::Local<v8::Value> value, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetEngineMode(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetThreads(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static void SetThreads(v8::Local<v8::String> prop, v8::Local<v8::Value> value, const v8::AccessorInfo &info);
+    static v8::Handle<v8::Value> GetCache(v8::Local<v8::String> prop, const v8::AccessorInfo &info);
+    static void SetCache(v8::Local<v8::String> prop, v8::Local<v8::Value> value, const v8::AccessorInfo &info);
 
     // Methods.
     static v8::Handle<v8::Value> SetVariable(const v8::Arguments& args);
     static v8::Handle<v8::Value> MeanTextConf(const v8::Arguments& args);
     static v8::Handle<v8::Value> Clear(const v8::Arguments& args);
     static v8::Handle<v8::Value> ClearAdaptiveClassifier(const v8::Arguments& args);
+    static v8::Handle<v8::Value> SaveAdaptation(const v8::Arguments& args);
+    static v8::Handle<v8::Value> LoadAdaptation(const v8::Arguments& args);
     static v8::Handle<v8::Value> ThresholdImage(const v8::Arguments& args);
     static v8::Handle<v8::Value> FindRegions(const v8::Arguments& args);
     static v8::Handle<v8::Value> FindParagraphs(const v8::Arguments &args);
@@ -55,14 +67,23 @@ private:
     static v8::Handle<v8::Value> FindSymbols(const v8::Arguments& args);
     static v8::Handle<v8::Value> FindText(const v8::Arguments& args);
 
-    Tesseract(const char *datapath, const char *language);
+    Tesseract();
     ~Tesseract();
 
     v8::Handle<v8::Value> TransformResult(tesseract::PageIteratorLevel level, const v8::Arguments &args);
 
+    // Cached results are valid for the same image and settings only.
+    void updateFingerprint();
+    std::string cacheKey(const char *method, const v8::Arguments &args);
+    OcrCache *cache();
+
     tesseract::TessBaseAPI api_;
     v8::Persistent<v8::Object> image_;
     v8::Persistent<v8::Object> rectangle_;
+    v8::Persistent<v8::Object> cache_;
+    Fingerprint fingerprint_;
+    // The last value set for each variable, for the cache key.
+    std::map<std::string, std::string> variables_;
 };
 
 #endif
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "tiling.h"
+#include "parallel.h"
+#include <uv.h>
+#include <algorithm>
+
+namespace {
+
+// Smallest width and height of a tile, without its margins.
+const int TILE_SIZE = 256;
+
+struct TileJob
+{
+    Pix *pixs;
+    Pix *pixd;
+    PIXTILING *pt;
+    int nx;
+    int marginX;
+    int marginY;
+    TileFilter filter;
+    void *data;
+    bool failed;
+    uv_mutex_t mutex;
+};
+
+// Returns the tile's own area; the rightmost and bottom tiles take up
+// the remainder of the image.
+void tileCore(PIXTILING *pt, Pix *pixs, int i, int j, int *x, int *y, int *w, int *h)
+{
+    int nx, ny, tw, th;
+    pixTilingGetCount(pt, &nx, &ny);
+    pixTilingGetSize(pt, &tw, &th);
+    *x = j * tw;
+    *y = i * th;
+    *w = j == nx - 1 ? pixGetWidth(pixs) - *x : tw;
+    *h = i == ny - 1 ? pixGetHeight(pixs) - *y : th;
+}
+
+void runTile(int index, void *data)
+{
+    TileJob *job = static_cast<TileJob*>(data);
+    int i = index / job->nx;
+    int j = index % job->nx;
+    int x, y, w, h;
+    tileCore(job->pt, job->pixs, i, j, &x, &y, &w, &h);
+    // Unlike pixTilingGetTile(), the margins are clipped at the image
+    // edges instead of mirrored, so the filter sees what it would see
+    // on the whole image.
+    int left = std::max(0, x - job->marginX);
+    int top = std::max(0, y - job->marginY);
+    int right = std::min(pixGetWidth(job->pixs), x + w + job->marginX);
+    int bottom = std::min(pixGetHeight(job->pixs), y + h + job->marginY);
+    BOX *box = boxCreate(left, top, right - left, bottom - top);
+    Pix *tile = pixClipRectangle(job->pixs, box, NULL);
+    boxDestroy(&box);
+    Pix *result = tile ? job->filter(tile, job->data) : NULL;
+    pixDestroy(&tile);
+    if (!result) {
+        uv_mutex_lock(&job->mutex);
+        job->failed = true;
+        uv_mutex_unlock(&job->mutex);
+        return;
+    }
+    // Neighboring tiles can share words of the destination, which takes
+    // the depth of the first result.
+    uv_mutex_lock(&job->mutex);
+    if (!job->pixd) {
+        job->pixd = pixCreateNoInit(pixGetWidth(job->pixs), pixGetHeight(job->pixs),
+                                    pixGetDepth(result));
+        pixCopyResolution(job->pixd, job->pixs);
+    }
+    if (!job->pixd || pixGetDepth(result) != pixGetDepth(job->pixd)) {
+        job->failed = true;
+        uv_mutex_unlock(&job->mutex);
+        pixDestroy(&result);
+        return;
+    }
+    pixRasterop(job->pixd, x, y, w, h, PIX_SRC, result, x - left, y - top);
+    uv_mutex_unlock(&job->mutex);
+    pixDestroy(&result);
+}
+
+struct OtsuJob
+{
+    Pix *pixs;
+    PIXTILING *pt;
+    int nx;
+    float scorefract;
+    Pix *pixth;
+    Pix *pixd;
+    uv_mutex_t mutex;
+};
+
+void otsuTileThreshold(int index, void *data)
+{
+    OtsuJob *job = static_cast<OtsuJob*>(data);
+    int i = index / job->nx;
+    int j = index % job->nx;
+    Pix *pixt = pixTilingGetTile(job->pt, i, j);
+    l_int32 thresh;
+    pixSplitDistributionFgBg(pixt, job->scorefract, 1, &thresh, NULL, NULL, 0);
+    // Each tile owns one byte of the threshold array; bytes can be
+    // written concurrently.
+    SET_DATA_BYTE(pixGetData(job->pixth) + i * pixGetWpl(job->pixth), j, thresh);
+    pixDestroy(&pixt);
+}
+
+void otsuTileApply(int index, void *data)
+{
+    OtsuJob *job = static_cast<OtsuJob*>(data);
+    int i = index / job->nx;
+    int j = index % job->nx;
+    Pix *pixt = pixTilingGetTile(job->pt, i, j);
+    l_uint32 val;
+    pixGetPixel(job->pixth, j, i, &val);
+    Pix *pixb = pixThresholdToBinary(pixt, val);
+    uv_mutex_lock(&job->mutex);
+    pixTilingPaintTile(job->pixd, i, j, pixb, job->pt);
+    uv_mutex_unlock(&job->mutex);
+    pixDestroy(&pixt);
+    pixDestroy(&pixb);
+}
+
+struct ScaleJob
+{
+    l_uint32 *datad;
+    int wd;
+    int hd;
+    int wpld;
+    l_uint32 *datas;
+    int ws;
+    int hs;
+    int wpls;
+    int d;
+    bool areaMap;
+    int strips;
+    bool failed;
+    uv_mutex_t mutex;
+};
+
+void scaleStrip(int index, void *data)
+{
+    ScaleJob *job = static_cast<ScaleJob*>(data);
+    int ystart = index * job->hd / job->strips;
+    int yend = (index + 1) * job->hd / job->strips;
+    l_int32 ret;
+    if (job->areaMap) {
+        ret = job->d == 8
+            ? scaleGrayAreaMapRowsLow(job->datad, job->wd, job->hd, job->wpld,
+                                      job->datas, job->ws, job->hs, job->wpls, ystart, yend)
+            : scaleColorAreaMapRowsLow(job->datad, job->wd, job->hd, job->wpld,
+                                       job->datas, job->ws, job->hs, job->wpls, ystart, yend);
+    } else {
+        ret = job->d == 8
+            ? scaleGrayLIRowsLow(job->datad, job->wd, job->hd, job->wpld,
+                                 job->datas, job->ws, job->hs, job->wpls, ystart, yend)
+            : scaleColorLIRowsLow(job->datad, job->wd, job->hd, job->wpld,
+                                  job->datas, job->ws, job->hs, job->wpls, ystart, yend);
+    }
+    if (ret != 0) {
+        uv_mutex_lock(&job->mutex);
+        job->failed = true;
+        uv_mutex_unlock(&job->mutex);
+    }
+}
+
+Pix *unsharpMaskTile(Pix *tile, void *data)
+{
+    const int *halfwidth = static_cast<const int*>(data);
+    return pixUnsharpMasking(tile, *halfwidth, *halfwidth == 1 ? 0.2 : 0.4);
+}
+
+// The area map or interpolated scaling of pixScaleGeneral(), with the
+// dest rows split into strips on the worker threads.
+Pix *scaleStrips(Pix *pixs, float scalex, float scaley)
+{
+    ScaleJob job;
+    job.ws = pixGetWidth(pixs);
+    job.hs = pixGetHeight(pixs);
+    job.wd = (l_int32)(scalex * (l_float32)job.ws + 0.5);
+    job.hd = (l_int32)(scaley * (l_float32)job.hs + 0.5);
+    if (job.wd < 1 || job.hd < 1) {
+        return NULL;
+    }
+    Pix *pixt = pixCreate(job.wd, job.hd, pixGetDepth(pixs));
+    if (!pixt) {
+        return NULL;
+    }
+    pixCopyResolution(pixt, pixs);
+    pixScaleResolution(pixt, scalex, scaley);
+    job.datad = pixGetData(pixt);
+    job.wpld = pixGetWpl(pixt);
+    job.datas = pixGetData(pixs);
+    job.wpls = pixGetWpl(pixs);
+    job.d = pixGetDepth(pixs);
+    job.areaMap = L_MAX(scalex, scaley) < 0.7;
+    // Strips are whole dest rows, so they never share words.
+    job.strips = std::min(job.hd, 4 * parallelThreadCount());
+    job.failed = false;
+    uv_mutex_init(&job.mutex);
+    parallelFor(job.strips, scaleStrip, &job);
+    uv_mutex_destroy(&job.mutex);
+    if (job.failed) {
+        pixDestroy(&pixt);
+        return NULL;
+    }
+    return pixt;
+}
+
+}
+
+Pix *tileFilter(Pix *pixs, int marginX, int marginY, TileFilter filter, void *data)
+{
+    int tileSize = std::max(TILE_SIZE, 4 * std::max(marginX, marginY));
+    PIXTILING *pt = pixTilingCreate(pixs, 0, 0, tileSize, tileSize, 0, 0);
+    if (!pt) {
+        return NULL;
+    }
+    int nx, ny;
+    pixTilingGetCount(pt, &nx, &ny);
+    if (nx * ny == 1 || parallelThreadCount() == 1) {
+        pixTilingDestroy(&pt);
+        return filter(pixs, data);
+    }
+    TileJob job;
+    job.pixs = pixs;
+    job.pixd = NULL;
+    job.pt = pt;
+    job.nx = nx;
+    job.marginX = marginX;
+    job.marginY = marginY;
+    job.filter = filter;
+    job.data = data;
+    job.failed = false;
+    uv_mutex_init(&job.mutex);
+    parallelFor(nx * ny, runTile, &job);
+    uv_mutex_destroy(&job.mutex);
+    pixTilingDestroy(&pt);
+    if (job.failed) {
+        pixDestroy(&job.pixd);
+    }
+    return job.pixd;
+}
+
+int tileOtsuAdaptiveThreshold(Pix *pixs, int sx, int sy, int smoothx, int smoothy,
+                              float scorefract, Pix **ppixth, Pix **ppixd)
+{
+    // Mirrors pixOtsuAdaptiveThreshold(); only the tile loops differ.
+    if (!pixs || pixGetDepth(pixs) != 8 || sx < 16 || sy < 16) {
+        return pixOtsuAdaptiveThreshold(pixs, sx, sy, smoothx, smoothy,
+                                        scorefract, ppixth, ppixd);
+    }
+    int w = pixGetWidth(pixs);
+    int h = pixGetHeight(pixs);
+    int nx = L_MAX(1, w / sx);
+    int ny = L_MAX(1, h / sy);
+    smoothx = L_MIN(smoothx, (nx - 1) / 2);
+    smoothy = L_MIN(smoothy, (ny - 1) / 2);
+    OtsuJob job;
+    job.pixs = pixs;
+    job.pt = pixTilingCreate(pixs, nx, ny, 0, 0, 0, 0);
+    job.nx = nx;
+    job.scorefract = scorefract;
+    job.pixth = pixCreate(nx, ny, 8);
+    job.pixd = NULL;
+    uv_mutex_init(&job.mutex);
+    parallelFor(nx * ny, otsuTileThreshold, &job);
+    Pix *pixthresh = job.pixth;
+    if (smoothx > 0 || smoothy > 0) {
+        job.pixth = pixBlockconv(pixthresh, smoothx, smoothy);
+    } else {
+        job.pixth = pixClone(pixthresh);
+    }
+    pixDestroy(&pixthresh);
+    if (ppixd) {
+        job.pixd = pixCreate(w, h, 1);
+        parallelFor(nx * ny, otsuTileApply, &job);
+        *ppixd = job.pixd;
+    }
+    uv_mutex_destroy(&job.mutex);
+    if (ppixth) {
+        *ppixth = job.pixth;
+    } else {
+        pixDestroy(&job.pixth);
+    }
+    pixTilingDestroy(&job.pt);
+    return 0;
+}
+
+Pix *stripScale(Pix *pixs, float scalex, float scaley)
+{
+    // Mirrors pixScaleGeneral() with the sharpening of pixScale(); only
+    // the row loops and the sharpening are split up.
+    if (!pixs) {
+        return NULL;
+    }
+    int d = pixGetDepth(pixs);
+    float maxscale = L_MAX(scalex, scaley);
+    bool areaMap2 = scalex == scaley && (scalex == 0.5 || scalex == 0.25
+                                         || scalex == 0.125 || scalex == 0.0625);
+    if ((d != 8 && d != 32) || pixGetColormap(pixs) || scalex <= 0.0 || scaley <= 0.0
+            || maxscale >= 1.0) {
+        return pixScale(pixs, scalex, scaley);
+    }
+    Pix *pixt;
+    if (areaMap2) {
+        // pixScaleAreaMap() takes the fast 2x reduction for these.
+        pixt = pixScaleAreaMap(pixs, scalex, scaley);
+    } else {
+        pixt = scaleStrips(pixs, scalex, scaley);
+    }
+    if (!pixt) {
+        return NULL;
+    }
+    if (maxscale <= 0.2) {
+        return pixt;
+    }
+    // The unsharp mask reaches halfwidth pixels in each direction, but
+    // the separable halfwidth 2 filter also leaves the low pass of the
+    // outer two rows at zero, so the margins are doubled.
+    int halfwidth = maxscale < 0.7 ? 1 : 2;
+    Pix *pixd = tileFilter(pixt, 2 * halfwidth, 2 * halfwidth, unsharpMaskTile, &halfwidth);
+    pixDestroy(&pixt);
+    return pixd;
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2012 Christoph Schulz
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef TILING_H
+#define TILING_H
+
+#include <allheaders.h>
+
+// Computes the result for one tile, which includes its margins. The
+// result must have the size of the tile.
+typedef Pix *(*TileFilter)(Pix *tile, void *data);
+
+// Splits pixs into tiles that overlap by marginX and marginY pixels, runs
+// filter on them on the worker threads and paints the results into a new
+// image. If the margins cover the reach of the filter, the result is
+// identical to running it on the whole image. Returns NULL if a tile
+// failed.
+Pix *tileFilter(Pix *pixs, int marginX, int marginY, TileFilter filter, void *data);
+
+// Same as pixOtsuAdaptiveThreshold(), with the tiles processed on the
+// worker threads.
+int tileOtsuAdaptiveThreshold(Pix *pixs, int sx, int sy, int smoothx, int smoothy,
+                              float scorefract, Pix **ppixth, Pix **ppixd);
+
+// Same as pixScale(), with the rows of gray and RGB reductions scaled
+// and sharpened on the worker threads. Returns NULL on error.
+Pix *stripScale(Pix *pixs, float scalex, float scaley);
+
+#endif
@@ -156,8 +156,7 @@ void ZXing::Init(Handle<Object> target)
     proto->SetAccessor(String::NewSymbol("tryHarder"), GetTryHarder, SetTryHarder);
     proto->Set(String::NewSymbol("findCode"),
                FunctionTemplate::New(FindCode)->GetFunction());
-    target->Set(String::NewSymbol("ZXing"),
-                Persistent<Function>::New(constructor_template->GetFunction()));
+    target->Set(String::NewSymbol("ZXing"), constructor_template->GetFunction());
 }
 
 Handle<Value> ZXing::New(const Arguments &args)
@@ -284,6 +283,29 @@ Handle<Value> ZXing::FindCode(const Arguments &args)
     }
 }
 
+bool ZXing::Decode(Pix *pix, std::string &format, std::string &text, std::string &error)
+{
+    try {
+        zxing::Ref<PixSource> source(new PixSource(pix));
+        zxing::Ref<zxing::Binarizer> binarizer(new zxing::HybridBinarizer(source));
+        zxing::Ref<zxing::BinaryBitmap> binary(new zxing::BinaryBitmap(binarizer));
+        zxing::Ref<zxing::MultiFormatReader> reader(new zxing::MultiFormatReader);
+        zxing::Ref<zxing::Result> result(reader->decode(binary, zxing::DecodeHints::DEFAULT_HINT));
+        format = zxing::BarcodeFormat::barcodeFormatNames[result->getBarcodeFormat()];
+        text = result->getText()->getText();
+        return true;
+    } catch (const zxing::ReaderException& e) {
+        if (strcmp(e.what(), "No code detected") != 0) {
+            error = e.what();
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    } catch (...) {
+        error = "Uncaught exception";
+    }
+    return false;
+}
+
 ZXing::ZXing()
     : hints_(zxing::DecodeHints::DEFAULT_HINT), reader_(new zxing::MultiFormatReader)
 {
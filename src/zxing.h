@@ -24,6 +24,8 @@
 
 #include <v8.h>
 #include <node.h>
+#include <allheaders.h>
+#include <string>
 #include <zxing/DecodeHints.h>
 #include <zxing/MultiFormatReader.h>
 
@@ -32,6 +34,11 @@ class ZXing : public node::ObjectWrap
 public:
     static void Init(v8::Handle<v8::Object> target);
 
+    // Decodes the first barcode in pix with the default hints; safe to
+    // call on worker threads. Returns false, with an empty error if there
+    // simply is no barcode.
+    static bool Decode(Pix *pix, std::string &format, std::string &text, std::string &error);
+
 private:
     static v8::Handle<v8::Value> New(const v8::Arguments& args);
 
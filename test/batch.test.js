@@ -0,0 +1,38 @@
+global.should = require('chai').should();
+var dv = require('../lib/dv');
+var fs = require('fs');
+
+describe('Batch', function(){
+    it('should #processBatch()', function(done){
+        var buffers = [
+            fs.readFileSync(__dirname + '/fixtures/textpage300.png'),
+            new Buffer('no image'),
+        ];
+        var config = {threshold: [16, 16, 0, 0, 0.1], deskew: true, text: 'plain',
+                      threads: [1, 2, 1]};
+        var results = [];
+        dv.processBatch(buffers, config, function(error, result){
+            results[result.index] = error || result;
+        }, function(){
+            results[0].skew.confidence.should.be.above(0);
+            results[0].text.should.match(/raising article/);
+            results[1].should.be.an.instanceof(Error);
+            done();
+        });
+    })
+    it('should find codes in a batch', function(done){
+        var buffers = [
+            fs.readFileSync(__dirname + '/fixtures/barcode1.png'),
+            fs.readFileSync(__dirname + '/fixtures/textpage300.png'),
+        ];
+        var results = [];
+        dv.processBatch(buffers, {barcode: true, image: true}, function(error, result){
+            results[result.index] = result;
+        }, function(){
+            results[0].code.data.should.equal('1234567890');
+            should.not.exist(results[1].code);
+            results[1].image.width.should.equal(1880);
+            done();
+        });
+    })
+})
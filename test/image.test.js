@@ -71,10 +71,32 @@ describe('Image', function(){
     it('should #rotate()', function(){
         writeImage('gray-rotate.png', this.gray.rotate(-0.703125));
         writeImage('gray-rotate45.png', this.gray.rotate(45));
+        writeImage('gray-rotate-shear.png', this.gray.rotate(-0.703125, 'shear'));
+        var rotated = this.gray.rotate(90);
+        rotated.width.should.equal(this.gray.height);
+        rotated.height.should.equal(this.gray.width);
+        writeImage('gray-rotate90.png', rotated);
+        this.gray.rotate(180).width.should.equal(this.gray.width);
+        var areaMapped = this.gray.rotate(90, 'areamap');
+        areaMapped.width.should.not.be.below(rotated.width);
+        areaMapped.height.should.not.be.below(rotated.height);
+        var rgbRotated = this.rgb.rotate(-0.703125);
+        rgbRotated.width.should.not.be.below(this.rgb.width);
+        rgbRotated.height.should.not.be.below(this.rgb.height);
+        writeImage('rgb-rotate.png', rgbRotated);
     })
     it('should #scale()', function(){
         writeImage('gray-scale2.png', this.gray.scale(2.0, 2.0));
         writeImage('gray-scale05.png', this.gray.scale(0.5));
+        writeImage('rgb-scale025.png', this.rgb.scale(0.25));
+        var grayScaled = this.gray.scale(0.3);
+        grayScaled.width.should.equal(Math.round(this.gray.width * 0.3));
+        grayScaled.height.should.equal(Math.round(this.gray.height * 0.3));
+        writeImage('gray-scale03.png', grayScaled);
+        writeImage('rgb-scale08-06.png', this.rgb.scale(0.8, 0.6));
+        var binaryScaled = this.gray.threshold(128).scale(0.25);
+        binaryScaled.depth.should.equal(8);
+        writeImage('binary-scale025.png', binaryScaled);
     })
     it('should #crop()', function(){
         writeImage('gray-crop.png', this.gray.crop(100, 100, 100, 100));
@@ -95,6 +117,59 @@ describe('Image', function(){
     it('should #dilate()', function(){
         writeImage('gray-dilate.png', this.gray.dilate(3, 3));
     })
+    it('should write into existing images', function(){
+        var binary = this.gray.threshold(128);
+        var other = new dv.Image(binary);
+        var scratch = binary.dilate(3, 3);
+        binary.erode(3, 3, {into: scratch}).should.equal(scratch);
+        scratch.dilate(3, 3, {inPlace: true}).should.equal(scratch);
+        scratch.or(binary, {inPlace: true}).invert({inPlace: true}).should.equal(scratch);
+        other.toBuffer().should.deep.equal(binary.toBuffer());
+        writeImage('gray-morph-into.png', scratch);
+    })
+    it('should reject invalid operands when writing into images', function(){
+        var gray = new dv.Image(this.gray);
+        var binary = this.gray.threshold(128);
+        (function(){ gray.subtract(gray, {inPlace: true}); }).should.throw(/itself/);
+        (function(){ gray.or(binary, {inPlace: true}); }).should.throw(/same size and depth/);
+        (function(){ binary.and(binary.crop(0, 0, 10, 10)); }).should.throw(/same size and depth/);
+        (function(){ binary.erode(0, 0, {inPlace: true}); }).should.throw(/at least 1/);
+        (function(){ binary.dilate(3, 0); }).should.throw(/at least 1/);
+    })
+    it('should #morphSequence()', function(){
+        var binary = this.gray.threshold(128);
+        var image = binary.morphSequence('o5.5 + d3.3 + e22.22');
+        image.width.should.equal(binary.width);
+        image.depth.should.equal(1);
+        writeImage('gray-morph-sequence.png', image);
+        writeImage('gray-gray-morph-sequence.png', this.gray.morphSequence('o5.5 + d3.3'));
+    })
+    it('should run a #pipeline()', function(){
+        var image = this.rgb.pipeline().toGray().convolve(5, 5).threshold(128).erode(3, 3).run();
+        var eager = this.rgb.toGray().convolve(5, 5).threshold(128).erode(3, 3);
+        image.depth.should.equal(1);
+        image.toBuffer().should.deep.equal(eager.toBuffer());
+        writeImage('rgb-pipeline.png', image);
+    })
+    it('should run a #pipeline() on binary images', function(){
+        var binary = this.gray.threshold(128);
+        var curve = new Array(256);
+        for (var i = 0; i < 256; i++)
+            curve[i] = 255 - i / 2;
+        binary.pipeline().toGray().invert().threshold(128).run().toBuffer()
+            .should.deep.equal(binary.toGray().invert().threshold(128).toBuffer());
+        binary.pipeline().invert().toGray().applyCurve(curve).threshold(200).run().toBuffer()
+            .should.deep.equal(binary.invert().toGray().applyCurve(curve).threshold(200).toBuffer());
+        binary.pipeline().invert().run().toBuffer()
+            .should.deep.equal(binary.invert().toBuffer());
+    })
+    it('should filter in tiles', function(){
+        var gray = this.gray.scale(3, 3);
+        gray.convolve(9, 5).toBuffer().should.deep.equal(
+            gray.pipeline().convolve(9, 5).run().toBuffer());
+        gray.erode(7, 3).toBuffer().should.deep.equal(
+            gray.pipeline().erode(7, 3).run().toBuffer());
+    })
     it('should #thin()', function(){
         writeImage('gray-thin.png', this.gray.thin('fg', 4, 3));
     })
@@ -106,6 +181,41 @@ describe('Image', function(){
         skew.angle.should.equal(-0.703125);
         skew.confidence.should.equal(4.957831859588623);
     })
+    it('should #detectOrientation()', function(){
+        var text = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/textpage300.png'));
+        text.detectOrientation().angle.should.equal(0);
+        var orientation = text.rotate(90).detectOrientation(true);
+        orientation.angle.should.equal(270);
+        orientation.confidence.should.be.above(7);
+        orientation.mirrorConfidence.should.be.above(5);
+    })
+    it('should #fingerprint()', function(){
+        var text = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/textpage300.png'));
+        var form = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/formpage300.png'));
+        text.fingerprint().should.match(/^[0-9a-f]{64}$/);
+        text.fingerprint().should.equal(new dv.Image(text).fingerprint());
+        text.fingerprint().should.not.equal(form.fingerprint());
+    })
+    it('should #sauvolaBinarize()', function(){
+        var sauvola = this.gray.sauvolaBinarize(15, 0.35, 4, 4);
+        sauvola.image.depth.should.equal(1);
+        sauvola.image.width.should.equal(this.gray.width);
+        writeImage('gray-sauvola-values.png', sauvola.thresholdValues);
+        writeImage('gray-sauvola-image.png', sauvola.image);
+    })
+    it('should #backgroundNorm() and #backgroundMap()', function(){
+        writeImage('gray-background-norm.png', this.gray.backgroundNorm());
+        writeImage('rgb-background-norm-morph.png', this.rgb.backgroundNorm('morph', 4, 15, 200));
+        var map = this.gray.backgroundMap();
+        writeImage('gray-background-map-applied.png', this.gray.backgroundNorm(map));
+        var rgbMap = this.rgb.backgroundMap('morph', 4, 15, 200);
+        writeImage('rgb-background-map-applied.png', this.rgb.backgroundNorm(rgbMap));
+        var gray = this.gray;
+        var cropped = gray.crop(0, 0, gray.width / 2, gray.height / 2);
+        var zeroTiles = {gray: map.gray, tileWidth: 0, tileHeight: 0};
+        (function(){ cropped.backgroundNorm(map); }).should.throw(/does not match image size/);
+        (function(){ gray.backgroundNorm(zeroTiles); }).should.throw(/at least 1/);
+    })
     it('should #connectedComponents()', function(){
         var binaryImage = this.textpage.otsuAdaptiveThreshold(32, 32, 0, 0, 0.1).image;
         var boxes = binaryImage.connectedComponents(4);
@@ -121,6 +231,20 @@ describe('Image', function(){
         var distanceMap = this.rgb.toGray().distanceFunction(4);
         writeImage('distance-map.png', distanceMap.maxDynamicRange('log'));
     })
+    it('should #edgeFilter() and #edgeDensity()', function(){
+        var edges = this.gray.edgeFilter('vertical');
+        edges.depth.should.equal(8);
+        edges.width.should.equal(this.gray.width);
+        writeImage('gray-edges.png', this.gray.edgeFilter());
+        var density = this.gray.edgeDensity(32, 32, 40, 'all');
+        density.columns.should.equal(Math.ceil(this.gray.width / 32));
+        density.rows.should.equal(Math.ceil(this.gray.height / 32));
+        density.counts.length.should.equal(density.columns * density.rows);
+        density.counts.reduce(function(a, b) { return a + b; }).should.be.above(0);
+        this.gray.edgeDensity(32, 32, 256).counts.forEach(function(count) {
+            count.should.equal(0);
+        });
+    })
     it('should #drawBox()', function(){
         var canvas = new dv.Image(this.gray)
         .drawBox(50, 50, 100, 100, 5)
@@ -128,6 +252,22 @@ describe('Image', function(){
         .drawBox(150, 150, 100, 100, 5, 'flip');
         writeImage('gray-box.png', canvas);
     })
+    it('should copy on write', function(){
+        var buffer = new Buffer(64 * 64);
+        buffer.fill(0);
+        var original = new dv.Image('gray', buffer, 64, 64);
+        var copy = new dv.Image(original).drawBox(8, 8, 16, 16, 2);
+        original.toBuffer()[(8 * 64 + 8) * 3].should.equal(0);
+        copy.toBuffer()[(8 * 64 + 8) * 3].should.equal(255);
+    })
+    it('should #share() and .fromShared()', function(){
+        var name = this.gray.share();
+        var image = dv.Image.fromShared(name);
+        image.toBuffer().should.deep.equal(this.gray.toBuffer());
+        (function(){ dv.Image.fromShared(name); }).should.throw();
+        image.drawBox(0, 0, 8, 8, 2);
+        dv.Image.fromShared(this.gray.share()).toBuffer().should.deep.equal(this.gray.toBuffer());
+    })
     it('should #threshold', function() {
         writeImage('gray-threshold-64.png', this.gray.threshold(64));
         writeImage('gray-threshold-196.png', this.gray.threshold(196));
@@ -0,0 +1,31 @@
+global.should = require('chai').should();
+var dv = require('../lib/dv');
+var fs = require('fs');
+
+describe('ImageStore', function(){
+    before(function(){
+        this.gray = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/textpage300.png'));
+        this.binary = this.gray.threshold(128);
+    })
+    it('should keep pages within the budget', function(){
+        var store = new dv.ImageStore(0);
+        store.add(this.gray).should.equal(0);
+        store.add(this.binary).should.equal(1);
+        store.length.should.equal(2);
+        store.cachedBytes.should.equal(0);
+        store.compressedBytes.should.be.above(0);
+        store.get(0).toBuffer().should.deep.equal(this.gray.toBuffer());
+        store.get(1).toBuffer().should.deep.equal(this.binary.toBuffer());
+    })
+    it('should cache recently used pages', function(){
+        var store = new dv.ImageStore();
+        store.add(this.gray);
+        store.cachedBytes.should.be.above(0);
+        store.budget = 0;
+        store.cachedBytes.should.equal(0);
+        store.set(0, store.get(0).invert());
+        store.get(0).toBuffer().should.deep.equal(this.gray.invert().toBuffer());
+        store.clear();
+        store.length.should.equal(0);
+    })
+})
@@ -0,0 +1,54 @@
+global.should = require('chai').should();
+var dv = require('../lib/dv');
+var fs = require('fs');
+
+describe('Memory', function(){
+    after(function(){
+        // Pooled chunks go back to the pool when their images are
+        // collected, and the pool can only be removed once all are back.
+        if (global.gc) {
+            gc();
+        }
+        dv.setMemoryPool();
+    })
+    it('should have no pool by default', function(){
+        should.not.exist(dv.memoryPoolStats());
+    })
+    it('should #setMemoryPool()', function(){
+        dv.setMemoryPool(256 * 1024, 1024 * 1024, [4, 4, 2]);
+        var image = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/textpage300.png'));
+        image.threshold(128).dilate(3, 3).erode(3, 3);
+        var stats = dv.memoryPoolStats();
+        stats.size.should.equal((4 * 1 + 4 * 2 + 2 * 4) * 1024 * 1024);
+        stats.levels.length.should.equal(3);
+        stats.levels[0].size.should.equal(1024 * 1024);
+        stats.levels[2].count.should.equal(2);
+        (stats.levels[0].used + stats.levels[1].used + stats.levels[2].used).should.be.above(0);
+    })
+    it('should #memoryStats()', function(){
+        var image = new dv.Image('rgba', new Buffer(100 * 40 * 4), 100, 40);
+        var stats = dv.memoryStats();
+        stats.count.should.be.above(0);
+        stats.depths[32].bytes.should.not.be.below(100 * 40 * 4);
+        stats.peakBytes.should.not.be.below(stats.bytes);
+    })
+    it('should account pixels shared with #Tesseract once', function(){
+        var image = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/textpage300.png'));
+        var tesseract = new dv.Tesseract();
+        tesseract.image = image;
+        var before = dv.memoryStats();
+        // Tesseract keeps a reference of its own, so this copies the pixels.
+        image.drawBox(10, 10, 20, 20, 2);
+        dv.memoryStats().bytes.should.not.be.above(before.bytes);
+    })
+    it('should remove unmapped shared images with their source', function(){
+        if (!global.gc) {
+            return;
+        }
+        var name = (function(){
+            return new dv.Image('gray', new Buffer(64 * 64), 64, 64).share();
+        })();
+        gc();
+        (function(){ dv.Image.fromShared(name); }).should.throw(/no such shared image/);
+    })
+})
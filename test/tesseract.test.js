@@ -74,4 +74,59 @@ describe('Tesseract', function(){
             paragraph.should.equal(textParagraph, 'Paragraph ' + i);
         }
     })
+    it('should recognize #findWords() like the reference classifier', function(){
+        var tesseract = new dv.Tesseract('deu', this.textPage300);
+        var expected = JSON.parse(fs.readFileSync(__dirname + '/fixtures/textpage300-words.json'));
+        tesseract.findWords().should.deep.equal(expected);
+    })
+    it('should select #engineMode', function(){
+        this.tesseract.engineMode.should.equal('default');
+        var tesseract = new dv.Tesseract('deu', this.textPage300, 'tesseract_only');
+        tesseract.engineMode.should.equal('tesseract_only');
+        var expected = JSON.parse(fs.readFileSync(__dirname + '/fixtures/textpage300-words.json'));
+        tesseract.findWords().should.deep.equal(expected);
+        (function(){ new dv.Tesseract('deu', null, 'fastest'); }).should.throw(TypeError);
+        var image = this.textPage300;
+        (function(){ new dv.Tesseract('deu', image, 'cube_only'); }).should.throw(Error, /initializing/);
+    })
+    it('should classify words on several #threads', function(){
+        var tesseract = new dv.Tesseract('deu', this.textPage300);
+        tesseract.threads.should.equal(1);
+        tesseract.threads = 4;
+        tesseract.threads.should.equal(4);
+        tesseract.findText('plain').should.match(/raising article general norland/);
+        (function(){ tesseract.threads = 0; }).should.throw(TypeError);
+    })
+    it('should warm start from #saveAdaptation()', function(){
+        var tesseract = new dv.Tesseract('deu', this.textPage300);
+        tesseract.findText('plain');
+        var adaptation = tesseract.saveAdaptation();
+        Buffer.isBuffer(adaptation).should.equal(true);
+        var warm = new dv.Tesseract('deu', this.textPage300);
+        warm.loadAdaptation(adaptation).should.equal(warm);
+        warm.findText('plain').should.equal(tesseract.findText('plain'));
+        (function(){ warm.loadAdaptation(new Buffer('garbage')); }).should.throw(Error);
+    })
+    it('should reject truncated buffers in #loadAdaptation()', function(){
+        var tesseract = new dv.Tesseract('deu', this.textPage300);
+        tesseract.findText('plain');
+        var adaptation = tesseract.saveAdaptation();
+        [16, adaptation.length >> 1, adaptation.length - 1].forEach(function(length) {
+            (function(){ tesseract.loadAdaptation(adaptation.slice(0, length)); }).should.throw(Error);
+        });
+        tesseract.loadAdaptation(adaptation).should.equal(tesseract);
+    })
+    it('should reuse results of duplicate pages from #cache', function(){
+        var tesseract = new dv.Tesseract();
+        tesseract.cache = new dv.OcrCache();
+        tesseract.image = this.textPage300;
+        var text = tesseract.findText('plain');
+        tesseract.image = this.textPage300.threshold(128);
+        tesseract.findText('plain').should.equal(text);
+        tesseract.cache.hits.should.equal(1);
+        tesseract.image = new dv.Image('png', fs.readFileSync(__dirname + '/fixtures/formpage300.png'));
+        tesseract.findText('plain');
+        tesseract.cache.hits.should.equal(1);
+        tesseract.cache.length.should.equal(2);
+    })
 })